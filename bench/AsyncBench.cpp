@@ -0,0 +1,158 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "AsyncTempoClient.hpp"
+#include "TempoClient.hpp"
+#include "MockInstrument.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @struct BenchResult
+ * @brief Throughput and thread use of one API while polling many instruments.
+ */
+struct BenchResult {
+    int64_t requests = 0;       ///< Number of status calls that returned 200.
+    int64_t failures = 0;       ///< Number of status calls that failed.
+    double seconds = 0;         ///< Wall clock time of the measurement.
+    int64_t clientThreads = 0;  ///< Threads added by the client while polling.
+};
+
+/// Returns the number of threads in this process.
+static int64_t threadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return std::stoll(line.substr(8));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Polls status for every instrument with the blocking TempoClient, one thread per instrument.
+ */
+static BenchResult blocking(const std::string& host, size_t instruments, Clock::duration duration) {
+    BenchResult result;
+    std::atomic<int64_t> requests{0};
+    std::atomic<int64_t> failures{0};
+    auto baseline = threadCount();
+    auto start = Clock::now();
+    auto end = start + duration;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < instruments; ++i) {
+        threads.emplace_back([&]() {
+            TempoClient tempoClient(host, "password", 10);
+            while (Clock::now() < end) {
+                tempoClient.status();
+                tempoClient.statusOK() ? ++requests : ++failures;
+            }
+        });
+    }
+    std::this_thread::sleep_for(duration / 2);
+    result.clientThreads = threadCount() - baseline;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.requests = requests;
+    result.failures = failures;
+    return result;
+}
+
+/**
+ * @brief Polls status for every instrument with AsyncTempoClient, all on one EventLoop thread.
+ */
+static BenchResult async(const std::string& host, size_t instruments, Clock::duration duration) {
+    BenchResult result;
+    std::atomic<int64_t> requests{0};
+    std::atomic<int64_t> failures{0};
+    std::atomic<int64_t> inFlight{0};
+    auto baseline = threadCount();
+
+    EventLoop loop;
+    loop.start();
+    std::vector<std::unique_ptr<AsyncTempoClient>> clients;
+    for (size_t i = 0; i < instruments; ++i) {
+        clients.push_back(std::make_unique<AsyncTempoClient>(loop, host, "password", 10));
+    }
+
+    auto start = Clock::now();
+    auto end = start + duration;
+    // each instrument sends its next poll as soon as the last one completes
+    std::function<void(AsyncTempoClient*)> poll = [&](AsyncTempoClient* client) {
+        ++inFlight;
+        client->status([&, client](const AsyncResult& response) {
+            response.ok() ? ++requests : ++failures;
+            if (Clock::now() < end) {
+                poll(client);
+            }
+            --inFlight;
+        });
+    };
+    for (auto& client : clients) {
+        poll(client.get());
+    }
+    std::this_thread::sleep_for(duration / 2);
+    result.clientThreads = threadCount() - baseline;
+    std::this_thread::sleep_until(end);
+    while (inFlight > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    clients.clear();
+    loop.stop();
+    result.requests = requests;
+    result.failures = failures;
+    return result;
+}
+
+/// Prints one result as a line of JSON.
+static void print(const std::string& api, size_t instruments, int64_t latency, const BenchResult& result) {
+    json line;
+    line["benchmark"] = "concurrentStatus";
+    line["api"] = api;
+    line["instruments"] = instruments;
+    line["latencyMs"] = latency;
+    line["requests"] = result.requests;
+    line["failures"] = result.failures;
+    line["seconds"] = result.seconds;
+    line["requestsPerSecond"] = static_cast<double>(result.requests) / result.seconds;
+    line["clientThreads"] = result.clientThreads;
+    std::cout << line.dump() << std::endl;
+}
+
+/**
+ * @brief Compares the blocking and the async API polling many instruments at once.
+ *
+ * Usage: tempoclient_async_bench [instruments] [seconds] [latencyMs]
+ *
+ * Every instrument is the same MockInstrument, which delays each response by latencyMs to stand
+ * in for the instrument's own response time. The output is one JSON object per line.
+ */
+int main(int argc, char** argv) {
+    size_t instruments = argc > 1 ? std::stoul(argv[1]) : 200;
+    auto seconds = argc > 2 ? std::stoll(argv[2]) : 5;
+    auto latency = argc > 3 ? std::stoll(argv[3]) : 20;
+
+    MockInstrument instrument(100, std::chrono::milliseconds(latency));
+    print("blocking", instruments, latency, blocking(instrument.host(), instruments, std::chrono::seconds(seconds)));
+    print("async", instruments, latency, async(instrument.host(), instruments, std::chrono::seconds(seconds)));
+    return 0;
+}
@@ -0,0 +1,144 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "Router.hpp"
+#include "PollingPolicy.hpp"
+#include "TempoClient.hpp"
+#include "MockInstrument.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+/**
+ * @class NullBuffer
+ * @brief Stream buffer that discards everything, so command output does not fill the results.
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+/**
+ * @brief Runs a command line the way main does, from making the Router to the exit code, with its output discarded.
+ * @return Exit code of the command.
+ */
+static int command(const std::vector<std::string>& args) {
+    NullBuffer discard;
+    auto* stdoutBuffer = std::cout.rdbuf(&discard);
+    std::vector<std::string> reversed(args.rbegin(), args.rend());
+    Router router;
+    router.initialize();
+    router.tempoCli().parse(reversed);
+    int exitCode = router.run();
+    std::cout.rdbuf(stdoutBuffer);
+    return exitCode;
+}
+
+/// Prints the result of a check as a line of JSON, and the reason to the error stream if it failed.
+static bool report(const std::string& name, bool passed, const std::string& reason) {
+    if (!passed) {
+        std::cerr << "Error. The " << name << " check failed: " << reason << std::endl;
+    }
+    std::cout << json{{"check", name}, {"passed", passed}}.dump() << std::endl;
+    return passed;
+}
+
+/**
+ * @brief Checks that a request on a reused connection that times out is not sent again.
+ *
+ * A retry would ask a slow instrument the same question a second time and double the wait.
+ */
+static bool slowResponseNotRetried() {
+    MockInstrument instrument;
+    TempoClient tempoClient(instrument.host(), "password", 1);
+    tempoClient.status();
+    instrument.setLatency(std::chrono::milliseconds(1500));
+    auto before = instrument.arrivals();
+    tempoClient.status();
+    auto sent = instrument.arrivals() - before;
+    return report("slowResponseNotRetried",
+                  tempoClient.error() == httplib::Error::Read && sent == 1 && tempoClient.connections().reconnects == 0,
+                  "the request was sent " + std::to_string(sent) + " times");
+}
+
+/**
+ * @brief Checks that a cached report whose object was damaged is fetched again and its object repaired.
+ *
+ * The damaged object still parses as JSON, so only its hash shows that it is not the report.
+ */
+static bool damagedReportRepaired() {
+    MockInstrument instrument(10);
+    std::string host = instrument.host();
+    std::string id = MockInstrument::reportId(0);
+    int synced = command({"--host", host, "reports", "--sync", "--cacheDir", "cache"});
+    std::error_code error;
+    for (const auto& object : std::filesystem::recursive_directory_iterator("cache", error)) {
+        if (object.is_regular_file() && object.path().parent_path().filename() == "objects") {
+            std::ofstream(object.path(), std::ios::out | std::ios::trunc) << "{}";
+        }
+    }
+    int fetched = command({"--host", host, "reports", "--id", id, "--cacheDir", "cache"});
+    auto body = ReportCache("cache", host).report(id);
+    return report("damagedReportRepaired",
+                  synced == 0 && fetched == 0 && body == MockInstrument::report(id).dump(),
+                  body ? "the object holds the wrong report" : "the object was not replaced");
+}
+
+/**
+ * @brief Checks that a long hold early in a step is polled slowly.
+ *
+ * The step's stepTime counts up from the start of the step, so a small stepTime does not mean a
+ * change is near.
+ */
+static bool longHoldPolledSlowly() {
+    PollingPolicy policy(std::chrono::seconds(1), std::chrono::seconds(60), 0, true);
+    json response = MockInstrument::run();
+    response["protocolRun"]["step"]["stepTime"] = 2;
+    response["protocolRun"]["time"] = {{"elapsed", 2}, {"hold", 600}, {"remaining", 600}, {"totalRemaining", 3600}};
+    auto interval = policy.next(response);
+    return report("longHoldPolledSlowly", interval == std::chrono::seconds(60),
+                  "the interval was " + std::to_string(interval.count()) + " ms instead of 60000 ms");
+}
+
+/**
+ * @brief Checks behavior that a benchmark would not notice if it broke.
+ *
+ * Usage: tempoclient_checks
+ *
+ * Each check prints a line of JSON with its name and whether it passed. The program exits with 1
+ * if any check failed, so it can guard the behavior in a build. The checks run in a directory of
+ * their own under the temporary directory, which is removed at the end.
+ */
+int main() {
+    // a directory of its own, so a config.json or cache in the current directory does not change the results
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tempoclient_checks";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::filesystem::current_path(directory);
+
+    bool passed = slowResponseNotRetried();
+    passed = damagedReportRepaired() && passed;
+    passed = longHoldPolledSlowly() && passed;
+
+    std::filesystem::current_path(directory.parent_path());
+    std::filesystem::remove_all(directory);
+    return passed ? 0 : 1;
+}
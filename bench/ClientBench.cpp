@@ -0,0 +1,225 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "Router.hpp"
+#include "LatencyHistogram.hpp"
+#include "MockInstrument.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @class NullBuffer
+ * @brief Stream buffer that discards everything, so command output does not time the terminal.
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+/// Prints one result as a line of JSON on the real stdout.
+static void print(std::ostream& out, json line) {
+    out << line.dump() << std::endl;
+}
+
+/**
+ * @brief Runs a function the given number of times and returns the average time in nanoseconds.
+ * @param run Function that does the work once and returns a value read from the result, so the
+ *  work is not optimized away.
+ */
+template<typename Run>
+static double measure(int64_t iterations, Run run) {
+    size_t check = 0;
+    auto start = Clock::now();
+    for (int64_t i = 0; i < iterations; ++i) {
+        check += run();
+    }
+    auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (check == 0) {
+        std::cerr << "No results." << std::endl;
+    }
+    return seconds * 1e9 / static_cast<double>(iterations);
+}
+
+/**
+ * @brief Times the client's own work on a response: building the output and the text display.
+ * @param out Stream for the results.
+ * @param instrument Mock instrument that serves the response.
+ * @param payload Name of the response in the results.
+ * @param request Makes the request for the response.
+ */
+template<typename Request>
+static void microbenchmarks(std::ostream& out, const MockInstrument& instrument, int64_t iterations,
+                            const std::string& payload, Request request) {
+    TempoClient tempoClient(instrument.host(), "password", 30);
+    request(tempoClient);
+    if (!tempoClient.statusOK()) {
+        std::cerr << "No response for " << payload << "." << std::endl;
+        return;
+    }
+    std::string body = json::parse(tempoClient.body()).dump(2);
+
+    for (const char* display : {"json", "text"}) {
+        print(out, {{"benchmark", "responseString"}, {"payload", payload}, {"display", display}, {"bytes", body.size()},
+                    {"nanoseconds", measure(iterations, [&tempoClient, display]() {
+                        std::string result;
+                        tempoClient.responseString(result, display);
+                        return result.size();
+                    })}});
+    }
+    // both formatters change the string in place, so each iteration formats a fresh copy
+    print(out, {{"benchmark", "formatText"}, {"payload", payload}, {"implementation", "TempoClient"}, {"bytes", body.size()},
+                {"nanoseconds", measure(iterations, [&body]() {
+                    std::string text = body;
+                    return TempoClient::formatResponseForTextDisplay(text).size();
+                })}});
+    print(out, {{"benchmark", "formatText"}, {"payload", payload}, {"implementation", "Config"}, {"bytes", body.size()},
+                {"nanoseconds", measure(iterations, [&body]() {
+                    std::string text = body;
+                    return Config::formatResponseForTextDisplay(text).size();
+                })}});
+    print(out, {{"benchmark", "formatText"}, {"payload", payload}, {"implementation", "copy"}, {"bytes", body.size()},
+                {"nanoseconds", measure(iterations, [&body]() {
+                    std::string text = body;
+                    return text.size();
+                })}});
+}
+
+/**
+ * @brief Runs a command line the way main does, from making the Router to the exit code.
+ * @return Exit code of the command.
+ */
+static int command(const std::vector<std::string>& args) {
+    std::vector<std::string> reversed(args.rbegin(), args.rend());
+    Router router;
+    router.initialize();
+    router.tempoCli().parse(reversed);
+    return router.run();
+}
+
+/**
+ * @brief Times a command end to end against the mock instrument, with its output discarded.
+ * @param out Stream for the results.
+ * @param name Name of the command in the results.
+ * @param args Arguments after the program name.
+ */
+static void endToEnd(std::ostream& out, int64_t iterations, const std::string& name, const std::vector<std::string>& args) {
+    LatencyHistogram histogram;
+    NullBuffer discard;
+    auto* stdoutBuffer = std::cout.rdbuf(&discard);
+    int exitCode = 0;
+    for (int64_t i = 0; i < iterations && exitCode == 0; ++i) {
+        auto start = Clock::now();
+        exitCode = command(args);
+        histogram.record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    }
+    std::cout.rdbuf(stdoutBuffer);
+    if (exitCode != 0) {
+        std::cerr << "The " << name << " command failed with exit code " << exitCode << "." << std::endl;
+        return;
+    }
+    print(out, {{"benchmark", "command"}, {"command", name}, {"iterations", histogram.count()},
+                {"meanMicroseconds", histogram.mean()}, {"p50Microseconds", histogram.percentile(0.5)},
+                {"p99Microseconds", histogram.percentile(0.99)}, {"maxMicroseconds", histogram.max()}});
+}
+
+/**
+ * @brief Microbenchmarks of the output, text display, config and command line handling, and end
+ * to end timings of each command against an in-process mock instrument.
+ *
+ * Usage: tempoclient_bench [iterations] [reports]
+ *
+ * The reports argument sets the length of the run report list, 10000 by default. The program
+ * works in a directory of its own under the temp directory, so a config.json in the current
+ * directory does not change the results. The output is one JSON object per line.
+ */
+int main(int argc, char** argv) {
+    int64_t iterations = argc > 1 ? std::stoll(argv[1]) : 200;
+    size_t reportCount = argc > 2 ? std::stoul(argv[2]) : 10000;
+    // large lists take much longer per iteration
+    int64_t listIterations = std::max<int64_t>(iterations / 20, 3);
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tempoclient_bench";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::filesystem::current_path(directory);
+    std::ostream& out = std::cout;
+
+    MockInstrument instrument(reportCount);
+
+    microbenchmarks(out, instrument, iterations * 50, "status", [](TempoClient& tempoClient) { tempoClient.status(); });
+    microbenchmarks(out, instrument, iterations * 50, "run", [](TempoClient& tempoClient) { tempoClient.run(); });
+    microbenchmarks(out, instrument, listIterations, "reports", [](TempoClient& tempoClient) { tempoClient.reports(); });
+
+    std::ofstream("config.json") << json{{"host", instrument.host()}, {"password", "password"},
+                                         {"waitTime", 30}, {"interval", 1}, {"display", "json"}}.dump(2);
+    print(out, {{"benchmark", "configInitialize"}, {"nanoseconds", measure(iterations * 50, []() {
+        Config config;
+        Settings settings;
+        config.initialize(settings);
+        return settings.host.size();
+    })}});
+
+    print(out, {{"benchmark", "routerSetup"}, {"nanoseconds", measure(iterations * 5, []() {
+        Router router;
+        router.initialize();
+        return router.tempoCli().get_description().size();
+    })}});
+    Router router;
+    router.initialize();
+    std::vector<std::string> reversed = {"2", "--interval", "--monitor", "status"};
+    print(out, {{"benchmark", "routerParse"}, {"nanoseconds", measure(iterations * 50, [&router, &reversed]() {
+        router.tempoCli().clear();
+        auto args = reversed;
+        router.tempoCli().parse(args);
+        return router.tempoCli().get_subcommands().size();
+    })}});
+
+    std::string host = instrument.host();
+    endToEnd(out, iterations, "tempo", {"--host", host});
+    endToEnd(out, iterations, "lid", {"--host", host, "lid"});
+    endToEnd(out, iterations, "open", {"--host", host, "open"});
+    endToEnd(out, iterations, "close", {"--host", host, "close"});
+    endToEnd(out, iterations, "status", {"--host", host, "status"});
+    endToEnd(out, iterations, "status --display text", {"--host", host, "--display", "text", "status"});
+    endToEnd(out, iterations, "errors", {"--host", host, "errors"});
+    endToEnd(out, iterations, "errors --clear", {"--host", host, "errors", "--clear"});
+    endToEnd(out, iterations, "protocols", {"--host", host, "protocols"});
+    endToEnd(out, iterations, "run", {"--host", host, "run"});
+    endToEnd(out, iterations, "run --protocol", {"--host", host, "run", "--protocol", "STD2-short"});
+    endToEnd(out, iterations, "stop", {"--host", host, "stop"});
+    endToEnd(out, iterations, "skip", {"--host", host, "skip"});
+    endToEnd(out, iterations, "pause", {"--host", host, "pause"});
+    endToEnd(out, iterations, "resume", {"--host", host, "resume"});
+    endToEnd(out, iterations, "version", {"--host", host, "version"});
+    endToEnd(out, iterations, "reports --count", {"--host", host, "reports", "--count"});
+    endToEnd(out, iterations, "reports --limit 10", {"--host", host, "reports", "--limit", "10"});
+    endToEnd(out, iterations, "reports --id", {"--host", host, "reports", "--id", MockInstrument::reportId(1)});
+    endToEnd(out, listIterations, "reports", {"--host", host, "reports"});
+    endToEnd(out, listIterations, "reports --display text", {"--host", host, "--display", "text", "reports"});
+    endToEnd(out, listIterations, "reports --stream", {"--host", host, "reports", "--stream"});
+
+    std::filesystem::current_path(directory.parent_path());
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,85 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "TempoClient.hpp"
+#include "MockInstrument.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Fetches the full report list and some reports, and prints the bytes on the wire and the time.
+ * @param instrument Server that counts the body bytes it sends.
+ * @param compressed True to accept compressed responses.
+ * @param iterations Number of times the list and the reports are fetched.
+ * @param megabitsPerSecond Link speed used to estimate the time on a slow network.
+ */
+static void measure(MockInstrument& instrument, bool compressed, int64_t iterations, double megabitsPerSecond) {
+    TempoClient tempoClient(instrument.host(), "password", 30);
+    tempoClient.compression(compressed);
+
+    int64_t bodyBytes = 0;
+    int64_t failures = 0;
+    auto startBytes = instrument.bytesSent();
+    auto start = Clock::now();
+    for (int64_t i = 0; i < iterations; ++i) {
+        for (size_t index = 0; index <= 10; ++index) {
+            // the full list first, then ten single reports
+            if (index == 0) {
+                tempoClient.reports();
+            } else {
+                tempoClient.reports(MockInstrument::reportId(index - 1));
+            }
+            if (tempoClient.statusOK()) {
+                bodyBytes += static_cast<int64_t>(tempoClient.body().size());
+            } else {
+                ++failures;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    int64_t wireBytes = instrument.bytesSent() - startBytes;
+
+    json line;
+    line["benchmark"] = "reportsCompression";
+    line["encoding"] = compressed ? "gzip" : "identity";
+    line["iterations"] = iterations;
+    line["failures"] = failures;
+    line["bodyBytes"] = bodyBytes;
+    line["wireBytes"] = wireBytes;
+    line["ratio"] = wireBytes > 0 ? static_cast<double>(bodyBytes) / static_cast<double>(wireBytes) : 0;
+    line["seconds"] = seconds;
+    line["megabitsPerSecond"] = megabitsPerSecond;
+    line["estimatedSeconds"] = seconds + static_cast<double>(wireBytes) * 8 / (megabitsPerSecond * 1e6);
+    std::cout << line.dump() << std::endl;
+}
+
+/**
+ * @brief Compares fetching run reports with and without compression.
+ *
+ * Usage: tempoclient_compression_bench [reports] [iterations] [megabitsPerSecond]
+ *
+ * Each iteration fetches the full list of reports and ten single reports. The seconds are
+ * measured on the loopback interface; estimatedSeconds adds the time to send the bytes on the
+ * wire over a link of the given speed, to stand in for a slow lab network.
+ */
+int main(int argc, char** argv) {
+    size_t reports = argc > 1 ? std::stoul(argv[1]) : 1000;
+    auto iterations = argc > 2 ? std::stoll(argv[2]) : 20;
+    double megabitsPerSecond = argc > 3 ? std::stod(argv[3]) : 10;
+
+    MockInstrument instrument(reports);
+    measure(instrument, false, iterations, megabitsPerSecond);
+    measure(instrument, true, iterations, megabitsPerSecond);
+    return 0;
+}
@@ -0,0 +1,137 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+// GCC reports the malloc in the counting operator new below as mismatched with every delete
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+#include "TypedResponses.hpp"
+#include "MockInstrument.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+/// Number of calls to operator new since the program started.
+static std::atomic<int64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+/**
+ * @struct DecodeResult
+ * @brief Cost of decoding one response body many times.
+ */
+struct DecodeResult {
+    double nanoseconds = 0;  ///< Average time per decode.
+    double allocations = 0;  ///< Average number of allocations per decode.
+};
+
+/**
+ * @brief Runs decode the given number of times and measures the average cost.
+ * @param decode Function that decodes the body once and returns a value read from it.
+ */
+template<typename Decode>
+static DecodeResult measure(int64_t iterations, Decode decode) {
+    size_t check = 0;
+    auto startAllocations = allocations.load();
+    auto start = Clock::now();
+    for (int64_t i = 0; i < iterations; ++i) {
+        check += decode();
+    }
+    auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    DecodeResult result;
+    result.nanoseconds = seconds * 1e9 / static_cast<double>(iterations);
+    result.allocations = static_cast<double>(allocations - startAllocations) / static_cast<double>(iterations);
+    if (check == 0) {
+        std::cerr << "No values decoded." << std::endl;
+    }
+    return result;
+}
+
+/// Prints one result as a line of JSON.
+static void print(const std::string& response, const std::string& decoder, const DecodeResult& result) {
+    json line;
+    line["benchmark"] = "decode";
+    line["response"] = response;
+    line["decoder"] = decoder;
+    line["nanoseconds"] = result.nanoseconds;
+    line["allocations"] = result.allocations;
+    std::cout << line.dump() << std::endl;
+}
+
+/**
+ * @brief Compares decoding the status, lid and run responses into a DOM with json::parse and
+ * into typed structs with TypedDecoder.
+ *
+ * Usage: tempoclient_decode_bench [iterations]
+ *
+ * Each decode reads the fields the monitor uses, so both decoders do the same work. The output
+ * is one JSON object per line with the average time and the average number of allocations.
+ */
+int main(int argc, char** argv) {
+    int64_t iterations = argc > 1 ? std::stoll(argv[1]) : 200000;
+
+    std::string status = MockInstrument::status().dump();
+    print("status", "dom", measure(iterations, [&status]() {
+        json response = json::parse(status);
+        std::string value = response["status"];
+        return value.size() + response["protocolTimeRemaining"].get<size_t>();
+    }));
+    print("status", "typed", measure(iterations, [&status]() {
+        StatusResponse response;
+        decode(status, response);
+        return response.status->size() + static_cast<size_t>(*response.protocolTimeRemaining);
+    }));
+
+    std::string lid = MockInstrument::lid().dump();
+    print("lid", "dom", measure(iterations, [&lid]() {
+        json response = json::parse(lid);
+        std::string value = response["lid"];
+        return value.size();
+    }));
+    print("lid", "typed", measure(iterations, [&lid]() {
+        LidResponse response;
+        decode(lid, response);
+        return response.lid->size();
+    }));
+
+    std::string run = MockInstrument::run().dump();
+    print("run", "dom", measure(iterations, [&run]() {
+        json response = json::parse(run);
+        std::string value = response["status"];
+        return value.size() + response["protocolRun"]["time"]["totalRemaining"].get<size_t>();
+    }));
+    print("run", "typed", measure(iterations, [&run]() {
+        RunResponse response;
+        decode(run, response);
+        return response.status->size() + static_cast<size_t>(*response.protocolRun->time->totalRemaining);
+    }));
+    return 0;
+}
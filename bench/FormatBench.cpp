@@ -0,0 +1,131 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "TextFormatter.hpp"
+#include "MockInstrument.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Text display as TempoClient formatted it before TextFormatter: a string stream,
+ * getline for each line, and an erase of the removed characters from each line.
+ *
+ * Kept here to check that TextFormatter gives the same bytes, and to time it against.
+ */
+static std::string& lineByLine(std::string& res) {
+    std::istringstream stream(res);
+    std::ostringstream result;
+    std::string line;
+    bool lastBlank = false;
+    int16_t lastIndent = 0;
+    while (std::getline(stream, line)) {
+        auto pos = line.find_first_not_of(' ');
+        int isBlank = (line[pos] == '{' || line[pos] == '}' || line[pos] == ']');
+
+        if (!isBlank) {
+            const std::string notPrint = "[{\",";
+            line.erase(remove_if(line.begin(), line.end(), [&notPrint](const char& c) {
+                return notPrint.find(c) != std::string::npos;
+            }), line.end());
+
+            if (lastBlank && lastIndent == static_cast<int16_t>(pos)) {
+                result << std::endl;
+            }
+            lastIndent = static_cast<int16_t>(pos);
+            result << line << std::endl;
+        }
+        lastBlank = isBlank;
+    }
+    res = result.str();
+    return res;
+}
+
+/**
+ * @brief Runs a function the given number of times and returns the throughput in megabytes per second.
+ * @param run Function that formats the payload once and returns the output size.
+ */
+template<typename Run>
+static double megabytesPerSecond(int64_t iterations, size_t bytes, Run run) {
+    size_t check = 0;
+    auto start = Clock::now();
+    for (int64_t i = 0; i < iterations; ++i) {
+        check += run();
+    }
+    auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (check == 0) {
+        std::cerr << "No output." << std::endl;
+    }
+    return std::round(static_cast<double>(bytes) * static_cast<double>(iterations) / seconds / 1e5) / 10;
+}
+
+/// Times the old and new text display of a payload and checks that they give the same bytes.
+static bool compare(const std::string& name, const json& payload, int64_t iterations) {
+    std::string dumped = payload.dump(2);
+    std::string expected = dumped;
+    lineByLine(expected);
+    std::string actual;
+    TextFormatter::format(dumped, actual);
+    bool identical = actual == expected;
+    if (!identical) {
+        std::cerr << "The text display of " << name << " differs from the line by line version." << std::endl;
+    }
+
+    std::string buffer;
+    json line = {{"benchmark", "textDisplay"}, {"payload", name}, {"bytes", dumped.size()}, {"identical", identical},
+                 {"lineByLineMBps", megabytesPerSecond(iterations, dumped.size(), [&dumped]() {
+                     std::string text = dumped;
+                     return lineByLine(text).size();
+                 })},
+                 {"textFormatterMBps", megabytesPerSecond(iterations, dumped.size(), [&dumped, &buffer]() {
+                     TextFormatter::format(dumped, buffer);
+                     return buffer.size();
+                 })},
+                 {"inPlaceMBps", megabytesPerSecond(iterations, dumped.size(), [&dumped]() {
+                     // the copy stands in for the dump that every caller formats in place
+                     std::string text = dumped;
+                     return TextFormatter::format(text).size();
+                 })}};
+    std::cout << line.dump() << std::endl;
+    return identical;
+}
+
+/**
+ * @brief Compares the text display of TextFormatter with the line by line version it replaced,
+ * on run report lists and full run reports of several megabytes.
+ *
+ * Usage: tempoclient_format_bench [iterations]
+ *
+ * Each line of output gives the payload size, whether the outputs are the same, and the
+ * megabytes per second of the line by line version, TextFormatter into a kept buffer, and
+ * TextFormatter in place on a fresh copy as TempoClient uses it. The exit code is 1 if any
+ * output differs.
+ */
+int main(int argc, char** argv) {
+    int64_t iterations = argc > 1 ? std::stoll(argv[1]) : 10;
+    bool identical = true;
+    for (size_t count : {1000, 10000, 50000}) {
+        identical = compare("reports" + std::to_string(count), MockInstrument::reports(count, 0), iterations) && identical;
+    }
+    json reports = json::array();
+    for (size_t i = 0; i < 100; ++i) {
+        reports.push_back(MockInstrument::report(MockInstrument::reportId(i)));
+    }
+    identical = compare("fullReports100", json{{"reports", reports}}, iterations) && identical;
+    identical = compare("run", MockInstrument::run(), iterations * 10000) && identical;
+    return identical ? 0 : 1;
+}
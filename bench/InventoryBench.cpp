@@ -0,0 +1,117 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "Inventory.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+/// Writes an inventory of the given number of instruments in labs of 20, rooms of 100 and four assays.
+static void writeInventory(const std::string& path, size_t count) {
+    json instruments = json::array();
+    for (size_t i = 0; i < count; ++i) {
+        instruments.push_back({{"name", "cycler" + std::to_string(i)},
+                               {"host", "http://10." + std::to_string(i / 65536 % 256) + "." + std::to_string(i / 256 % 256) + "."
+                                        + std::to_string(i % 256) + ":8080"},
+                               {"groups", {"lab" + std::to_string(i / 20), "room" + std::to_string(i / 100)}},
+                               {"tags", {"assay" + std::to_string(i % 4)}}});
+    }
+    std::ofstream(path) << json{{"instruments", instruments}}.dump(2);
+}
+
+/**
+ * @brief Runs a lookup the given number of times and returns the average time in microseconds.
+ * @param lookup Function that finds one instrument and returns the length of its host.
+ */
+template<typename Lookup>
+static double microseconds(int64_t iterations, Lookup lookup) {
+    size_t check = 0;
+    auto start = Clock::now();
+    for (int64_t i = 0; i < iterations; ++i) {
+        check += lookup(i);
+    }
+    auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (check == 0) {
+        std::cerr << "Nothing found." << std::endl;
+    }
+    return std::round(elapsed / static_cast<double>(iterations) * 100) / 100;
+}
+
+/**
+ * @brief Compares the cost of finding an instrument by name once per command, as a command line
+ * process does, by parsing the JSON inventory and by opening its compiled index.
+ *
+ * Usage: tempoclient_inventory_bench [iterations]
+ *
+ * For inventories of 10, 1000 and 100000 instruments, each line of output gives the size of
+ * the JSON and the index, the time to compile the index, and the average microseconds to find
+ * one instrument and its group from scratch: reading and parsing the JSON, and opening and
+ * probing the index. The index lookup stays about the same as the inventory grows.
+ */
+int main(int argc, char** argv) {
+    int64_t iterations = argc > 1 ? std::stoll(argv[1]) : 20;
+    auto directory = std::filesystem::temp_directory_path() / "tempoclient_inventory_bench";
+    std::filesystem::create_directories(directory);
+    std::string source = (directory / "inventory.json").string();
+    std::string index = (directory / "inventory.idx").string();
+
+    for (size_t count : {10, 1000, 100000}) {
+        writeInventory(source, count);
+        std::filesystem::remove(index);
+        auto start = Clock::now();
+        if (!Inventory::compile(source, index)) {
+            return 1;
+        }
+        double compileMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        auto name = [count](int64_t i) {
+            return "cycler" + std::to_string(static_cast<size_t>(i) * 7919 % count);
+        };
+        double parseMicros = microseconds(iterations, [&](int64_t i) {
+            std::ifstream in(source);
+            std::stringstream text;
+            text << in.rdbuf();
+            json inventory = json::parse(text.str());
+            std::string wanted = name(i);
+            for (const auto& entry : inventory["instruments"]) {
+                if (entry["name"] == wanted) {
+                    return entry["host"].get<std::string>().size() + entry["groups"].size();
+                }
+            }
+            return static_cast<size_t>(0);
+        });
+        double indexMicros = microseconds(iterations * 100, [&](int64_t i) {
+            Inventory inventory(source, index);
+            std::vector<uint32_t> positions;
+            if (!inventory.find('i', name(i), positions)) {
+                return static_cast<size_t>(0);
+            }
+            Inventory::Instrument instrument = inventory.instrument(positions.front());
+            inventory.find('g', std::string(instrument.groups.substr(0, instrument.groups.find(','))), positions);
+            return instrument.host.size() + positions.size();
+        });
+
+        json line = {{"benchmark", "inventoryLookup"}, {"instruments", count},
+                     {"jsonBytes", std::filesystem::file_size(source)}, {"indexBytes", std::filesystem::file_size(index)},
+                     {"compileMilliseconds", std::round(compileMs * 100) / 100},
+                     {"parseJsonMicroseconds", parseMicros}, {"mappedIndexMicroseconds", indexMicros}};
+        std::cout << line.dump() << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,281 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "nlohmann/json.hpp"
+#include "httplib.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using nlohmann::json;
+
+/**
+ * @class MockInstrument
+ * @brief In-process HTTP server that answers the Automation API paths with fixed, realistic payloads.
+ *
+ * The benchmarks use it in place of a PTC Tempo so that results depend on the client alone. The
+ * payloads have the same shape as the examples in the README. Every response can be delayed by a
+ * fixed latency to stand in for the instrument's own response time.
+ *
+ * When built with USE_ZLIB, the server compresses JSON bodies for clients that accept gzip or
+ * deflate, the same as the HTTP library does for any server. The body bytes actually sent are
+ * counted, so the benchmarks can compare bytes on the wire.
+ */
+class MockInstrument {
+
+    /// Number of worker threads in the server, so that many clients can wait on latency at once.
+    static const size_t serverThreads = 256;
+
+    /// Serves the Automation API paths.
+    httplib::Server server;
+    /// Runs the server's listen loop.
+    std::thread thread;
+    /// Port the server is bound to on the loopback interface.
+    int port = 0;
+    /// Delay added to every response.
+    std::atomic<std::chrono::milliseconds> latency;
+
+    /// Body for /tempo/run-reports without limit or offset.
+    std::string reportsBody;
+    /// Number of reports in the list.
+    size_t reportCount;
+    /// Number of body bytes sent, after any compression.
+    std::atomic<int64_t> bodyBytes{0};
+    /// Number of requests answered.
+    std::atomic<int64_t> requestCount{0};
+    /// Number of requests that arrived, answered or not.
+    std::atomic<int64_t> arrivalCount{0};
+    /// Steady clock time in nanoseconds at which the last request arrived.
+    std::atomic<int64_t> arrivalNanoseconds{0};
+
+    /// Waits for the response latency, then sets the body as JSON.
+    void reply(httplib::Response& res, const std::string& body) const {
+        auto delay = latency.load();
+        if (delay.count() > 0) {
+            std::this_thread::sleep_for(delay);
+        }
+        res.set_content(body, "application/json");
+    }
+
+public:
+
+    /**
+     * @brief Starts the server on the loopback interface.
+     * @param reportCount_ Number of run reports served by /tempo/run-reports.
+     * @param latency_ Delay added to every response.
+     * @param port_ Port to listen on, or 0 for any free port.
+     */
+    explicit MockInstrument(size_t reportCount_ = 100, std::chrono::milliseconds latency_ = std::chrono::milliseconds(0), int port_ = 0) :
+            latency(latency_),
+            reportCount(reportCount_) {
+        reportsBody = reports(reportCount, 0).dump();
+
+        server.new_task_queue = []() { return new httplib::ThreadPool(serverThreads); };
+        server.Get("/tempo", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, device().dump());
+        });
+        server.Get("/tempo/status", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, status().dump());
+        });
+        server.Get("/tempo/lid", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, lid().dump());
+        });
+        server.Get("/tempo/protocol-run", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, run().dump());
+        });
+        server.Get("/tempo/errors", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, errors().dump());
+        });
+        server.Get(R"(/tempo/protocols/(user|public))", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, protocols().dump());
+        });
+        server.Get("/tempo/run-reports/count", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, json{{"count", reportCount}}.dump());
+        });
+        server.Get(R"(/tempo/run-reports/([^/]+))", [this](const httplib::Request& req, httplib::Response& res) {
+            reply(res, report(req.matches[1].str()).dump());
+        });
+        server.Get("/tempo/run-reports", [this](const httplib::Request& req, httplib::Response& res) {
+            if (!req.has_param("limit") && !req.has_param("offset")) {
+                reply(res, reportsBody);
+                return;
+            }
+            size_t limit = req.has_param("limit") ? std::stoul(req.get_param_value("limit")) : reportCount;
+            size_t offset = req.has_param("offset") ? std::stoul(req.get_param_value("offset")) : 0;
+            offset = offset < reportCount ? offset : reportCount;
+            limit = limit < reportCount - offset ? limit : reportCount - offset;
+            reply(res, reports(limit, offset).dump());
+        });
+        server.Post("/tempo/protocol-run", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, R"({"lid":"opened","lidTemp":90,"status":"running","steps":6,"volume":17})");
+        });
+        server.Put(R"(/tempo/(lid|errors|protocol-run)/[a-z]+)", [this](const httplib::Request&, httplib::Response& res) {
+            reply(res, "{}");
+        });
+
+        server.set_pre_routing_handler([this](const httplib::Request&, httplib::Response&) {
+            arrivalNanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            ++arrivalCount;
+            return httplib::Server::HandlerResponse::Unhandled;
+        });
+
+        // the logger runs after the body is compressed, so it sees the size on the wire
+        server.set_logger([this](const httplib::Request&, const httplib::Response& res) {
+            bodyBytes += static_cast<int64_t>(res.body.size());
+            ++requestCount;
+        });
+
+        if (port_ == 0) {
+            port = server.bind_to_any_port("127.0.0.1");
+        } else if (server.bind_to_port("127.0.0.1", port_)) {
+            port = port_;
+        } else {
+            throw std::runtime_error("Unable to listen on port " + std::to_string(port_));
+        }
+        thread = std::thread([this]() { server.listen_after_bind(); });
+        server.wait_until_ready();
+    }
+
+    MockInstrument(const MockInstrument&) = delete;
+    MockInstrument& operator=(const MockInstrument&) = delete;
+
+    /// Stops the server and waits for its thread.
+    ~MockInstrument() {
+        server.stop();
+        thread.join();
+    }
+
+    /// Returns the number of response body bytes sent so far, after any compression.
+    [[nodiscard]] int64_t bytesSent() const {
+        return bodyBytes;
+    }
+
+    /// Returns the number of requests answered so far.
+    [[nodiscard]] int64_t requests() const {
+        return requestCount;
+    }
+
+    /// Returns the number of requests that arrived so far, including any the client gave up on.
+    [[nodiscard]] int64_t arrivals() const {
+        return arrivalCount;
+    }
+
+    /// Sets the delay added to every response from now on.
+    void setLatency(std::chrono::milliseconds latency_) {
+        latency = latency_;
+    }
+
+    /// Returns the steady clock time at which the last request arrived, before it was routed.
+    [[nodiscard]] std::chrono::steady_clock::time_point lastArrival() const {
+        return std::chrono::steady_clock::time_point(std::chrono::nanoseconds(arrivalNanoseconds.load()));
+    }
+
+    /// Returns the host string that a TempoClient uses to connect to this server.
+    [[nodiscard]] std::string host() const {
+        return "http://127.0.0.1:" + std::to_string(port);
+    }
+
+    /// Returns the response to /tempo.
+    static json device() {
+        return json::parse(R"({"device":{"details":{"automationAPI":"1.0.0"},"instrumentName":"C2000",
+            "model":"PTCTempo384","serialNumber":"CC00622","type":"PTCTempo","ver":"1.2.0"},
+            "lid":"closed","status":"idle","time":"2023-04-15T10:43:03-07:00"})");
+    }
+
+    /// Returns the response to /tempo/status during a run.
+    static json status() {
+        return json::parse(R"({"currentRepeat":1,"protocolTimeRemaining":242,"status":"running","stepNumber":1,"totalRepeat":0})");
+    }
+
+    /// Returns the response to /tempo/lid during a run.
+    static json lid() {
+        return json::parse(R"({"lid":"closedWithPlate","status":"running","time":"2023-04-16T12:02:20-07:00"})");
+    }
+
+    /// Returns the response to /tempo/protocol-run during a run.
+    static json run() {
+        return json::parse(R"({"lid":"closedWithPlate","protocolRun":{"block":0,"lidTemp":90,"plateID":"plate8446",
+            "protocolName":"STD2-short","runName":"runSTD2-short8446","step":{"currentRepeat":1,"numberOfSteps":6,
+            "stepNumber":1,"stepState":"lidPreheat","stepTime":0,"totalRepeat":0},"temperature":{"currentBlockTemp":25.1,
+            "currentLidTemp":50.1,"currentSampleTemp":25.1},"time":{"elapsed":0,"hold":0,"remaining":0,
+            "totalRemaining":242},"volume":17},"status":"running","time":"2023-04-16T12:02:20-07:00"})");
+    }
+
+    /// Returns the response to /tempo/errors with two cycler faults and one lid fault.
+    static json errors() {
+        return json::parse(R"({"cyclerFaultCount":2,"cyclerFaults":[{"block":0,"description":"Left heatsink over temperature error",
+            "info":0,"number":301,"severity":"abort","timestamp":"2023-04-26T11:28:18-07:00"},{"block":0,
+            "description":"Low ramp temperature error","info":0,"number":311,"severity":"abort",
+            "timestamp":"2023-04-26T11:28:11-07:00"}],"lidFaultCount":1,"lidFaults":[{"block":0,
+            "description":"Hinge motor close switch not activated at engage position","info":0,"number":1015,
+            "severity":"abort","timestamp":"2023-04-26T11:28:24-07:00"}]})");
+    }
+
+    /// Returns the response to /tempo/protocols/user.
+    static json protocols() {
+        return json::parse(R"({"location":"Automation","protocolNames":[{"lastModified":"2023-04-07T07:28:02",
+            "name":"NESTPR2-fast-long"},{"lastModified":"2023-03-18T15:59:51","name":"STD2-short"}]})");
+    }
+
+    /// Returns the run report ID for the report at index, most recent first.
+    static std::string reportId(size_t index) {
+        char id[40];
+        std::snprintf(id, sizeof(id), "6f1c2a4e-0000-4000-8000-%012zx", index);
+        return id;
+    }
+
+    /// Returns the list entry for the report at index.
+    static json reportSummary(size_t index) {
+        json summary;
+        summary["id"] = reportId(index);
+        summary["runName"] = "runSTD2-short" + std::to_string(index);
+        summary["plateID"] = "plate" + std::to_string(index);
+        summary["protocolName"] = index % 2 ? "NESTPR2-fast-long" : "STD2-short";
+        summary["status"] = index % 17 ? "completed" : "stopped";
+        summary["startTime"] = "2023-04-16T12:02:08-07:00";
+        summary["endTime"] = "2023-04-16T12:06:10-07:00";
+        summary["user"] = "Automation";
+        return summary;
+    }
+
+    /// Returns the response to /tempo/run-reports with count reports starting at offset.
+    static json reports(size_t count, size_t offset) {
+        json list = json::array();
+        for (size_t i = offset; i < offset + count; ++i) {
+            list.push_back(reportSummary(i));
+        }
+        return json{{"reports", list}};
+    }
+
+    /// Returns a full run report with one temperature sample per second of the run.
+    static json report(const std::string& id) {
+        json report = reportSummary(0);
+        report["id"] = id;
+        report["lidTemp"] = 90;
+        report["volume"] = 17;
+        json steps = json::array();
+        for (int step = 1; step <= 6; ++step) {
+            steps.push_back({{"stepNumber", step}, {"temperature", 50.0 + step * 7.5}, {"hold", 30}});
+        }
+        report["steps"] = steps;
+        json samples = json::array();
+        for (int second = 0; second < 242; ++second) {
+            samples.push_back({{"elapsed", second}, {"blockTemp", 25.0 + (second % 60)}, {"sampleTemp", 24.5 + (second % 60)}});
+        }
+        report["temperatures"] = samples;
+        return report;
+    }
+};
@@ -0,0 +1,47 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "MockInstrument.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/// Set by the signal handler to stop the server.
+static std::atomic<bool> stopping{false};
+
+/**
+ * @brief Runs a MockInstrument until it is interrupted, so the tempoclient app can be measured against it.
+ *
+ * Usage: tempoclient_mock_server [port] [reports] [latencyMs]
+ *
+ * When stopped with Ctrl+C, this writes the number of body bytes sent to stderr. When built with
+ * USE_ZLIB, bodies are compressed for clients that accept it, so the byte count shows the size
+ * on the wire.
+ */
+int main(int argc, char** argv) {
+    int port = argc > 1 ? std::stoi(argv[1]) : 8080;
+    size_t reports = argc > 2 ? std::stoul(argv[2]) : 1000;
+    auto latency = argc > 3 ? std::stoll(argv[3]) : 0;
+
+    std::signal(SIGINT, [](int) { stopping = true; });
+    std::signal(SIGTERM, [](int) { stopping = true; });
+
+    MockInstrument instrument(reports, std::chrono::milliseconds(latency), port);
+    std::cerr << "Serving " << reports << " reports on " << instrument.host() << std::endl;
+    while (!stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::cerr << "Sent " << instrument.bytesSent() << " body bytes" << std::endl;
+    return 0;
+}
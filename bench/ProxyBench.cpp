@@ -0,0 +1,97 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "TempoClient.hpp"
+#include "TempoProxy.hpp"
+#include "MockInstrument.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Polls the status through the proxy from many clients and prints the requests that reach the instrument.
+ * @param instrument Server that counts the requests it answers.
+ * @param proxyHost Host string of the proxy.
+ * @param clients Number of clients polling at the same time.
+ * @param interval Time between the polls of each client.
+ * @param duration Time the clients poll for.
+ */
+static void measure(MockInstrument& instrument, const std::string& proxyHost, size_t clients,
+                    std::chrono::milliseconds interval, std::chrono::milliseconds duration) {
+    std::atomic<int64_t> requests{0};
+    std::atomic<int64_t> failures{0};
+    auto startRequests = instrument.requests();
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < clients; ++i) {
+        threads.emplace_back([&]() {
+            TempoClient tempoClient(proxyHost, "password", 30);
+            while (Clock::now() - start < duration) {
+                tempoClient.status();
+                ++requests;
+                if (!tempoClient.statusOK()) {
+                    ++failures;
+                }
+                std::this_thread::sleep_for(interval);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    int64_t upstream = instrument.requests() - startRequests;
+
+    json line;
+    line["benchmark"] = "proxyStatus";
+    line["clients"] = clients;
+    line["requests"] = requests.load();
+    line["failures"] = failures.load();
+    line["upstreamRequests"] = upstream;
+    line["clientRate"] = static_cast<double>(requests) / seconds;
+    line["upstreamRate"] = static_cast<double>(upstream) / seconds;
+    std::cout << line.dump() << std::endl;
+}
+
+/**
+ * @brief Measures how many requests reach the instrument as more clients poll through the proxy.
+ *
+ * Usage: tempoclient_proxy_bench [port] [latencyMs] [seconds]
+ *
+ * Each client polls /tempo/status every 100 ms. Without the proxy, the instrument would get ten
+ * requests per second from each client; with it, the instrument gets about one per second for
+ * the default keep time of /tempo/status, however many clients there are.
+ */
+int main(int argc, char** argv) {
+    int port = argc > 1 ? std::stoi(argv[1]) : 18081;
+    auto latency = std::chrono::milliseconds(argc > 2 ? std::stoll(argv[2]) : 50);
+    auto duration = std::chrono::milliseconds(argc > 3 ? std::stoll(argv[3]) * 1000 : 5000);
+
+    MockInstrument instrument(100, latency);
+    TempoProxy proxy(instrument.host(), 30, {}, 256);
+    std::thread server([&]() { proxy.listen("127.0.0.1", port); });
+    // give the proxy time to bind before the first client connects
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::string proxyHost = "http://127.0.0.1:" + std::to_string(port);
+    for (size_t clients : {1, 4, 16, 64}) {
+        measure(instrument, proxyHost, clients, std::chrono::milliseconds(100), duration);
+    }
+    proxy.stop();
+    server.join();
+    std::cerr << proxy.stats().dump() << std::endl;
+    return 0;
+}
@@ -0,0 +1,214 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "Router.hpp"
+#include "LatencyHistogram.hpp"
+#include "MockInstrument.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @class NullBuffer
+ * @brief Stream buffer that discards everything, so command output does not time the terminal.
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override {
+        return c;
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+};
+
+/// Returns the nanoseconds from one time to another.
+static int64_t nanoseconds(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+/// Returns a percentile of a histogram of nanoseconds in microseconds, to a hundredth.
+static double microseconds(const LatencyHistogram& histogram, double fraction) {
+    return static_cast<double>(histogram.percentile(fraction) / 10) / 100;
+}
+
+/**
+ * @brief Times the startup of a command in this process, the way main runs it, and prints each phase.
+ *
+ * The phases are making the Router, reading the config file, parsing the command line, and
+ * going from the parsed command line to the arrival of the first request at the instrument.
+ * @param name Name of the command in the results.
+ * @param args Arguments after the program name.
+ * @return Median microseconds from the start to the first request, or -1 if the command failed.
+ */
+static double inProcess(const MockInstrument& instrument, int64_t iterations, const std::string& name,
+                        const std::vector<std::string>& args) {
+    LatencyHistogram construct;
+    LatencyHistogram initialize;
+    LatencyHistogram parse;
+    LatencyHistogram request;
+    LatencyHistogram total;
+    NullBuffer discard;
+    auto* stdoutBuffer = std::cout.rdbuf(&discard);
+    int exitCode = 0;
+    for (int64_t i = 0; i < iterations && exitCode == 0; ++i) {
+        std::vector<std::string> reversed(args.rbegin(), args.rend());
+        auto start = Clock::now();
+        Router router;
+        auto constructed = Clock::now();
+        router.initialize();
+        auto initialized = Clock::now();
+        router.tempoCli().parse(reversed);
+        auto parsed = Clock::now();
+        exitCode = router.run();
+        auto arrival = instrument.lastArrival();
+        if (arrival < parsed) {
+            exitCode = 1;
+        }
+        construct.record(nanoseconds(start, constructed));
+        initialize.record(nanoseconds(constructed, initialized));
+        parse.record(nanoseconds(initialized, parsed));
+        request.record(nanoseconds(parsed, arrival));
+        total.record(nanoseconds(start, arrival));
+    }
+    std::cout.rdbuf(stdoutBuffer);
+    if (exitCode != 0) {
+        std::cerr << "The " << name << " command failed with exit code " << exitCode << "." << std::endl;
+        return -1;
+    }
+    json line = {{"benchmark", "startup"}, {"mode", "inProcess"}, {"command", name}, {"iterations", total.count()},
+                 {"routerMicroseconds", microseconds(construct, 0.5)}, {"configMicroseconds", microseconds(initialize, 0.5)},
+                 {"parseMicroseconds", microseconds(parse, 0.5)}, {"requestMicroseconds", microseconds(request, 0.5)},
+                 {"p50Microseconds", microseconds(total, 0.5)}, {"p99Microseconds", microseconds(total, 0.99)}};
+    std::cout << line.dump() << std::endl;
+    return microseconds(total, 0.5);
+}
+
+#ifndef WIN32
+/**
+ * @brief Times a tempoclient process from being spawned to the arrival of its first request.
+ * @param program Path of the tempoclient executable.
+ * @param name Name of the command in the results.
+ * @param args Arguments after the program name.
+ * @return Median microseconds from the spawn to the first request, or -1 if the command failed.
+ */
+static double spawned(const MockInstrument& instrument, int64_t iterations, const std::string& program,
+                      const std::string& name, const std::vector<std::string>& args) {
+    std::vector<std::string> line = {program, "--local"};
+    line.insert(line.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    for (auto& arg : line) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+
+    LatencyHistogram total;
+    bool success = true;
+    for (int64_t i = 0; i < iterations && success; ++i) {
+        pid_t pid = 0;
+        auto start = Clock::now();
+        if (posix_spawn(&pid, program.c_str(), &actions, nullptr, argv.data(), environ) != 0) {
+            std::cerr << "Could not start " << program << "." << std::endl;
+            success = false;
+            break;
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        auto arrival = instrument.lastArrival();
+        success = WIFEXITED(status) && WEXITSTATUS(status) == 0 && arrival > start;
+        total.record(nanoseconds(start, arrival));
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    if (!success) {
+        std::cerr << "The " << name << " command of " << program << " failed." << std::endl;
+        return -1;
+    }
+    json result = {{"benchmark", "startup"}, {"mode", "process"}, {"command", name}, {"iterations", total.count()},
+                   {"p50Microseconds", microseconds(total, 0.5)}, {"p99Microseconds", microseconds(total, 0.99)}};
+    std::cout << result.dump() << std::endl;
+    return microseconds(total, 0.5);
+}
+#endif
+
+/**
+ * @brief Measures the time from the start of common commands to their first request to the instrument.
+ *
+ * Usage: tempoclient_startup_bench [iterations] [budget] [tempoclient]
+ *
+ * Each command is run in this process the way main runs it, and each line of output gives the
+ * median microseconds of each phase of its startup and of the whole. With the path of a
+ * tempoclient executable, each command is also run as a new process with --local, and the time
+ * from the spawn to the first request is printed; this includes loading the program. The
+ * budget is in microseconds, 5000 by default. The program exits with 1 if the median of any
+ * command is over the budget, so it can guard the startup time in a build.
+ */
+int main(int argc, char** argv) {
+    int64_t iterations = argc > 1 ? std::stoll(argv[1]) : 200;
+    double budget = argc > 2 ? std::stod(argv[2]) : 5000;
+    std::string program = argc > 3 ? std::filesystem::absolute(argv[3]).string() : "";
+
+    // a directory of its own, so a config.json in the current directory does not change the results
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "tempoclient_startup_bench";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::filesystem::current_path(directory);
+
+    MockInstrument instrument;
+    std::ofstream("config.json") << json{{"host", instrument.host()}, {"password", "password"},
+                                         {"waitTime", 30}, {"interval", 1}, {"display", "json"}}.dump(2);
+
+    const std::vector<std::pair<std::string, std::vector<std::string>>> commands = {
+        {"tempo", {}},
+        {"status", {"status"}},
+        {"lid", {"lid"}},
+        {"run", {"run"}},
+        {"errors", {"errors"}},
+        {"protocols", {"protocols"}},
+        {"reports --count", {"reports", "--count"}},
+    };
+    bool withinBudget = true;
+    for (const auto& [name, args] : commands) {
+        double median = inProcess(instrument, iterations, name, args);
+        withinBudget = withinBudget && median >= 0 && median <= budget;
+#ifndef WIN32
+        if (!program.empty()) {
+            median = spawned(instrument, std::max<int64_t>(iterations / 10, 5), program, name, args);
+            withinBudget = withinBudget && median >= 0 && median <= budget;
+        }
+#endif
+    }
+    if (!withinBudget) {
+        std::cerr << "Error. The startup of a command took longer than the budget of " << budget << " microseconds." << std::endl;
+    }
+
+    std::filesystem::current_path(directory.parent_path());
+    std::filesystem::remove_all(directory);
+    return withinBudget ? 0 : 1;
+}
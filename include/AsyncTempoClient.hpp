@@ -0,0 +1,848 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#ifndef __linux__
+#error "AsyncTempoClient uses epoll and is only available on Linux."
+#endif
+
+#include "nlohmann/json.hpp"
+// only httplib::Error is used from the HTTP library, so results can be compared with TempoClient
+#include "httplib.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class EventLoop
+ * @brief Waits on many sockets at once with epoll and calls a handler when one is ready.
+ *
+ * One EventLoop thread can serve the connections of hundreds of instruments. Other threads hand
+ * work to the loop with post, which wakes it through an eventfd. Sockets, handlers and timers are
+ * only touched on the loop thread, so none of them need locks.
+ */
+class EventLoop {
+
+public:
+
+    /// Called on the loop thread with the epoll events that are ready for a socket.
+    using Handler = std::function<void(uint32_t events)>;
+    /// Clock used for timers.
+    using Clock = std::chrono::steady_clock;
+    /// Identifies a timer so it can be cancelled. Timers with the same deadline get different IDs.
+    using Timer = std::pair<Clock::time_point, uint64_t>;
+
+private:
+
+    /// Maximum number of events taken from epoll in one call.
+    static const int maxEvents = 64;
+
+    /// epoll instance for all sockets of this loop.
+    int epollFd;
+    /// eventfd used to wake the loop when work is posted from another thread.
+    int wakeFd;
+    /// Handlers keyed by socket.
+    std::unordered_map<int, Handler> handlers;
+    /// Timers ordered by deadline.
+    std::map<Timer, std::function<void()>> timers;
+    /// ID given to the next timer.
+    uint64_t nextTimer = 1;
+    /// Guards posted.
+    std::mutex postedMutex;
+    /// Work posted from any thread and run on the loop thread.
+    std::vector<std::function<void()>> posted;
+    /// Set to stop the loop.
+    std::atomic<bool> stopping{false};
+    /// Thread started by start, if any.
+    std::thread thread;
+    /// ID of the thread that runs the loop.
+    std::atomic<std::thread::id> loopThread;
+
+    /// Runs all work posted since the last call.
+    void runPosted() {
+        std::vector<std::function<void()>> work;
+        {
+            std::scoped_lock lock(postedMutex);
+            work.swap(posted);
+        }
+        for (auto& function : work) {
+            function();
+        }
+    }
+
+    /// Runs all timers that are due.
+    void runTimers() {
+        auto now = Clock::now();
+        while (!timers.empty() && timers.begin()->first.first <= now) {
+            auto function = std::move(timers.begin()->second);
+            timers.erase(timers.begin());
+            function();
+        }
+    }
+
+    /// Returns the number of milliseconds epoll may wait before the next timer is due, or -1 for no timer.
+    int waitTime() const {
+        if (timers.empty()) {
+            return -1;
+        }
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers.begin()->first.first - Clock::now()).count();
+        return wait < 0 ? 0 : static_cast<int>(wait);
+    }
+
+public:
+
+    /**
+     * @brief Creates the epoll instance. The loop does not run until run or start is called.
+     */
+    EventLoop() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            throw std::runtime_error(std::string("Unable to create event loop: ") + std::strerror(errno));
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    }
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /// Stops the loop thread, if started, and closes the epoll instance.
+    ~EventLoop() {
+        stop();
+        close(wakeFd);
+        close(epollFd);
+    }
+
+    /**
+     * @brief Runs the loop on the calling thread until stop is called.
+     */
+    void run() {
+        loopThread = std::this_thread::get_id();
+        epoll_event events[maxEvents];
+        while (!stopping) {
+            int count = epoll_wait(epollFd, events, maxEvents, waitTime());
+            if (count < 0 && errno != EINTR) {
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    uint64_t value;
+                    [[maybe_unused]] auto bytes = read(wakeFd, &value, sizeof(value));
+                    continue;
+                }
+                // copy the handler, it may remove itself
+                if (auto handler = handlers.find(fd); handler != handlers.end()) {
+                    auto function = handler->second;
+                    function(events[i].events);
+                }
+            }
+            runPosted();
+            runTimers();
+        }
+        loopThread = std::thread::id();
+    }
+
+    /// Runs the loop on a new thread.
+    void start() {
+        stopping = false;
+        thread = std::thread([this]() { run(); });
+    }
+
+    /// Stops the loop and waits for the thread started by start.
+    void stop() {
+        stopping = true;
+        wake();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    /// Returns true if called from the thread that runs the loop.
+    [[nodiscard]] bool onLoopThread() const {
+        return loopThread.load() == std::this_thread::get_id();
+    }
+
+    /// Returns true while the loop is running on some thread.
+    [[nodiscard]] bool running() const {
+        return loopThread.load() != std::thread::id();
+    }
+
+    /// Wakes the loop from epoll_wait.
+    void wake() {
+        uint64_t one = 1;
+        [[maybe_unused]] auto bytes = write(wakeFd, &one, sizeof(one));
+    }
+
+    /**
+     * @brief Queues a function to run on the loop thread. Safe to call from any thread.
+     * @param function Work to run.
+     */
+    void post(std::function<void()> function) {
+        {
+            std::scoped_lock lock(postedMutex);
+            posted.push_back(std::move(function));
+        }
+        wake();
+    }
+
+    /// Starts watching a socket for events. Loop thread only.
+    void add(int fd, uint32_t events, Handler handler) {
+        handlers[fd] = std::move(handler);
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    /// Changes the events watched for a socket. Loop thread only.
+    void modify(int fd, uint32_t events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    /// Stops watching a socket. Loop thread only.
+    void remove(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        handlers.erase(fd);
+    }
+
+    /// Calls function on the loop thread once after delay. Loop thread only.
+    Timer addTimer(Clock::duration delay, std::function<void()> function) {
+        Timer timer{Clock::now() + delay, nextTimer++};
+        timers.emplace(timer, std::move(function));
+        return timer;
+    }
+
+    /// Cancels a timer that has not run yet. Loop thread only.
+    void cancelTimer(const Timer& timer) {
+        timers.erase(timer);
+    }
+};
+
+/**
+ * @struct AsyncResult
+ * @brief Response from a call made with AsyncTempoClient.
+ */
+struct AsyncResult {
+    httplib::Error error = httplib::Error::Unknown;  ///< Success, or why no response was received.
+    int status = 0;                                  ///< HTTP status code of the response.
+    std::string body;                                ///< Response body in JSON format.
+
+    /// Returns true if there are not HTTP errors and the response status is 200.
+    [[nodiscard]] bool ok() const {
+        return error == httplib::Error::Success && status == 200;
+    }
+};
+
+/**
+ * @brief The AsyncTempoClient class makes non-blocking calls to PTC-Tempo on an EventLoop.
+ *
+ * It has the same calls as TempoClient, but each one returns at once. The response is delivered
+ * through the returned future, and also to the optional completion callback, which runs on the
+ * loop thread and must not block. Many AsyncTempoClient objects, one per instrument, can share
+ * one EventLoop, so watching hundreds of instruments does not need a thread per instrument.
+ *
+ * Calls to one instrument are sent one after another over a single keep-alive connection, in
+ * the order they were made. Only http:// hosts are supported.
+ *
+ * @code
+ * EventLoop loop;
+ * loop.start();
+ * AsyncTempoClient client(loop, "http://10.10.2.51", password, 10);
+ * client.status([](const AsyncResult& result) { std::cout << result.body << std::endl; });
+ * AsyncResult lid = client.lid().get();
+ * @endcode
+ */
+class AsyncTempoClient {
+
+public:
+
+    /// Called on the loop thread when a call completes.
+    using Callback = std::function<void(const AsyncResult&)>;
+
+private:
+
+    /// Size of each read from the socket.
+    static const size_t readSize = 16384;
+
+    /**
+     * @struct Request
+     * @brief A call waiting to be sent or waiting for its response.
+     */
+    struct Request {
+        std::string method;                                  ///< HTTP method.
+        std::string path;                                    ///< Path and query string.
+        std::string body;                                    ///< Request body, empty for GET and PUT.
+        Callback done;                                       ///< Optional completion callback.
+        std::shared_ptr<std::promise<AsyncResult>> promise;  ///< Fulfilled when the call completes.
+        bool retried = false;                                ///< True once sent again on a new connection.
+    };
+
+    /// Where the response parser is within the response.
+    enum class Phase { Headers, Length, Chunked, UntilClose };
+
+    /// Loop that owns the socket.
+    EventLoop& loop;
+    /// Value of the Host header.
+    std::string hostHeader;
+    /// Value of the Authorization header.
+    std::string authorization;
+    /// How long to wait for a response.
+    std::chrono::seconds waitTime;
+    /// Resolved address of PTC-Tempo.
+    sockaddr_storage address{};
+    /// Length of address.
+    socklen_t addressLength = 0;
+
+    // The members below are only used on the loop thread.
+
+    /// Connection to PTC-Tempo, or -1 if not connected.
+    int sock = -1;
+    /// True while a non-blocking connect is in progress.
+    bool connecting = false;
+    /// True if the request in flight was sent on a connection used before.
+    bool reused = false;
+    /// Calls in order; the front one is in flight while busy is true.
+    std::deque<Request> pending;
+    /// True while a call is in flight.
+    bool busy = false;
+    /// Request text being written.
+    std::string out;
+    /// Number of bytes of out already written.
+    size_t written = 0;
+    /// Bytes read and not yet parsed.
+    std::string in;
+    /// Parser state.
+    Phase phase = Phase::Headers;
+    /// Response being parsed.
+    AsyncResult response;
+    /// Content length, or remaining size of the current chunk.
+    size_t remaining = 0;
+    /// True if the instrument will keep the connection open after this response.
+    bool keepAlive = true;
+    /// Timer for the request in flight.
+    EventLoop::Timer timer;
+
+    /// Encodes the Automation user credentials for basic authentication.
+    static std::string base64(const std::string& text) {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string encoded;
+        size_t i = 0;
+        for (; i + 2 < text.size(); i += 3) {
+            uint32_t n = (uint8_t(text[i]) << 16) | (uint8_t(text[i + 1]) << 8) | uint8_t(text[i + 2]);
+            encoded += {table[n >> 18], table[(n >> 12) & 63], table[(n >> 6) & 63], table[n & 63]};
+        }
+        if (i + 1 == text.size()) {
+            uint32_t n = uint8_t(text[i]) << 16;
+            encoded += {table[n >> 18], table[(n >> 12) & 63], '=', '='};
+        } else if (i + 2 == text.size()) {
+            uint32_t n = (uint8_t(text[i]) << 16) | (uint8_t(text[i + 1]) << 8);
+            encoded += {table[n >> 18], table[(n >> 12) & 63], table[(n >> 6) & 63], '='};
+        }
+        return encoded;
+    }
+
+    /// Returns a lower case copy of text, for comparing header names and values.
+    static std::string lower(std::string text) {
+        for (auto& c : text) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return text;
+    }
+
+    /**
+     * @brief Queues a call and returns the future for its response. Safe to call from any thread.
+     */
+    std::future<AsyncResult> enqueue(std::string method, std::string path, std::string body, Callback done) {
+        Request request{std::move(method), std::move(path), std::move(body), std::move(done),
+                        std::make_shared<std::promise<AsyncResult>>()};
+        auto future = request.promise->get_future();
+        loop.post([this, request = std::move(request)]() mutable {
+            pending.push_back(std::move(request));
+            if (!busy) {
+                startNext();
+            }
+        });
+        return future;
+    }
+
+    /// Sends the call at the front of the queue, connecting first if needed.
+    void startNext() {
+        if (pending.empty()) {
+            busy = false;
+            return;
+        }
+        busy = true;
+        const auto& request = pending.front();
+        out = request.method + ' ' + request.path + " HTTP/1.1\r\nHost: " + hostHeader +
+              "\r\nAuthorization: " + authorization + "\r\nAccept: application/json\r\nConnection: keep-alive\r\n";
+        if (request.method != "GET") {
+            out += "Content-Type: application/json\r\nContent-Length: " + std::to_string(request.body.size()) + "\r\n";
+        }
+        out += "\r\n" + request.body;
+        written = 0;
+        in.clear();
+        phase = Phase::Headers;
+        response = AsyncResult();
+        keepAlive = true;
+        timer = loop.addTimer(waitTime, [this]() { fail(httplib::Error::Read, false); });
+
+        if (sock < 0) {
+            connect();
+        } else {
+            reused = true;
+            writeSome();
+        }
+    }
+
+    /// Starts a non-blocking connect to PTC-Tempo.
+    void connect() {
+        reused = false;
+        sock = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sock < 0) {
+            fail(httplib::Error::Connection, false);
+            return;
+        }
+        int on = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if (::connect(sock, reinterpret_cast<sockaddr*>(&address), addressLength) < 0 && errno != EINPROGRESS) {
+            closeSocket();
+            fail(httplib::Error::Connection, false);
+            return;
+        }
+        connecting = true;
+        loop.add(sock, EPOLLOUT | EPOLLIN | EPOLLRDHUP, [this](uint32_t events) { onEvents(events); });
+    }
+
+    /// Closes the connection, if open.
+    void closeSocket() {
+        if (sock >= 0) {
+            loop.remove(sock);
+            close(sock);
+            sock = -1;
+        }
+        connecting = false;
+    }
+
+    /// Handles socket events for the call in flight.
+    void onEvents(uint32_t events) {
+        if (connecting) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0) {
+                fail(httplib::Error::Connection, false);
+                return;
+            }
+            connecting = false;
+        }
+        if (!busy) {
+            // the instrument closed an idle keep-alive connection
+            closeSocket();
+            return;
+        }
+        if ((events & EPOLLOUT) && written < out.size()) {
+            writeSome();
+        } else if (events & (EPOLLIN | EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+            readSome();
+        }
+    }
+
+    /// Writes as much of the request as the socket accepts.
+    void writeSome() {
+        while (written < out.size()) {
+            auto count = ::send(sock, out.data() + written, out.size() - written, MSG_NOSIGNAL);
+            if (count < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    loop.modify(sock, EPOLLOUT | EPOLLIN | EPOLLRDHUP);
+                    return;
+                }
+                fail(httplib::Error::Write, true);
+                return;
+            }
+            written += static_cast<size_t>(count);
+        }
+        loop.modify(sock, EPOLLIN | EPOLLRDHUP);
+    }
+
+    /// Reads everything available and parses it.
+    void readSome() {
+        char buffer[readSize];
+        while (true) {
+            auto count = recv(sock, buffer, sizeof(buffer), 0);
+            if (count > 0) {
+                in.append(buffer, static_cast<size_t>(count));
+                bool complete;
+                try {
+                    complete = parse();
+                } catch (std::exception&) {
+                    // malformed length in the response
+                    fail(httplib::Error::Read, false);
+                    return;
+                }
+                if (complete) {
+                    finish();
+                    return;
+                }
+            } else if (count == 0) {
+                if (phase == Phase::UntilClose) {
+                    response.body += in;
+                    keepAlive = false;
+                    finish();
+                } else {
+                    fail(httplib::Error::Read, true);
+                }
+                return;
+            } else {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    fail(httplib::Error::Read, true);
+                }
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Parses the bytes read so far.
+     * @return True once the whole response has been received.
+     */
+    bool parse() {
+        if (phase == Phase::Headers) {
+            auto end = in.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                return false;
+            }
+            std::string headers = in.substr(0, end);
+            in.erase(0, end + 4);
+            auto lineEnd = headers.find("\r\n");
+            std::string statusLine = headers.substr(0, lineEnd);
+            if (auto space = statusLine.find(' '); space != std::string::npos) {
+                response.status = std::atoi(statusLine.c_str() + space + 1);
+            }
+            phase = Phase::UntilClose;
+            while (lineEnd != std::string::npos) {
+                auto start = lineEnd + 2;
+                lineEnd = headers.find("\r\n", start);
+                std::string line = headers.substr(start, lineEnd == std::string::npos ? std::string::npos : lineEnd - start);
+                auto colon = line.find(':');
+                if (colon == std::string::npos) {
+                    continue;
+                }
+                std::string name = lower(line.substr(0, colon));
+                std::string value = line.substr(line.find_first_not_of(' ', colon + 1) == std::string::npos ?
+                                                 line.size() : line.find_first_not_of(' ', colon + 1));
+                if (name == "content-length" && phase != Phase::Chunked) {
+                    phase = Phase::Length;
+                    remaining = std::stoul(value);
+                } else if (name == "transfer-encoding" && lower(value).find("chunked") != std::string::npos) {
+                    phase = Phase::Chunked;
+                    remaining = 0;
+                } else if (name == "connection" && lower(value) == "close") {
+                    keepAlive = false;
+                }
+            }
+            if (response.status == 204 || response.status == 304) {
+                phase = Phase::Length;
+                remaining = 0;
+            }
+            if (phase == Phase::UntilClose) {
+                keepAlive = false;
+            }
+        }
+
+        if (phase == Phase::Length) {
+            if (in.size() < remaining) {
+                return false;
+            }
+            response.body.append(in, 0, remaining);
+            in.erase(0, remaining);
+            return true;
+        }
+
+        if (phase == Phase::Chunked) {
+            while (true) {
+                if (remaining == 0) {
+                    auto lineEnd = in.find("\r\n");
+                    if (lineEnd == std::string::npos) {
+                        return false;
+                    }
+                    size_t size = std::stoul(in.substr(0, lineEnd), nullptr, 16);
+                    if (size == 0) {
+                        // last chunk; wait for the empty line after any trailers
+                        if (in.find("\r\n\r\n", lineEnd) == std::string::npos) {
+                            return false;
+                        }
+                        in.clear();
+                        return true;
+                    }
+                    in.erase(0, lineEnd + 2);
+                    remaining = size + 2;
+                }
+                if (in.size() < remaining) {
+                    return false;
+                }
+                response.body.append(in, 0, remaining - 2);
+                in.erase(0, remaining);
+                remaining = 0;
+            }
+        }
+        return false;
+    }
+
+    /// Completes the call in flight with the parsed response and starts the next one.
+    void finish() {
+        loop.cancelTimer(timer);
+        response.error = httplib::Error::Success;
+        if (!keepAlive) {
+            closeSocket();
+        }
+        Request request = std::move(pending.front());
+        pending.pop_front();
+        deliver(request, response);
+        startNext();
+    }
+
+    /**
+     * @brief Completes the call in flight with an error and starts the next one.
+     *
+     * If the connection had been used before and no response arrived, the instrument most likely
+     * closed it while idle. A GET is then sent once more on a new connection.
+     * @param error Why the call failed.
+     * @param retry True if the call may be sent again.
+     */
+    void fail(httplib::Error error, bool retry) {
+        loop.cancelTimer(timer);
+        closeSocket();
+        auto& request = pending.front();
+        if (retry && reused && response.status == 0 && request.method == "GET" && !request.retried) {
+            request.retried = true;
+            startNext();
+            return;
+        }
+        AsyncResult result;
+        result.error = error;
+        Request failed = std::move(request);
+        pending.pop_front();
+        deliver(failed, result);
+        startNext();
+    }
+
+    /// Hands the result to the callback and the future.
+    static void deliver(Request& request, const AsyncResult& result) {
+        if (request.done) {
+            request.done(result);
+        }
+        request.promise->set_value(result);
+    }
+
+    /// Fails every queued call and closes the connection. Loop thread only.
+    void cancelAll() {
+        if (busy) {
+            loop.cancelTimer(timer);
+        }
+        closeSocket();
+        AsyncResult result;
+        result.error = httplib::Error::Canceled;
+        while (!pending.empty()) {
+            Request request = std::move(pending.front());
+            pending.pop_front();
+            deliver(request, result);
+        }
+        busy = false;
+    }
+
+public:
+
+    /**
+     * @brief Creates a client for one PTC-Tempo on the loop.
+     *
+     * The host name is resolved here, which blocks; no connection is made until the first call.
+     * @param loop_ Loop that sends the calls and receives the responses.
+     * @param host URL for PTC-Tempo, for example http://10.10.2.51 or http://10.10.2.51:8080.
+     * @param password Plaintext password for Automation user on PTC-Tempo.
+     * @param waitTime_ Number of seconds to wait for a response.
+     * @throws std::invalid_argument If host is not an http URL or cannot be resolved.
+     */
+    AsyncTempoClient(EventLoop& loop_, const std::string& host, const std::string& password, int32_t waitTime_) :
+            loop(loop_),
+            authorization("Basic " + base64("Automation:" + password)),
+            waitTime(waitTime_) {
+        const std::string scheme = "http://";
+        if (host.compare(0, scheme.size(), scheme) != 0) {
+            throw std::invalid_argument("AsyncTempoClient only supports http:// hosts: " + host);
+        }
+        hostHeader = host.substr(scheme.size());
+        if (auto slash = hostHeader.find('/'); slash != std::string::npos) {
+            hostHeader.erase(slash);
+        }
+        std::string name = hostHeader;
+        std::string port = "80";
+        if (auto colon = hostHeader.rfind(':'); colon != std::string::npos && hostHeader.find(']', colon) == std::string::npos) {
+            name = hostHeader.substr(0, colon);
+            port = hostHeader.substr(colon + 1);
+        }
+        if (name.size() > 1 && name.front() == '[' && name.back() == ']') {
+            name = name.substr(1, name.size() - 2);
+        }
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(name.c_str(), port.c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+            throw std::invalid_argument("Unable to resolve host: " + host);
+        }
+        std::memcpy(&address, addresses->ai_addr, addresses->ai_addrlen);
+        addressLength = addresses->ai_addrlen;
+        freeaddrinfo(addresses);
+    }
+
+    AsyncTempoClient(const AsyncTempoClient&) = delete;
+    AsyncTempoClient& operator=(const AsyncTempoClient&) = delete;
+
+    /**
+     * @brief Cancels calls that have not completed and closes the connection.
+     *
+     * Must not be called on the loop thread while the loop is running on another thread.
+     */
+    ~AsyncTempoClient() {
+        if (loop.running() && !loop.onLoopThread()) {
+            std::promise<void> closed;
+            loop.post([this, &closed]() {
+                cancelAll();
+                closed.set_value();
+            });
+            closed.get_future().wait();
+        } else {
+            cancelAll();
+        }
+    }
+
+    /// Non-blocking version of TempoClient::tempo.
+    std::future<AsyncResult> tempo(Callback done = nullptr) {
+        return enqueue("GET", "/tempo", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::openLid.
+    std::future<AsyncResult> openLid(Callback done = nullptr) {
+        return enqueue("PUT", "/tempo/lid/open", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::closeLid.
+    std::future<AsyncResult> closeLid(Callback done = nullptr) {
+        return enqueue("PUT", "/tempo/lid/close", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::lid.
+    std::future<AsyncResult> lid(Callback done = nullptr) {
+        return enqueue("GET", "/tempo/lid", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::status.
+    std::future<AsyncResult> status(Callback done = nullptr) {
+        return enqueue("GET", "/tempo/status", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::faults.
+    std::future<AsyncResult> faults(bool clearFaults, Callback done = nullptr) {
+        return clearFaults ? enqueue("PUT", "/tempo/errors/clear", "", std::move(done)) :
+                             enqueue("GET", "/tempo/errors", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::protocols.
+    std::future<AsyncResult> protocols(bool publicProtocols, Callback done = nullptr) {
+        return enqueue("GET", publicProtocols ? "/tempo/protocols/public" : "/tempo/protocols/user", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::reports for a list of run reports.
+    std::future<AsyncResult> reports(int64_t limit, int64_t offset, Callback done = nullptr) {
+        std::string query;
+        if (limit > 0) {
+            query = "?limit=" + std::to_string(limit);
+        }
+        if (offset > 0) {
+            query += (query.empty() ? "?offset=" : "&offset=") + std::to_string(offset);
+        }
+        return enqueue("GET", "/tempo/run-reports" + query, "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::reportsCount.
+    std::future<AsyncResult> reportsCount(Callback done = nullptr) {
+        return enqueue("GET", "/tempo/run-reports/count", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::reports for a single run report.
+    std::future<AsyncResult> reports(const std::string& runId, Callback done = nullptr) {
+        return enqueue("GET", "/tempo/run-reports/" + runId, "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::run for the run status.
+    std::future<AsyncResult> run(Callback done = nullptr) {
+        return enqueue("GET", "/tempo/protocol-run", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::run to start a run.
+    std::future<AsyncResult> run(const json& runInfo, Callback done = nullptr) {
+        return enqueue("POST", "/tempo/protocol-run", runInfo.dump(), std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::stop.
+    std::future<AsyncResult> stop(Callback done = nullptr) {
+        return enqueue("PUT", "/tempo/protocol-run/stop", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::skip.
+    std::future<AsyncResult> skip(Callback done = nullptr) {
+        return enqueue("PUT", "/tempo/protocol-run/skip", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::pause.
+    std::future<AsyncResult> pause(Callback done = nullptr) {
+        return enqueue("PUT", "/tempo/protocol-run/pause", "", std::move(done));
+    }
+
+    /// Non-blocking version of TempoClient::resume.
+    std::future<AsyncResult> resume(Callback done = nullptr) {
+        return enqueue("PUT", "/tempo/protocol-run/resume", "", std::move(done));
+    }
+};
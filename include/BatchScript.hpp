@@ -0,0 +1,163 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class BatchScript
+ * @brief Reads the steps of a batch file: one tempoclient command line per line.
+ *
+ * A line is split into arguments at spaces and tabs, as a shell would for simple commands.
+ * Single or double quotes keep spaces in an argument, and a backslash outside single quotes
+ * takes the next character as it is. Blank lines and lines that start with # are skipped, and
+ * a leading "tempoclient" is dropped, so lines can be copied from a shell script.
+ */
+class BatchScript {
+
+public:
+
+    /**
+     * @struct Step
+     * @brief One command of the script.
+     */
+    struct Step {
+        size_t line = 0;                ///< Line number in the file, from 1.
+        std::string text;               ///< Line as written, without leading and trailing blanks.
+        std::vector<std::string> args;  ///< Arguments after the program name.
+    };
+
+    /**
+     * @brief Splits a line into arguments.
+     * @param line Line of the script.
+     * @param args Receives the arguments.
+     * @return False if a quote is not closed.
+     */
+    static bool split(const std::string& line, std::vector<std::string>& args) {
+        args.clear();
+        std::string arg;
+        bool inArg = false;
+        char quote = 0;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quote != 0) {
+                if (c == quote) {
+                    quote = 0;
+                } else if (c == '\\' && quote == '"' && i + 1 < line.size()) {
+                    arg += line[++i];
+                } else {
+                    arg += c;
+                }
+            } else if (c == ' ' || c == '\t' || c == '\r') {
+                if (inArg) {
+                    args.push_back(arg);
+                    arg.clear();
+                    inArg = false;
+                }
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+                inArg = true;
+            } else if (c == '\\' && i + 1 < line.size()) {
+                arg += line[++i];
+                inArg = true;
+            } else {
+                arg += c;
+                inArg = true;
+            }
+        }
+        if (inArg) {
+            args.push_back(arg);
+        }
+        return quote == 0;
+    }
+
+    /**
+     * @brief Reads all the steps of a script.
+     * @param in Stream with the script.
+     * @param steps Receives the steps in order.
+     * @return False if a line could not be split; this emits a message to stderr.
+     */
+    static bool read(std::istream& in, std::vector<Step>& steps) {
+        steps.clear();
+        std::string line;
+        size_t number = 0;
+        while (std::getline(in, line)) {
+            ++number;
+            auto first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+            Step step;
+            step.line = number;
+            step.text = line.substr(first, line.find_last_not_of(" \t\r") + 1 - first);
+            if (!split(line, step.args)) {
+                std::cerr << "Error. Line " << number << " of the batch has a quote that is not closed." << std::endl;
+                return false;
+            }
+            if (step.args.front() == "tempoclient") {
+                step.args.erase(step.args.begin());
+            }
+            steps.push_back(std::move(step));
+        }
+        return true;
+    }
+};
+
+/**
+ * @class WaitCondition
+ * @brief Condition of the wait command on the status or lid field, e.g. lid=opened or
+ * status!=running.
+ *
+ * After = or != comes a list of values separated by |, e.g. lid=closed|closedWithPlate. The
+ * condition holds when the field equals one of the values, or for != when it equals none of them.
+ */
+struct WaitCondition {
+    std::string field;                ///< status or lid.
+    std::vector<std::string> values;  ///< Values the field is compared with.
+    bool negate = false;              ///< True for !=.
+
+    /**
+     * @brief Parses a condition.
+     * @param text Condition such as lid=opened.
+     * @param condition Receives the condition.
+     * @return False if the text is not a condition on status or lid.
+     */
+    static bool parse(const std::string& text, WaitCondition& condition) {
+        auto equals = text.find('=');
+        if (equals == std::string::npos || equals == 0) {
+            return false;
+        }
+        condition.negate = text[equals - 1] == '!';
+        condition.field = text.substr(0, condition.negate ? equals - 1 : equals);
+        if (condition.field != "status" && condition.field != "lid") {
+            return false;
+        }
+        condition.values.clear();
+        for (size_t start = equals + 1; start <= text.size();) {
+            auto end = std::min(text.find('|', start), text.size());
+            if (end == start) {
+                return false;
+            }
+            condition.values.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+        return true;
+    }
+
+    /// Returns true if the condition holds for a value of the field.
+    [[nodiscard]] bool holds(const std::string& value) const {
+        bool found = std::find(values.begin(), values.end(), value) != values.end();
+        return found != negate;
+    }
+};
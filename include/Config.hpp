@@ -8,9 +8,13 @@
 // SPDX-License-Identifier: MIT
 //
 
+#pragma once
+
 #include "Settings.hpp"
+#include "TextFormatter.hpp"
 #include "CLI/CLI.hpp"
 #include "nlohmann/json.hpp"
+#include <filesystem>
 #include <iostream>
 
 using nlohmann::json;
@@ -64,6 +68,10 @@ public:
                 "--display", [this](const std::string& val) {
                     configJson["display"] = val;
                 }, "Set output display format - options: text or json");
+        configCommand.add_option_function<std::string>(
+                "--inventory", [this](const std::string& val) {
+                    configJson["inventory"] = val;
+                }, "Set the inventory file of named instruments.");
     }
 
     /**
@@ -77,7 +85,8 @@ public:
         std::map<const std::string, std::string*, std::less<>> stringValues = {
                 { "host", &settings.host },
                 { "password", &settings.password },
-                { "display", &settings.displayType }
+                { "display", &settings.displayType },
+                { "inventory", &settings.inventoryFile }
         };
 
         std::map<const std::string, std::int64_t*, std::less<>> intValues = {
@@ -87,9 +96,7 @@ public:
 
         if (std::ifstream file(configfileName, std::ios::in); file) {
             try {
-                std::stringstream strStream;
-                strStream << file.rdbuf(); //read the file
-                configJson = json::parse(strStream.str());
+                configJson = json::parse(file); // parse as the file is read, without a copy of its text
             } catch (json::exception& ex) {
                 std::cerr << ex.what() << std::endl;
                 return;
@@ -161,6 +168,16 @@ public:
 
     }
 
+    /**
+     * @brief Gets the time the config file was last written, so a long running process can tell when to read it again.
+     * @return The write time, or the earliest time if there is no config file.
+     */
+    [[nodiscard]] std::filesystem::file_time_type modified() const {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(configfileName, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+
     /**
      * @brief Stores config values to file.
      */
@@ -190,10 +207,6 @@ public:
      * @return String with json formatting removed.
      */
     static std::string& formatResponseForTextDisplay(std::string& res) {
-        const std::string notPrint = "[]{}\",";
-        res.erase(remove_if(res.begin(), res.end(), [&notPrint](const char& c) {
-            return notPrint.find(c) != std::string::npos;
-        }), res.end());
-        return res;
+        return TextFormatter::stripJson(res);
     }
 };
@@ -0,0 +1,454 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#if defined(_WIN32)
+#error "Daemon uses Unix domain sockets; the Windows build runs every command in its own process."
+#endif
+
+#include "nlohmann/json.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using nlohmann::json;
+
+/**
+ * @class Daemon
+ * @brief Serves tempoclient commands over a Unix domain socket, and forwards commands to it.
+ *
+ * The daemon keeps the parsed configuration and the connections to the instruments open between
+ * commands, so a script that runs tempoclient many times pays for a socket round-trip instead of
+ * starting a process, reading config.json and connecting to the instrument each time.
+ *
+ * Each message on the socket is a frame: a type byte, a 4 byte little-endian length, and the
+ * payload. The command line sends one request frame holding the working directory and the
+ * arguments as JSON. The daemon answers with stdout and stderr frames as the command writes its
+ * output, and ends with an exit frame holding the exit code. If the working directory differs
+ * from the daemon's, it answers with a declined frame instead, and the command line runs the
+ * command itself, so relative paths and config.json always mean the same files.
+ *
+ * Commands are served one at a time. The socket is created with access for the owner only.
+ */
+class Daemon {
+
+public:
+
+    /// Runs one command; takes the arguments after the program name and returns the exit code.
+    using Handler = std::function<int(const std::vector<std::string>& args)>;
+
+private:
+
+    /// Kinds of frames on the socket.
+    enum FrameType : char {
+        requestFrame = 'r',   ///< Working directory and arguments, from the command line.
+        outputFrame = 'o',    ///< Bytes written to stdout.
+        errorFrame = 'e',     ///< Bytes written to stderr.
+        exitFrame = 'x',      ///< Exit code as decimal text; the last frame.
+        declinedFrame = 'd'   ///< The daemon will not run the command; the reason is the payload.
+    };
+
+    /// Longest request frame accepted by the daemon.
+    static const uint32_t maxRequest = 1 << 20;
+    /// Seconds the daemon waits for a request once a command line has connected.
+    static const int requestTimeout = 5;
+
+    /// Path of the socket, also used by the signal handler to remove it.
+    static inline char socketFile[sizeof(sockaddr_un::sun_path)] = {};
+    /// Set by SIGINT or SIGTERM to stop accepting commands.
+    static inline volatile std::sig_atomic_t stopping = 0;
+
+    /// Path of the socket.
+    std::string path;
+    /// Runs each command.
+    Handler handler;
+
+    /**
+     * @class FrameBuffer
+     * @brief Stream buffer that sends what is written to it as frames of one type.
+     */
+    class FrameBuffer : public std::streambuf {
+
+        /// Socket of the command line.
+        int fd;
+        /// Frame type of the output.
+        char type;
+        /// Output not sent yet.
+        char buffer[8192];
+
+    protected:
+
+        int overflow(int c) override {
+            if (sync() != 0) {
+                return traits_type::eof();
+            }
+            if (c != traits_type::eof()) {
+                *pptr() = static_cast<char>(c);
+                pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        int sync() override {
+            auto length = static_cast<size_t>(pptr() - pbase());
+            setp(buffer, buffer + sizeof(buffer));
+            // a command line that went away is not an error of the command; the output is dropped
+            if (length > 0) {
+                sendFrame(fd, type, std::string_view(buffer, length));
+            }
+            return 0;
+        }
+
+    public:
+
+        FrameBuffer(int fd_, char type_) : fd(fd_), type(type_) {
+            setp(buffer, buffer + sizeof(buffer));
+        }
+    };
+
+    /// Writes all of bytes to a socket.
+    static bool writeAll(int fd, const char* bytes, size_t length) {
+        while (length > 0) {
+            auto written = ::send(fd, bytes, length, MSG_NOSIGNAL);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            length -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    /// Reads exactly length bytes from a socket.
+    static bool readAll(int fd, char* bytes, size_t length) {
+        while (length > 0) {
+            auto got = ::recv(fd, bytes, length, 0);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                return false;
+            }
+            bytes += got;
+            length -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    /// Sends one frame.
+    static bool sendFrame(int fd, char type, std::string_view payload) {
+        char header[5] = {type};
+        auto length = static_cast<uint32_t>(payload.size());
+        for (int i = 0; i < 4; ++i) {
+            header[1 + i] = static_cast<char>((length >> (8 * i)) & 0xff);
+        }
+        return writeAll(fd, header, sizeof(header)) && writeAll(fd, payload.data(), payload.size());
+    }
+
+    /// Reads one frame of at most limit bytes.
+    static bool readFrame(int fd, char& type, std::string& payload, uint32_t limit = UINT32_MAX) {
+        char header[5];
+        if (!readAll(fd, header, sizeof(header))) {
+            return false;
+        }
+        type = header[0];
+        uint32_t length = 0;
+        for (int i = 0; i < 4; ++i) {
+            length |= static_cast<uint32_t>(static_cast<unsigned char>(header[1 + i])) << (8 * i);
+        }
+        if (length > limit) {
+            return false;
+        }
+        payload.resize(length);
+        return readAll(fd, payload.data(), length);
+    }
+
+    /// Fills in the socket address for a path; returns false if the path is too long.
+    static bool address(const std::string& socketPath, sockaddr_un& socketAddress) {
+        socketAddress = sockaddr_un{};
+        socketAddress.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(socketAddress.sun_path)) {
+            return false;
+        }
+        std::memcpy(socketAddress.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        return true;
+    }
+
+    /// Connects to a socket; returns the descriptor, or -1 if nothing is listening.
+    static int connectTo(const std::string& socketPath) {
+        sockaddr_un socketAddress{};
+        if (!address(socketPath, socketAddress)) {
+            return -1;
+        }
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    /// Stops the accept loop; the socket is removed once the loop ends.
+    static void stop(int) {
+        stopping = 1;
+    }
+
+    /// Returns the working directory, or an empty string if it cannot be read.
+    static std::string workingDirectory() {
+        std::error_code error;
+        auto directory = std::filesystem::current_path(error);
+        return error ? std::string() : directory.string();
+    }
+
+    /// Reads one request from a command line, runs it and sends the output and exit code.
+    void serve(int fd) const {
+        timeval timeout{requestTimeout, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char type;
+        std::string payload;
+        if (!readFrame(fd, type, payload, maxRequest) || type != requestFrame) {
+            return;
+        }
+        json request = json::parse(payload, nullptr, false);
+        if (!request.is_object() || !request.contains("args") || !request["args"].is_array()) {
+            sendFrame(fd, declinedFrame, "malformed request");
+            return;
+        }
+        if (request.value("cwd", std::string()) != workingDirectory()) {
+            sendFrame(fd, declinedFrame, "different working directory");
+            return;
+        }
+        std::vector<std::string> args;
+        for (const auto& arg : request["args"]) {
+            args.push_back(arg.is_string() ? arg.get<std::string>() : arg.dump());
+        }
+
+        FrameBuffer output(fd, outputFrame);
+        FrameBuffer errors(fd, errorFrame);
+        auto* oldOutput = std::cout.rdbuf(&output);
+        auto* oldErrors = std::cerr.rdbuf(&errors);
+        int code;
+        try {
+            code = handler(args);
+        } catch (std::exception const& ex) {
+            std::cerr << std::endl << "Exception: " << ex.what() << std::endl;
+            code = 1;
+        } catch (...) {
+            std::cerr << std::endl << "Exception: unknown" << std::endl;
+            code = 1;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        std::cout.rdbuf(oldOutput);
+        std::cerr.rdbuf(oldErrors);
+        sendFrame(fd, exitFrame, std::to_string(code));
+    }
+
+public:
+
+    /**
+     * @brief Sets up a daemon. Nothing is opened until run is called.
+     * @param path_ Path of the socket.
+     * @param handler_ Runs each command.
+     */
+    Daemon(const std::string& path_, Handler handler_) : path(path_), handler(std::move(handler_)) {
+    }
+
+    /// Returns the socket path from the TEMPOCLIENT_SOCKET environment variable, or tempoclient.sock.
+    static std::string defaultPath() {
+        const char* value = std::getenv("TEMPOCLIENT_SOCKET");
+        return value != nullptr && *value != '\0' ? value : "tempoclient.sock";
+    }
+
+    /**
+     * @brief Returns the socket path of a command line, found the same way as the daemon finds its own.
+     *
+     * That is the --socket option if the arguments have it, and otherwise defaultPath.
+     * @param args Arguments after the program name.
+     */
+    static std::string socketPath(const std::vector<std::string>& args) {
+        static const std::string option = "--socket";
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == option && i + 1 < args.size()) {
+                return args[i + 1];
+            }
+            if (args[i].compare(0, option.size() + 1, option + "=") == 0) {
+                return args[i].substr(option.size() + 1);
+            }
+        }
+        return defaultPath();
+    }
+
+    /**
+     * @brief Checks whether a command can be sent to the daemon.
+     *
+     * Monitoring draws on the terminal of the command line, the daemon, proxy and exporter
+     * commands run until they are stopped, and the bench, batch, wait and dispatch commands
+     * would hold up the daemon's other clients, so these always run in the command line
+     * process, as does anything with --local.
+     * @param args Arguments after the program name.
+     */
+    static bool forwardable(const std::vector<std::string>& args) {
+        for (const auto& arg : args) {
+            if (arg == "daemon" || arg == "proxy" || arg == "exporter" || arg == "bench" || arg == "batch" || arg == "wait" || arg == "dispatch" || arg == "--monitor" || arg == "--local") {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Sends a command to a running daemon and copies its output to stdout and stderr.
+     * @param socketPath Path of the daemon's socket.
+     * @param args Arguments after the program name.
+     * @param exitCode Output parameter for the exit code of the command.
+     * @return True if the daemon ran the command, false if the command line must run it itself.
+     */
+    static bool forward(const std::string& socketPath, const std::vector<std::string>& args, int& exitCode) {
+        struct stat status{};
+        if (!forwardable(args) || ::stat(socketPath.c_str(), &status) != 0 || !S_ISSOCK(status.st_mode)) {
+            return false;
+        }
+        int fd = connectTo(socketPath);
+        if (fd < 0) {
+            return false;
+        }
+        json request;
+        request["cwd"] = workingDirectory();
+        request["args"] = args;
+        bool ran = false;
+        // arguments that are not UTF-8 are sent with replacement characters rather than failing
+        if (sendFrame(fd, requestFrame, request.dump(-1, ' ', false, json::error_handler_t::replace))) {
+            char type;
+            std::string payload;
+            bool started = false;
+            while (readFrame(fd, type, payload)) {
+                if (type == declinedFrame) {
+                    break;
+                }
+                started = true;
+                if (type == outputFrame) {
+                    std::cout.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                } else if (type == errorFrame) {
+                    std::cout.flush();
+                    std::cerr.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                } else if (type == exitFrame) {
+                    exitCode = std::atoi(payload.c_str());
+                    ran = true;
+                    break;
+                }
+            }
+            if (started && !ran) {
+                // the command may have run, so it is not run again
+                std::cerr << "Error. The daemon closed the connection before the command finished." << std::endl;
+                exitCode = 1;
+                ran = true;
+            }
+        }
+        std::cout.flush();
+        ::close(fd);
+        return ran;
+    }
+
+    /**
+     * @brief Serves commands until the process gets SIGINT or SIGTERM.
+     * @return True if the daemon stopped normally, false if the socket could not be opened.
+     */
+    bool run() {
+        sockaddr_un socketAddress{};
+        if (!address(path, socketAddress)) {
+            std::cerr << "Error. The socket path " << path << " is empty or too long." << std::endl;
+            return false;
+        }
+        if (int existing = connectTo(path); existing >= 0) {
+            ::close(existing);
+            std::cerr << "Error. A daemon is already listening on " << path << "." << std::endl;
+            return false;
+        }
+        // nothing answers on a socket left by a daemon that did not stop cleanly
+        ::unlink(path.c_str());
+
+        int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        auto oldMask = ::umask(0077);
+        bool bound = listener >= 0 && ::bind(listener, reinterpret_cast<sockaddr*>(&socketAddress), sizeof(socketAddress)) == 0;
+        ::umask(oldMask);
+        if (!bound || ::listen(listener, 16) != 0) {
+            std::cerr << "Error. Unable to listen on " << path << ": " << std::strerror(errno) << std::endl;
+            if (listener >= 0) {
+                ::close(listener);
+            }
+            return false;
+        }
+        std::memcpy(socketFile, socketAddress.sun_path, sizeof(socketFile));
+
+        struct sigaction action{};
+        action.sa_handler = stop;
+        sigemptyset(&action.sa_mask);
+        // no SA_RESTART, so a signal ends the wait in accept
+        struct sigaction previousInterrupt{};
+        struct sigaction previousTerminate{};
+        sigaction(SIGINT, &action, &previousInterrupt);
+        sigaction(SIGTERM, &action, &previousTerminate);
+        auto previousPipe = std::signal(SIGPIPE, SIG_IGN);
+
+        std::cerr << "Listening on " << path << std::endl;
+        int64_t served = 0;
+        stopping = 0;
+        while (stopping == 0) {
+            int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    // out of descriptors or memory for now; wait instead of spinning on accept
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                } else if (errno != EINTR && errno != ECONNABORTED) {
+                    std::cerr << "Error. Unable to accept a connection on " << path << ": " << std::strerror(errno) << std::endl;
+                    break;
+                }
+                continue;
+            }
+            serve(fd);
+            ::close(fd);
+            ++served;
+        }
+
+        ::close(listener);
+        ::unlink(socketFile);
+        sigaction(SIGINT, &previousInterrupt, nullptr);
+        sigaction(SIGTERM, &previousTerminate, nullptr);
+        std::signal(SIGPIPE, previousPipe);
+        std::cerr << "Stopped after " << served << " commands" << std::endl;
+        return true;
+    }
+};
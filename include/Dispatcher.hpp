@@ -0,0 +1,396 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "TempoClient.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class Dispatcher
+ * @brief Feeds a queue of runs to a pool of instruments, starting the next run on each
+ * instrument as soon as it is idle.
+ *
+ * Each instrument has its own thread and TempoClient, which polls /tempo/status every interval.
+ * When an instrument is idle, and its lid is in one of the ready states if any were given, the
+ * thread takes the run at the front of the queue and starts it. A run ends when the instrument
+ * is idle again after it was seen busy, or in error, which fails the run. A run that cannot be
+ * started goes back to the front of the queue for the next idle instrument, until it has
+ * failed to start the given number of times.
+ *
+ * The time of each instrument is split into busy (from starting one of the queue's runs until
+ * it is seen to end), unavailable (running something else, in error, or not answering) and
+ * idle. A run is seen to end up to one interval after it does, so the interval bounds the idle
+ * time between runs.
+ */
+class Dispatcher {
+
+public:
+
+    /// Clock for the run and instrument times.
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct Plate
+     * @brief One run of the queue.
+     */
+    struct Plate {
+        size_t index = 0;      ///< Position in the queue, from 1.
+        json run;              ///< Body of the POST that starts the run.
+        int32_t attempts = 0;  ///< Times the run failed to start.
+    };
+
+private:
+
+    /**
+     * @struct Record
+     * @brief What happened to one run of the queue.
+     */
+    struct Record {
+        std::string plateID;        ///< Plate ID of the run.
+        std::string host;           ///< Instrument the run was started on, if any.
+        std::string result = "queued"; ///< queued, running, completed or failed.
+        std::string error;          ///< Why the run failed.
+        double started = -1;        ///< Seconds from the start of the dispatch to the start of the run.
+        double seconds = 0;         ///< Seconds the run took, as seen by the polls.
+    };
+
+    /**
+     * @struct Instrument
+     * @brief Counts and times of one instrument.
+     */
+    struct Instrument {
+        std::string host;         ///< URL of the instrument.
+        int64_t started = 0;      ///< Runs started.
+        int64_t completed = 0;    ///< Runs that ended with the instrument idle.
+        int64_t failed = 0;       ///< Runs that failed to start or ended in error.
+        double busy = 0;          ///< Seconds running a run of the queue.
+        double unavailable = 0;   ///< Seconds running something else, in error or not answering.
+        std::string state;        ///< Last status seen.
+    };
+
+    std::vector<std::string> hosts;       ///< URLs of the instruments.
+    std::string password;                 ///< Password for the Automation user on every instrument.
+    int32_t waitTime;                     ///< Seconds to wait for each response.
+    std::chrono::duration<double> interval; ///< Time between the polls of each instrument.
+    std::vector<std::string> readyLids;   ///< Lid states an idle instrument can start a run in; empty for any.
+    int32_t maxAttempts;                  ///< Times a run may fail to start before it is failed.
+
+    std::mutex mutex;                     ///< Guards queue, records, instruments and active.
+    std::condition_variable wakeUp;       ///< Wakes the threads when stop is called.
+    std::deque<Plate> queue;              ///< Runs not started yet, in order.
+    std::vector<Record> records;          ///< What happened to each run, by index - 1.
+    std::vector<Instrument> instruments;  ///< Counts and times of each instrument, by index into hosts.
+    size_t active = 0;                    ///< Runs of the queue in progress.
+    std::atomic<bool> stopping{false};    ///< Set by stop to end the dispatch early.
+    Clock::time_point begin;              ///< Time the dispatch started.
+    double elapsed = 0;                   ///< Seconds from the start until the last run ended, after run.
+
+    /// Returns the seconds since the dispatch started.
+    [[nodiscard]] double since(Clock::time_point time) const {
+        return std::chrono::duration<double>(time - begin).count();
+    }
+
+    /// Prints one event of the dispatch to stderr.
+    void log(const std::string& host, const Plate& plate, const std::string& event) const {
+        std::cerr << "[" << plate.index << "] " << plate.run.value("plateID", "") << " " << event << " on " << host << std::endl;
+    }
+
+    /// Returns true if there is nothing left to start or wait for.
+    [[nodiscard]] bool finished() const {
+        return queue.empty() && active == 0;
+    }
+
+    /**
+     * @brief Waits for the interval or until stop is called.
+     * @return False if the dispatch is stopping.
+     */
+    bool pause() {
+        std::unique_lock lock(mutex);
+        wakeUp.wait_for(lock, interval, [this]() { return stopping.load(); });
+        return !stopping;
+    }
+
+    /**
+     * @brief Returns true if the instrument is idle with its lid in a ready state.
+     * @param tempoClient Client of the instrument, with the status response just read.
+     */
+    bool ready(TempoClient& tempoClient, const std::string& status) {
+        if (status != "idle") {
+            return false;
+        }
+        if (readyLids.empty()) {
+            return true;
+        }
+        tempoClient.lid();
+        return tempoClient.statusOK()
+               && std::find(readyLids.begin(), readyLids.end(), tempoClient.getLidStatus()) != readyLids.end();
+    }
+
+    /**
+     * @brief Records the end of the run on an instrument, if the status shows it has ended.
+     * @param status Status just read, or empty if the request failed.
+     * @return True if the run ended.
+     */
+    bool ended(Instrument& instrument, Plate& plate, const std::string& status, bool seenBusy, Clock::time_point runStart,
+               Clock::time_point now) {
+        Record& record = records[plate.index - 1];
+        if (status == "error") {
+            record.result = "failed";
+            record.error = "The instrument reported an error during the run.";
+        } else if (status == "idle" && seenBusy) {
+            record.result = "completed";
+        } else if (status == "idle" && now - runStart > std::chrono::seconds(30)) {
+            record.result = "failed";
+            record.error = "The instrument stayed idle after the run was started.";
+        } else {
+            return false;
+        }
+        record.seconds = since(now) - record.started;
+        ++(record.result == "completed" ? instrument.completed : instrument.failed);
+        log(instrument.host, plate, record.result);
+        --active;
+        return true;
+    }
+
+    /**
+     * @brief Starts the runs of the queue on one instrument until the queue is empty and the last
+     * run on it has ended, or stop is called.
+     * @param number Index of the instrument in hosts.
+     */
+    void feed(size_t number) {
+        TempoClient tempoClient(hosts[number], password, waitTime);
+        std::optional<Plate> plate;    // run of the queue on this instrument
+        Clock::time_point runStart;
+        bool seenBusy = false;
+        auto last = Clock::now();
+        while (true) {
+            tempoClient.status();
+            auto now = Clock::now();
+            std::string status = tempoClient.statusOK() ? tempoClient.getRunStatus() : "";
+            double seconds = std::chrono::duration<double>(now - last).count();
+            last = now;
+            {
+                std::scoped_lock lock(mutex);
+                Instrument& instrument = instruments[number];
+                instrument.state = status.empty() ? "unreachable" : status;
+                if (plate) {
+                    instrument.busy += seconds;
+                    if (ended(instrument, *plate, status, seenBusy, runStart, now)) {
+                        plate.reset();
+                    } else {
+                        seenBusy = seenBusy || (!status.empty() && status != "idle");
+                    }
+                } else if (status != "idle") {
+                    instrument.unavailable += seconds;
+                }
+                if (stopping || (!plate && finished())) {
+                    break;
+                }
+            }
+            if (!plate && ready(tempoClient, status)) {
+                {
+                    std::scoped_lock lock(mutex);
+                    if (!queue.empty()) {
+                        plate = std::move(queue.front());
+                        queue.pop_front();
+                        ++active;
+                    }
+                }
+                if (plate) {
+                    runStart = Clock::now();
+                    tempoClient.run(plate->run);
+                    start(number, tempoClient, plate, runStart);
+                    seenBusy = false;
+                }
+            }
+            if (!pause()) {
+                break;
+            }
+        }
+        wakeUp.notify_all();
+    }
+
+    /**
+     * @brief Records the start of a run, or puts it back in the queue if it did not start.
+     * @param plate Run just sent to the instrument; reset if it did not start.
+     */
+    void start(size_t number, TempoClient& tempoClient, std::optional<Plate>& plate, Clock::time_point runStart) {
+        std::scoped_lock lock(mutex);
+        Instrument& instrument = instruments[number];
+        Record& record = records[plate->index - 1];
+        record.host = instrument.host;
+        if (tempoClient.statusOK()) {
+            record.result = "running";
+            record.started = since(runStart);
+            ++instrument.started;
+            log(instrument.host, *plate, "started");
+            return;
+        }
+        std::string error = tempoClient.httpStatus() != 0 ? "HTTP status " + std::to_string(tempoClient.httpStatus())
+                                                          : httplib::to_string(tempoClient.error());
+        log(instrument.host, *plate, "did not start: " + error);
+        --active;
+        if (++plate->attempts >= maxAttempts) {
+            record.result = "failed";
+            record.error = "The run did not start: " + error + ".";
+            ++instrument.failed;
+        } else {
+            // another instrument may be able to start it
+            record.host.clear();
+            queue.push_front(std::move(*plate));
+        }
+        plate.reset();
+    }
+
+    /// Returns seconds rounded to one decimal.
+    static double round(double seconds) {
+        return std::round(seconds * 10) / 10;
+    }
+
+public:
+
+    /**
+     * @brief Sets up the dispatch. No requests are made until run is called.
+     * @param hosts_ URLs of the instruments.
+     * @param password_ Password for the Automation user on every instrument.
+     * @param waitTime_ Seconds to wait for each response.
+     * @param interval_ Seconds between the polls of each instrument.
+     * @param readyLids_ Lid states an idle instrument can start a run in; empty for any.
+     * @param maxAttempts_ Times a run may fail to start before it is failed.
+     */
+    Dispatcher(std::vector<std::string> hosts_, std::string password_, int32_t waitTime_, double interval_,
+               std::vector<std::string> readyLids_, int32_t maxAttempts_) :
+            hosts(std::move(hosts_)),
+            password(std::move(password_)),
+            waitTime(waitTime_),
+            interval(interval_),
+            readyLids(std::move(readyLids_)),
+            maxAttempts(std::max(maxAttempts_, 1)) {
+    }
+
+    /**
+     * @brief Adds a run to the end of the queue.
+     * @param run Body of the POST to /tempo/protocol-run that starts the run.
+     */
+    void add(json run) {
+        Plate plate;
+        plate.index = records.size() + 1;
+        plate.run = std::move(run);
+        records.emplace_back();
+        records.back().plateID = plate.run.value("plateID", "");
+        queue.push_back(std::move(plate));
+    }
+
+    /**
+     * @brief Starts the runs of the queue on the instruments, and returns when every run has
+     * ended or stop is called.
+     * @return False if there are no instruments or nothing in the queue.
+     */
+    bool run() {
+        if (hosts.empty() || queue.empty()) {
+            return false;
+        }
+        begin = Clock::now();
+        instruments.assign(hosts.size(), Instrument());
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(hosts.size());
+            for (size_t i = 0; i < hosts.size(); ++i) {
+                instruments[i].host = hosts[i];
+                threads.emplace_back([this, i]() {
+                    feed(i);
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+        elapsed = since(Clock::now());
+        return true;
+    }
+
+    /// Makes run return after the next polls; runs in progress go on. Safe to call from any thread.
+    void stop() {
+        {
+            std::scoped_lock lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+    }
+
+    /// Returns true if every run of the queue completed.
+    [[nodiscard]] bool succeeded() const {
+        return std::all_of(records.begin(), records.end(), [](const Record& record) {
+            return record.result == "completed";
+        });
+    }
+
+    /**
+     * @brief Returns the results of the last run: the counts of runs, the plates per hour, the
+     * utilisation of each instrument, and what happened to each run.
+     */
+    [[nodiscard]] json results() const {
+        json result;
+        std::map<std::string, int64_t> counts = {{"completed", 0}, {"failed", 0}, {"running", 0}, {"queued", 0}};
+        json runs = json::array();
+        for (size_t i = 0; i < records.size(); ++i) {
+            const Record& record = records[i];
+            ++counts[record.result];
+            json entry = {{"index", i + 1}, {"plateID", record.plateID}, {"result", record.result}};
+            if (!record.host.empty()) {
+                entry["host"] = record.host;
+            }
+            if (record.started >= 0) {
+                entry["started"] = round(record.started);
+            }
+            if (record.result == "completed" || (record.result == "failed" && record.started >= 0)) {
+                entry["seconds"] = round(record.seconds);
+            }
+            if (!record.error.empty()) {
+                entry["error"] = record.error;
+            }
+            runs.push_back(entry);
+        }
+        result["runs"] = runs;
+        for (const auto& [name, count] : counts) {
+            result[name] = count;
+        }
+        result["elapsed"] = round(elapsed);
+        result["platesPerHour"] = elapsed > 0 ? round(static_cast<double>(counts["completed"]) * 3600 / elapsed) : 0.0;
+        json hostsJson = json::object();
+        for (const Instrument& instrument : instruments) {
+            double idle = std::max(0.0, elapsed - instrument.busy - instrument.unavailable);
+            hostsJson[instrument.host] = {{"started", instrument.started}, {"completed", instrument.completed},
+                                          {"failed", instrument.failed}, {"busySeconds", round(instrument.busy)},
+                                          {"idleSeconds", round(idle)}, {"unavailableSeconds", round(instrument.unavailable)},
+                                          {"utilization", elapsed > 0 ? std::round(instrument.busy / elapsed * 1000) / 1000 : 0.0},
+                                          {"state", instrument.state}};
+        }
+        result["instruments"] = hostsJson;
+        return result;
+    }
+};
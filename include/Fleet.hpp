@@ -0,0 +1,96 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "TempoClient.hpp"
+#include "WorkerPool.hpp"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class Fleet
+ * @brief Sends the same request to many PTC Tempo instruments at once.
+ *
+ * Each instrument gets its own TempoClient, and the calls run on a WorkerPool so that the
+ * number of open connections is bounded. A sweep of the fleet takes about as long as the
+ * slowest instrument takes to respond, instead of the sum of all response times.
+ *
+ * The results are merged into a single JSON object keyed by host. An instrument that cannot
+ * be reached or returns an error only affects its own entry.
+ */
+class Fleet {
+
+    /// URLs for all the instruments in the fleet.
+    const std::vector<std::string>& hosts;
+    /// Password for Automation user; the same for all instruments.
+    const std::string& password;
+    /// Number of seconds to wait for a response from each instrument.
+    int32_t waitTime;
+    /// Maximum number of instruments called at the same time.
+    size_t jobs;
+
+public:
+
+    /// Function that makes one request with the TempoClient for one instrument.
+    using Request = std::function<void(TempoClient&)>;
+
+    /**
+     * @brief Sets up the fleet. No calls are made until run is called.
+     * @param hosts_ URLs for PTC Tempo instruments.
+     * @param password_ Plaintext password for Automation user on every instrument.
+     * @param waitTime_ Number of seconds to wait for a response.
+     * @param jobs_ Maximum number of instruments to call at the same time.
+     */
+    Fleet(const std::vector<std::string>& hosts_, const std::string& password_, int32_t waitTime_, size_t jobs_) :
+            hosts(hosts_),
+            password(password_),
+            waitTime(waitTime_),
+            jobs(jobs_) {
+    }
+
+    /**
+     * @brief Calls the request function for every host and merges the responses.
+     * @param request Function that makes a request on the TempoClient it is given.
+     * @param results Output parameter; JSON object with one response object per host.
+     * @return True if every instrument returned status 200.
+     */
+    bool run(const Request& request, json& results) const {
+        std::mutex resultsMutex;
+        bool success = true;
+        results = json::object();
+        {
+            WorkerPool pool(jobs < hosts.size() ? jobs : hosts.size());
+            for (const auto& host : hosts) {
+                pool.post([&, host]() {
+                    json response;
+                    bool ok;
+                    try {
+                        TempoClient tempoClient(host, password, waitTime);
+                        request(tempoClient);
+                        ok = tempoClient.result(response);
+                    } catch (std::exception& ex) {
+                        response["error"] = ex.what();
+                        ok = false;
+                    }
+                    std::scoped_lock lock(resultsMutex);
+                    results[host] = std::move(response);
+                    success = success && ok;
+                });
+            }
+            pool.wait();
+        }
+        return success;
+    }
+};
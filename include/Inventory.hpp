@@ -0,0 +1,514 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "MappedFile.hpp"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class Inventory
+ * @brief Named instruments with groups and tags, looked up through a compiled index that is
+ * mapped into memory.
+ *
+ * The inventory is written as JSON, one entry per instrument:
+ * @code
+ * {"instruments": [{"name": "lab1-a", "host": "http://10.0.1.11:8080", "groups": ["lab1", "room101"], "tags": ["qpcr"]}]}
+ * @endcode
+ *
+ * The JSON is compiled into a binary index the first time it is used after it changed, so
+ * commands do not parse it. The index holds:
+ * - a header with the counts, the offsets of the other parts, and the size and write time of
+ *   the JSON it was compiled from,
+ * - a fixed size record for each instrument, in the order of the JSON,
+ * - an open addressing hash table with a slot for each instrument name, group and tag,
+ * - for each slot, the list of the instruments it names,
+ * - the strings of the names, hosts, groups and tags.
+ *
+ * A lookup hashes the name and probes the table, so it reads a few pages of the mapping
+ * whatever the size of the inventory. All values are little-endian and every offset is checked
+ * against the size of the file, so a damaged index is compiled again instead of read. The index
+ * is compiled again whenever the size or write time of the JSON differs from those in its
+ * header, so a copy of an older inventory over a newer one is noticed too.
+ */
+class Inventory {
+
+    /// Marks the start of an index file.
+    static constexpr char magic[4] = {'T', 'I', 'N', 'V'};
+    /// Format version written after the magic.
+    static constexpr uint32_t version = 2;
+    /// Bytes in the header: the magic, seven 32 bit values, and the size and write time of the JSON as 64 bit values.
+    static constexpr size_t headerSize = 48;
+    /// Bytes in the record of an instrument: the offset and length of four strings.
+    static constexpr size_t recordSize = 32;
+    /// Bytes in a slot of the hash table: the hash, the key offset and length, and the list offset.
+    static constexpr size_t slotSize = 16;
+
+    /// Index file, or nullptr if none could be read.
+    std::unique_ptr<MappedFile> file;
+    uint32_t instrumentCount = 0;  ///< Number of instruments.
+    uint32_t slotCount = 0;        ///< Number of slots in the hash table; a power of two.
+    uint32_t recordsOffset = 0;    ///< Offset of the first instrument record.
+    uint32_t slotsOffset = 0;      ///< Offset of the hash table.
+
+    /**
+     * @struct Stamp
+     * @brief Size and write time of a JSON inventory, kept in the index compiled from it.
+     */
+    struct Stamp {
+        uint64_t size = 0;  ///< Size in bytes.
+        uint64_t time = 0;  ///< Write time in ticks of the file clock.
+
+        bool operator==(const Stamp& other) const {
+            return size == other.size && time == other.time;
+        }
+    };
+
+    /// Reads the size and write time of a file; error is set if it cannot be read.
+    static Stamp stamp(const std::string& path, std::error_code& error) {
+        Stamp result;
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error) {
+            return result;
+        }
+        result.size = std::filesystem::file_size(path, error);
+        result.time = static_cast<uint64_t>(time.time_since_epoch().count());
+        return result;
+    }
+
+    /// Size and write time of the JSON inventory the index was compiled from.
+    Stamp compiledFrom;
+
+    /// Reads a little-endian 32 bit value.
+    static uint32_t read32(const char* bytes) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    /// Appends a little-endian 32 bit value.
+    static void write32(std::string& out, uint32_t value) {
+        for (size_t i = 0; i < 4; ++i) {
+            out += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    /// Reads a little-endian 64 bit value.
+    static uint64_t read64(const char* bytes) {
+        return read32(bytes) | static_cast<uint64_t>(read32(bytes + 4)) << 32;
+    }
+
+    /// Appends a little-endian 64 bit value.
+    static void write64(std::string& out, uint64_t value) {
+        write32(out, static_cast<uint32_t>(value));
+        write32(out, static_cast<uint32_t>(value >> 32));
+    }
+
+    /// Overwrites a little-endian 32 bit value at offset.
+    static void write32(std::string& out, size_t offset, uint32_t value) {
+        for (size_t i = 0; i < 4; ++i) {
+            out[offset + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    /// Returns the FNV-1a hash of a key, never 0, which marks an empty slot.
+    static uint32_t hash(std::string_view key) {
+        uint32_t value = 2166136261u;
+        for (unsigned char c : key) {
+            value = (value ^ c) * 16777619u;
+        }
+        return value == 0 ? 1 : value;
+    }
+
+    /// Returns the key of the hash table for a name; kind is 'i' for instruments, 'g' for groups and 't' for tags.
+    static std::string key(char kind, std::string_view name) {
+        std::string text(1, kind);
+        text += ':';
+        text += name;
+        return text;
+    }
+
+    /// Returns true if [offset, offset + length) lies inside the index.
+    [[nodiscard]] bool inside(uint64_t offset, uint64_t length) const {
+        return offset + length <= file->size();
+    }
+
+    /// Returns the string at the offset and length stored at position in the index, or an empty string if it is outside.
+    [[nodiscard]] std::string_view text(size_t position) const {
+        uint32_t offset = read32(file->data() + position);
+        uint32_t length = read32(file->data() + position + 4);
+        if (!inside(offset, length)) {
+            return {};
+        }
+        return {file->data() + offset, length};
+    }
+
+    /**
+     * @brief Maps an index and checks its header and the bounds of its tables.
+     * @return False if the index is missing, of another version, or damaged.
+     */
+    bool map(const std::string& indexPath) {
+        file = std::make_unique<MappedFile>(indexPath);
+        if (!file->isOpen() || file->size() < headerSize || std::memcmp(file->data(), magic, sizeof(magic)) != 0
+            || read32(file->data() + 4) != version) {
+            file.reset();
+            return false;
+        }
+        const char* header = file->data();
+        instrumentCount = read32(header + 8);
+        slotCount = read32(header + 12);
+        recordsOffset = read32(header + 16);
+        slotsOffset = read32(header + 20);
+        compiledFrom = Stamp{read64(header + 32), read64(header + 40)};
+        bool valid = slotCount > 0 && (slotCount & (slotCount - 1)) == 0
+                     && inside(recordsOffset, static_cast<uint64_t>(instrumentCount) * recordSize)
+                     && inside(slotsOffset, static_cast<uint64_t>(slotCount) * slotSize);
+        if (!valid) {
+            file.reset();
+        }
+        return valid;
+    }
+
+public:
+
+    /**
+     * @struct Instrument
+     * @brief One instrument of the inventory. The views point into the mapped index.
+     */
+    struct Instrument {
+        std::string_view name;    ///< Name used with --instrument.
+        std::string_view host;    ///< URL of the instrument.
+        std::string_view groups;  ///< Groups of the instrument, separated by commas.
+        std::string_view tags;    ///< Tags of the instrument, separated by commas.
+    };
+
+    /**
+     * @brief Compiles the JSON inventory into an index. The old index is replaced only once
+     * the new one is complete.
+     * @param sourcePath Path of the JSON inventory.
+     * @param indexPath Path of the index to write.
+     * @return False if the inventory could not be read or is not valid; this emits a message to stderr.
+     */
+    static bool compile(const std::string& sourcePath, const std::string& indexPath) {
+        // read before the JSON, so a change while it is read makes the index stale
+        std::error_code stampError;
+        Stamp sourceStamp = stamp(sourcePath, stampError);
+        json source;
+        if (std::ifstream in(sourcePath, std::ios::in); in) {
+            try {
+                std::stringstream text;
+                text << in.rdbuf();
+                source = json::parse(text.str());
+            } catch (json::exception& ex) {
+                std::cerr << "Error. Could not parse the inventory " << sourcePath << ": " << ex.what() << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Error. Could not read the inventory " << sourcePath << "." << std::endl;
+            return false;
+        }
+        if (!source.is_object() || !source.contains("instruments") || !source["instruments"].is_array()) {
+            std::cerr << "Error. The inventory " << sourcePath << " needs an \"instruments\" list." << std::endl;
+            return false;
+        }
+
+        // instruments of each key, in the order of the inventory
+        std::vector<std::pair<std::string, std::vector<uint32_t>>> keys;
+        std::map<std::string, size_t> keyIndex;
+        auto addKey = [&](const std::string& name, uint32_t instrument) {
+            auto [found, added] = keyIndex.emplace(name, keys.size());
+            if (added) {
+                keys.emplace_back(name, std::vector<uint32_t>());
+            }
+            auto& list = keys[found->second].second;
+            if (list.empty() || list.back() != instrument) {
+                list.push_back(instrument);
+            }
+        };
+        auto joined = [](const json& list, const std::string& field, std::string& out) {
+            out.clear();
+            if (!list.contains(field)) {
+                return true;
+            }
+            if (!list[field].is_array()) {
+                return false;
+            }
+            for (const auto& value : list[field]) {
+                if (!value.is_string() || value.get<std::string>().empty() || value.get<std::string>().find(',') != std::string::npos) {
+                    return false;
+                }
+                out += (out.empty() ? "" : ",") + value.get<std::string>();
+            }
+            return true;
+        };
+
+        std::string strings;
+        std::string records;
+        uint32_t count = 0;
+        std::vector<std::array<uint32_t, 8>> fields;
+        for (const auto& entry : source["instruments"]) {
+            std::string name = entry.is_object() ? entry.value("name", "") : "";
+            std::string host = entry.is_object() ? entry.value("host", "") : "";
+            std::string groups;
+            std::string tags;
+            if (name.empty() || host.empty() || name.find(',') != std::string::npos || !joined(entry, "groups", groups)
+                || !joined(entry, "tags", tags)) {
+                std::cerr << "Error. Instrument " << count + 1 << " of the inventory needs a name and a host, and its groups and tags must be lists of names. Names cannot hold commas." << std::endl;
+                return false;
+            }
+            if (keyIndex.count(key('i', name)) != 0) {
+                std::cerr << "Error. The inventory has more than one instrument named " << name << "." << std::endl;
+                return false;
+            }
+            addKey(key('i', name), count);
+            for (const auto& group : entry.value("groups", json::array())) {
+                addKey(key('g', group.get<std::string>()), count);
+            }
+            for (const auto& tag : entry.value("tags", json::array())) {
+                addKey(key('t', tag.get<std::string>()), count);
+            }
+            std::array<uint32_t, 8> record{};
+            size_t field = 0;
+            for (const std::string* value : {&name, &host, &groups, &tags}) {
+                record[field++] = static_cast<uint32_t>(strings.size());
+                record[field++] = static_cast<uint32_t>(value->size());
+                strings += *value;
+            }
+            fields.push_back(record);
+            ++count;
+        }
+
+        uint32_t slots = 8;
+        while (slots < keys.size() * 2) {
+            slots *= 2;
+        }
+        size_t listsSize = 0;
+        for (const auto& [name, list] : keys) {
+            listsSize += 4 * (list.size() + 1);
+        }
+        // keys go after the instrument strings
+        std::vector<uint32_t> keyOffsets;
+        for (const auto& [name, list] : keys) {
+            keyOffsets.push_back(static_cast<uint32_t>(strings.size()));
+            strings += name;
+        }
+        uint32_t recordsAt = headerSize;
+        uint32_t slotsAt = recordsAt + count * recordSize;
+        uint32_t listsAt = slotsAt + slots * slotSize;
+        auto stringsAt = static_cast<uint32_t>(listsAt + listsSize);
+        if (static_cast<uint64_t>(stringsAt) + strings.size() > UINT32_MAX) {
+            std::cerr << "Error. The inventory is too large to index." << std::endl;
+            return false;
+        }
+
+        std::string index(magic, sizeof(magic));
+        write32(index, version);
+        write32(index, count);
+        write32(index, slots);
+        write32(index, recordsAt);
+        write32(index, slotsAt);
+        write32(index, listsAt);
+        write32(index, stringsAt);
+        write64(index, sourceStamp.size);
+        write64(index, sourceStamp.time);
+        for (const auto& record : fields) {
+            for (size_t i = 0; i < record.size(); i += 2) {
+                write32(index, stringsAt + record[i]);
+                write32(index, record[i + 1]);
+            }
+        }
+        index.append(static_cast<size_t>(slots) * slotSize, '\0');
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const auto& [name, list] = keys[i];
+            uint32_t keyHash = hash(name);
+            uint32_t slot = keyHash & (slots - 1);
+            while (read32(index.data() + slotsAt + slot * slotSize) != 0) {
+                slot = (slot + 1) & (slots - 1);
+            }
+            size_t at = slotsAt + slot * slotSize;
+            write32(index, at, keyHash);
+            write32(index, at + 4, stringsAt + keyOffsets[i]);
+            write32(index, at + 8, static_cast<uint32_t>(name.size()));
+            write32(index, at + 12, static_cast<uint32_t>(index.size()));
+            write32(index, static_cast<uint32_t>(list.size()));
+            for (uint32_t instrument : list) {
+                write32(index, instrument);
+            }
+        }
+        index += strings;
+
+        // a name of its own, so commands compiling at the same time do not write into one file
+        std::random_device random;
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%08x%08x.partial", random(), random());
+        std::string partial = indexPath + suffix;
+        {
+            std::ofstream out(partial, std::ios::out | std::ios::binary | std::ios::trunc);
+            out.write(index.data(), static_cast<std::streamsize>(index.size()));
+            out.close();
+            if (!out) {
+                std::error_code error;
+                std::filesystem::remove(partial, error);
+                std::cerr << "Error. Could not write the inventory index " << indexPath << "." << std::endl;
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(partial, indexPath, error);
+        if (error) {
+            std::filesystem::remove(partial, error);
+            std::cerr << "Error. Could not write the inventory index " << indexPath << "." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Opens the index of an inventory, compiling it first if the JSON inventory changed
+     * since the index was compiled, or the index cannot be read. Use isOpen to check for success.
+     * @param sourcePath Path of the JSON inventory.
+     * @param indexPath Path of the index.
+     */
+    Inventory(const std::string& sourcePath, const std::string& indexPath) {
+        std::error_code sourceError;
+        Stamp sourceStamp = stamp(sourcePath, sourceError);
+        // without the JSON, the index is used as it is
+        if (map(indexPath) && (sourceError || compiledFrom == sourceStamp)) {
+            return;
+        }
+        file.reset();
+        if (!sourceError && compile(sourcePath, indexPath)) {
+            map(indexPath);
+        } else if (sourceError) {
+            std::cerr << "Error. There is no inventory " << sourcePath << "." << std::endl;
+        }
+    }
+
+    /// Returns true if the index is mapped.
+    [[nodiscard]] bool isOpen() const {
+        return file != nullptr;
+    }
+
+    /// Returns the number of instruments.
+    [[nodiscard]] size_t size() const {
+        return instrumentCount;
+    }
+
+    /// Returns an instrument by its position in the inventory.
+    [[nodiscard]] Instrument instrument(size_t position) const {
+        size_t record = recordsOffset + position * recordSize;
+        return {text(record), text(record + 8), text(record + 16), text(record + 24)};
+    }
+
+    /**
+     * @brief Finds the instruments with a name, or in a group, or with a tag.
+     * @param kind 'i' for an instrument name, 'g' for a group or 't' for a tag.
+     * @param name Name to look up.
+     * @param positions Receives the positions of the instruments in the inventory, in order.
+     * @return False if nothing has the name.
+     */
+    bool find(char kind, std::string_view name, std::vector<uint32_t>& positions) const {
+        positions.clear();
+        std::string wanted = key(kind, name);
+        uint32_t wantedHash = hash(wanted);
+        uint32_t slot = wantedHash & (slotCount - 1);
+        for (uint32_t probes = 0; probes < slotCount; ++probes, slot = (slot + 1) & (slotCount - 1)) {
+            size_t at = slotsOffset + static_cast<size_t>(slot) * slotSize;
+            uint32_t slotHash = read32(file->data() + at);
+            if (slotHash == 0) {
+                return false;
+            }
+            if (slotHash != wantedHash || text(at + 4) != wanted) {
+                continue;
+            }
+            uint32_t list = read32(file->data() + at + 12);
+            if (!inside(list, 4)) {
+                return false;
+            }
+            uint32_t count = read32(file->data() + list);
+            if (!inside(list + 4, static_cast<uint64_t>(count) * 4)) {
+                return false;
+            }
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t position = read32(file->data() + list + 4 + 4 * i);
+                if (position < instrumentCount) {
+                    positions.push_back(position);
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Returns the instruments named, or in the groups, or with the tags given, each once,
+     * in the order of the inventory.
+     * @param names Instrument names.
+     * @param groups Group names.
+     * @param tags Tag names.
+     * @param selected Receives the positions of the instruments.
+     * @return False if a name, group or tag is not in the inventory; this emits a message to stderr.
+     */
+    bool select(const std::vector<std::string>& names, const std::vector<std::string>& groups,
+                const std::vector<std::string>& tags, std::vector<uint32_t>& selected) const {
+        std::set<uint32_t> found;
+        std::vector<uint32_t> positions;
+        for (const auto& [kind, list, what] : {std::tuple{'i', &names, "instrument"}, std::tuple{'g', &groups, "group"},
+                                               std::tuple{'t', &tags, "tag"}}) {
+            for (const auto& name : *list) {
+                if (!find(kind, name, positions)) {
+                    std::cerr << "Error. There is no " << what << " named " << name << " in the inventory." << std::endl;
+                    return false;
+                }
+                found.insert(positions.begin(), positions.end());
+            }
+        }
+        selected.assign(found.begin(), found.end());
+        return true;
+    }
+
+    /// Returns an instrument as JSON, with its groups and tags as lists.
+    [[nodiscard]] json toJson(size_t position) const {
+        Instrument entry = instrument(position);
+        auto list = [](std::string_view joined) {
+            json values = json::array();
+            while (!joined.empty()) {
+                auto comma = joined.find(',');
+                values.push_back(std::string(joined.substr(0, comma)));
+                joined = comma == std::string_view::npos ? std::string_view() : joined.substr(comma + 1);
+            }
+            return values;
+        };
+        return {{"name", std::string(entry.name)}, {"host", std::string(entry.host)}, {"groups", list(entry.groups)},
+                {"tags", list(entry.tags)}};
+    }
+};
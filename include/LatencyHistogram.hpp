@@ -0,0 +1,141 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @class LatencyHistogram
+ * @brief Counts latencies in buckets whose width grows with the value, as an HDR histogram does.
+ *
+ * Values below 128 each have their own bucket. Above that, every power of two is split into 64
+ * buckets, so a percentile is within 1/64 of the recorded value however large it is, and a
+ * histogram that spans microseconds to hours holds under 2,000 counts. Recording is a few shifts
+ * and an increment. The unit is up to the caller; RequestStats records microseconds.
+ */
+class LatencyHistogram {
+
+    /// Values below this have a bucket each.
+    static constexpr int64_t subBucketCount = 128;
+    /// Buckets in each power of two above subBucketCount.
+    static constexpr int64_t halfCount = subBucketCount / 2;
+
+    /// Count of each bucket; grows to the bucket of the largest value.
+    std::vector<int64_t> counts;
+    /// Number of values.
+    int64_t total = 0;
+    /// Sum of the values.
+    double sum = 0;
+    /// Smallest value.
+    int64_t minimum = std::numeric_limits<int64_t>::max();
+    /// Largest value.
+    int64_t maximum = 0;
+
+    /// Returns the bucket of a value.
+    static size_t index(int64_t value) {
+        if (value < subBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        // shift the value until it falls in the upper half of the sub-buckets
+        int magnitude = 0;
+        while ((value >> magnitude) >= subBucketCount) {
+            ++magnitude;
+        }
+        return static_cast<size_t>((magnitude + 1) * halfCount + ((value >> magnitude) - halfCount));
+    }
+
+    /// Returns the largest value that falls in a bucket.
+    static int64_t highest(size_t bucket) {
+        auto i = static_cast<int64_t>(bucket);
+        if (i < subBucketCount) {
+            return i;
+        }
+        int64_t magnitude = i / halfCount - 1;
+        int64_t subBucket = i % halfCount + halfCount;
+        return ((subBucket + 1) << magnitude) - 1;
+    }
+
+public:
+
+    /// Adds one value; negative values count as 0.
+    void record(int64_t value) {
+        value = std::max<int64_t>(value, 0);
+        size_t bucket = index(value);
+        if (bucket >= counts.size()) {
+            counts.resize(bucket + 1);
+        }
+        ++counts[bucket];
+        ++total;
+        sum += static_cast<double>(value);
+        minimum = std::min(minimum, value);
+        maximum = std::max(maximum, value);
+    }
+
+    /// Adds the values of another histogram.
+    void merge(const LatencyHistogram& other) {
+        if (other.counts.size() > counts.size()) {
+            counts.resize(other.counts.size());
+        }
+        for (size_t i = 0; i < other.counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        sum += other.sum;
+        minimum = std::min(minimum, other.minimum);
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    /**
+     * @brief Returns the value below which a fraction of the values fall.
+     * @param fraction Fraction of the values, e.g. 0.99 for p99.
+     * @return The largest value of the bucket the percentile falls in, but not more than the
+     *  largest value recorded; 0 if the histogram is empty.
+     */
+    [[nodiscard]] int64_t percentile(double fraction) const {
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<int64_t>(std::ceil(fraction * static_cast<double>(total)));
+        rank = std::clamp<int64_t>(rank, 1, total);
+        int64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(highest(i), maximum);
+            }
+        }
+        return maximum;
+    }
+
+    /// Returns the number of values.
+    [[nodiscard]] int64_t count() const {
+        return total;
+    }
+
+    /// Returns the mean of the values, or 0 if there are none.
+    [[nodiscard]] double mean() const {
+        return total > 0 ? sum / static_cast<double>(total) : 0;
+    }
+
+    /// Returns the smallest value, or 0 if there are none.
+    [[nodiscard]] int64_t min() const {
+        return total > 0 ? minimum : 0;
+    }
+
+    /// Returns the largest value, or 0 if there are none.
+    [[nodiscard]] int64_t max() const {
+        return maximum;
+    }
+};
@@ -0,0 +1,325 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "TempoClient.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class LoadGenerator
+ * @brief Sends a mix of requests to one instrument, or a proxy in front of it, at a set rate and
+ * measures the throughput, latency, errors and timeouts.
+ *
+ * The load is open loop: request k is due at start + k / rate whether or not the earlier
+ * requests have been answered, and its latency is measured from the time it was due, not the
+ * time it was sent. When the instrument slows down and every connection is busy, requests wait
+ * for a free connection and that wait counts in their latency, so a stall shows up in the tail
+ * the way the pollers would see it, instead of slowing the load down and hiding itself
+ * (coordinated omission). The service time, from sending to the end of the response, is kept
+ * apart for comparison.
+ *
+ * With a rate of 0 the load is closed loop instead: each connection sends its next request as
+ * soon as the last one is answered, which finds the most requests per second the instrument
+ * can answer, and latency is then the same as the service time.
+ *
+ * Each connection has its own TempoClient and thread, and keeps its own histograms, which are
+ * merged at the end, so the threads share nothing but the counter of the next request.
+ * The request types follow each other in a fixed order that matches their weights, so two
+ * runs with the same options send the same requests.
+ */
+class LoadGenerator {
+
+public:
+
+    /// Clock for the schedule and latencies.
+    using Clock = std::chrono::steady_clock;
+
+    /// Makes one request with the TempoClient it is given.
+    using Request = std::function<void(TempoClient&)>;
+
+    /**
+     * @struct Totals
+     * @brief Counts and latencies of one request type, or of all of them.
+     */
+    struct Totals {
+        int64_t completed = 0;            ///< Requests answered with status 200.
+        int64_t errors = 0;               ///< Requests answered with another status, or that failed without timing out.
+        int64_t timeouts = 0;             ///< Requests that got no response within the wait time.
+        std::map<int, int64_t> statuses;  ///< Responses by HTTP status.
+        LatencyHistogram latency;         ///< Microseconds from when each request was due to its response.
+        LatencyHistogram service;         ///< Microseconds from when each request was sent to its response.
+
+        /// Adds the counts and latencies of other.
+        void merge(const Totals& other) {
+            completed += other.completed;
+            errors += other.errors;
+            timeouts += other.timeouts;
+            for (const auto& [status, count] : other.statuses) {
+                statuses[status] += count;
+            }
+            latency.merge(other.latency);
+            service.merge(other.service);
+        }
+    };
+
+private:
+
+    /// Names and functions of the request types.
+    std::vector<std::pair<std::string, Request>> requests;
+    /// Weight of each request type, by index into requests.
+    std::vector<int64_t> weights;
+    /// Order of the request types, as indexes into requests, repeated for the whole run.
+    std::vector<size_t> order;
+
+    std::string host;       ///< URL of the instrument or proxy.
+    std::string password;   ///< Password for the Automation user.
+    int32_t waitTime;       ///< Seconds to wait for each response.
+    size_t concurrency;     ///< Number of connections, each with its own thread.
+    double rate;            ///< Requests per second for all connections, or 0 for closed loop.
+    std::chrono::duration<double> duration; ///< Time requests are sent for.
+
+    /// Index of the next request.
+    std::atomic<int64_t> next{0};
+    /// Set by stop to end the run early.
+    std::atomic<bool> stopping{false};
+
+    /// Totals of each request type, by index into requests, after run.
+    std::vector<Totals> totals;
+    /// Requests that were due before the end but were not sent, after run.
+    int64_t unsent = 0;
+    /// Seconds from the start until the last response, after run.
+    double elapsed = 0;
+
+    /// Returns microseconds as milliseconds with three decimals.
+    static double milliseconds(double micros) {
+        return static_cast<double>(static_cast<int64_t>(micros + 0.5)) / 1000;
+    }
+
+    /// Returns the percentiles of a histogram of microseconds, in milliseconds.
+    static json percentiles(const LatencyHistogram& histogram) {
+        return {{"mean", milliseconds(histogram.mean())},
+                {"p50", milliseconds(static_cast<double>(histogram.percentile(0.5)))},
+                {"p90", milliseconds(static_cast<double>(histogram.percentile(0.9)))},
+                {"p99", milliseconds(static_cast<double>(histogram.percentile(0.99)))},
+                {"p999", milliseconds(static_cast<double>(histogram.percentile(0.999)))},
+                {"max", milliseconds(static_cast<double>(histogram.max()))}};
+    }
+
+    /// Returns the counts and latencies of totals as JSON.
+    static json toJson(const Totals& totals) {
+        json statuses = json::object();
+        for (const auto& [status, count] : totals.statuses) {
+            statuses[std::to_string(status)] = count;
+        }
+        return {{"completed", totals.completed}, {"errors", totals.errors}, {"timeouts", totals.timeouts},
+                {"statuses", statuses}, {"latency", percentiles(totals.latency)},
+                {"service", percentiles(totals.service)}};
+    }
+
+    /**
+     * @brief Sends requests on one connection until the schedule ends.
+     * @param start Time the first request is due.
+     * @param results Receives the totals of each request type.
+     */
+    void connection(Clock::time_point start, std::vector<Totals>& results) {
+        TempoClient tempoClient(host, password, waitTime);
+        auto end = start + std::chrono::duration_cast<Clock::duration>(duration);
+        auto interval = rate > 0 ? std::chrono::duration<double>(1 / rate) : std::chrono::duration<double>(0);
+        results.resize(requests.size());
+        while (!stopping) {
+            int64_t index = next++;
+            auto due = rate > 0 ? start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(index))
+                                : std::max(start, Clock::now());
+            if (due >= end) {
+                break;
+            }
+            if (rate > 0 && Clock::now() >= end) {
+                // due but too late to send; counted as unsent by run
+                break;
+            }
+            std::this_thread::sleep_until(due);
+            size_t type = order[static_cast<size_t>(index) % order.size()];
+            auto sent = Clock::now();
+            requests[type].second(tempoClient);
+            auto answered = Clock::now();
+
+            Totals& result = results[type];
+            int status = tempoClient.httpStatus();
+            httplib::Error error = tempoClient.error();
+            if (status == 200) {
+                ++result.completed;
+            } else if (error == httplib::Error::ConnectionTimeout
+                       || (error == httplib::Error::Read && answered - sent >= std::chrono::seconds(waitTime))) {
+                ++result.timeouts;
+            } else {
+                ++result.errors;
+            }
+            if (status != 0) {
+                ++result.statuses[status];
+            }
+            result.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(answered - due).count());
+            result.service.record(std::chrono::duration_cast<std::chrono::microseconds>(answered - sent).count());
+        }
+    }
+
+public:
+
+    /**
+     * @brief Sets up the load. No requests are sent until run is called.
+     * @param host_ URL of the instrument or proxy.
+     * @param password_ Password for the Automation user.
+     * @param waitTime_ Seconds to wait for each response; a request with no response by then is a timeout.
+     * @param concurrency_ Number of connections.
+     * @param rate_ Requests per second for all connections, or 0 for closed loop.
+     * @param duration_ Seconds to send requests for.
+     */
+    LoadGenerator(std::string host_, std::string password_, int32_t waitTime_, size_t concurrency_, double rate_,
+                  double duration_) :
+            host(std::move(host_)),
+            password(std::move(password_)),
+            waitTime(waitTime_),
+            concurrency(concurrency_),
+            rate(rate_),
+            duration(duration_) {
+    }
+
+    /**
+     * @brief Adds a request type to the mix.
+     * @param name Name of the request type in the results.
+     * @param weight Share of the requests relative to the other types; at least 1.
+     * @param request Makes the request.
+     */
+    void add(const std::string& name, int64_t weight, Request request) {
+        requests.emplace_back(name, std::move(request));
+        weights.push_back(std::max<int64_t>(weight, 1));
+        // smooth weighted round robin, so the types are spread out rather than sent in runs
+        int64_t total = 0;
+        for (auto value : weights) {
+            total += value;
+        }
+        std::vector<int64_t> current(weights.size(), 0);
+        order.clear();
+        for (int64_t i = 0; i < total; ++i) {
+            size_t best = 0;
+            for (size_t type = 0; type < weights.size(); ++type) {
+                current[type] += weights[type];
+                if (current[type] > current[best]) {
+                    best = type;
+                }
+            }
+            current[best] -= total;
+            order.push_back(best);
+        }
+    }
+
+    /**
+     * @brief Sends the requests until the duration has passed or stop is called.
+     *
+     * Requests that were sent are always waited for, so the run can take up to the wait time
+     * longer than the duration.
+     * @return False if no request type was added.
+     */
+    bool run() {
+        if (requests.empty() || concurrency == 0) {
+            return false;
+        }
+        next = 0;
+        std::vector<std::vector<Totals>> results(concurrency);
+        // give every connection time to start before the first request is due
+        auto start = Clock::now() + std::chrono::milliseconds(10);
+        {
+            std::vector<std::thread> threads;
+            threads.reserve(concurrency);
+            for (size_t i = 0; i < concurrency; ++i) {
+                threads.emplace_back([this, start, &results, i]() {
+                    connection(start, results[i]);
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        totals.assign(requests.size(), Totals());
+        for (const auto& result : results) {
+            for (size_t type = 0; type < result.size(); ++type) {
+                totals[type].merge(result[type]);
+            }
+        }
+        unsent = 0;
+        if (rate > 0 && !stopping) {
+            auto due = static_cast<int64_t>(std::ceil(duration.count() * rate));
+            unsent = std::max<int64_t>(0, due - sent());
+        }
+        return true;
+    }
+
+    /// Makes run return after the requests in progress are answered. Safe to call from any thread.
+    void stop() {
+        stopping = true;
+    }
+
+    /// Returns the number of requests sent by the last run.
+    [[nodiscard]] int64_t sent() const {
+        int64_t count = 0;
+        for (const auto& type : totals) {
+            count += type.completed + type.errors + type.timeouts;
+        }
+        return count;
+    }
+
+    /// Returns the totals of all request types of the last run.
+    [[nodiscard]] Totals overall() const {
+        Totals all;
+        for (const auto& type : totals) {
+            all.merge(type);
+        }
+        return all;
+    }
+
+    /**
+     * @brief Returns the results of the last run: the load, the throughput, the counts, and the
+     * latency and service time percentiles in milliseconds, overall and for each request type.
+     */
+    [[nodiscard]] json results() const {
+        Totals all = overall();
+        json result;
+        result["mode"] = rate > 0 ? "open" : "closed";
+        result["rate"] = rate;
+        result["concurrency"] = concurrency;
+        result["duration"] = duration.count();
+        result["elapsed"] = std::round(elapsed * 1000) / 1000;
+        result["sent"] = sent();
+        result["unsent"] = unsent;
+        result["throughput"] = elapsed > 0 ? std::round(static_cast<double>(all.completed) / elapsed * 10) / 10 : 0.0;
+        json overallJson = toJson(all);
+        result.update(overallJson);
+        result["requests"] = json::object();
+        for (size_t type = 0; type < requests.size(); ++type) {
+            result["requests"][requests[type].first] = toJson(totals[type]);
+        }
+        result["unit"] = "ms";
+        return result;
+    }
+};
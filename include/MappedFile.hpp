@@ -0,0 +1,120 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @class MappedFile
+ * @brief Maps a whole file into memory for reading.
+ *
+ * Pages are read from disk only when they are touched, so a reader that looks at a small part
+ * of a large file, such as a time range of a telemetry recording, reads only that part.
+ */
+class MappedFile {
+
+    /// Start of the mapping, or nullptr if the file could not be mapped or is empty.
+    const char* bytes = nullptr;
+    /// Length of the file.
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;  ///< Open file.
+    HANDLE mapping = nullptr;            ///< File mapping object.
+#endif
+
+public:
+
+    /**
+     * @brief Maps a file. Use isOpen to check for success.
+     * @param path Path of the file.
+     */
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            return;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            return;
+        }
+        bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        length = bytes != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat status{};
+        if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+            void* address = ::mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (address != MAP_FAILED) {
+                bytes = static_cast<const char*>(address);
+                length = static_cast<size_t>(status.st_size);
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Unmaps the file.
+    ~MappedFile() {
+#ifdef _WIN32
+        if (bytes != nullptr) {
+            UnmapViewOfFile(bytes);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+#else
+        if (bytes != nullptr) {
+            ::munmap(const_cast<char*>(bytes), length);
+        }
+#endif
+    }
+
+    /// Returns true if the file is mapped. An empty file cannot be mapped.
+    [[nodiscard]] bool isOpen() const {
+        return bytes != nullptr;
+    }
+
+    /// Returns the start of the file contents.
+    [[nodiscard]] const char* data() const {
+        return bytes;
+    }
+
+    /// Returns the length of the file.
+    [[nodiscard]] size_t size() const {
+        return length;
+    }
+};
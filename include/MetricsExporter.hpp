@@ -0,0 +1,424 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+#include "TempoClient.hpp"
+#include "TypedResponses.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using nlohmann::json;
+
+/**
+ * @class MetricsExporter
+ * @brief Polls one PTC Tempo in the background and serves its state as OpenMetrics text.
+ *
+ * A poller thread requests /tempo/status, /tempo/lid, /tempo/protocol-run and /tempo/errors once
+ * per interval and renders the responses, together with the latency and error counts of those
+ * requests, into a snapshot. GET /metrics returns the latest snapshot, so scrapes never reach
+ * the instrument, and any number of scrapers see the same request rate on the instrument.
+ *
+ * Values from a request that failed in the last poll are left out of the snapshot rather than
+ * served stale; tempo_up tells whether the instrument answered /tempo/status.
+ */
+class MetricsExporter {
+
+public:
+
+    /// Clock for request latency.
+    using Clock = std::chrono::steady_clock;
+
+    /// Number of polled paths.
+    static constexpr size_t endpointCount = 4;
+    /// Polled paths, in the order of Snapshot::requests.
+    static constexpr std::array<const char*, endpointCount> endpoints = {
+            "/tempo/status", "/tempo/lid", "/tempo/protocol-run", "/tempo/errors"};
+
+    /// Number of latency histogram buckets, not counting +Inf.
+    static constexpr size_t bucketCount = 10;
+    /// Upper bounds of the latency histogram buckets in seconds.
+    static constexpr std::array<double, bucketCount> bucketBounds = {
+            0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5};
+
+    /**
+     * @struct RequestStats
+     * @brief Latency and error counts of the requests for one path.
+     */
+    struct RequestStats {
+        int64_t requests = 0;                   ///< Requests sent.
+        int64_t errors = 0;                     ///< Requests without a valid response with status 200.
+        double seconds = 0;                     ///< Sum of the request latencies.
+        std::array<int64_t, bucketCount> buckets{};  ///< Requests in each bucket, not cumulative.
+
+        /// Adds one request that took seconds_.
+        void add(double seconds_, bool failed) {
+            ++requests;
+            errors += failed ? 1 : 0;
+            seconds += seconds_;
+            for (size_t i = 0; i < bucketCount; ++i) {
+                if (seconds_ <= bucketBounds[i]) {
+                    ++buckets[i];
+                    break;
+                }
+            }
+        }
+    };
+
+    /**
+     * @struct Snapshot
+     * @brief Instrument state and request counts after one poll.
+     */
+    struct Snapshot {
+        std::optional<StatusResponse> status;    ///< Last /tempo/status, if it succeeded.
+        std::optional<LidResponse> lid;          ///< Last /tempo/lid, if it succeeded.
+        std::optional<RunResponse> run;          ///< Last /tempo/protocol-run, if it succeeded.
+        std::optional<int64_t> cyclerFaults;     ///< cyclerFaultCount of the last /tempo/errors, if it succeeded.
+        std::optional<int64_t> lidFaults;        ///< lidFaultCount of the last /tempo/errors, if it succeeded.
+        std::array<RequestStats, endpointCount> requests;  ///< Counts for each path since the exporter started.
+        int64_t polls = 0;                       ///< Polls since the exporter started.
+        double pollTime = 0;                     ///< Unix time of the last poll in seconds.
+    };
+
+private:
+
+    /**
+     * @class Family
+     * @brief Writes one metric family: its metadata and then its samples.
+     *
+     * Nothing is written for a family without samples.
+     */
+    class Family {
+        std::ostringstream& out;
+        std::string name;
+        std::string type;
+        std::string help;
+        std::string unit;
+        bool started = false;
+
+        void start() {
+            if (started) {
+                return;
+            }
+            started = true;
+            out << "# TYPE " << name << ' ' << type << '\n';
+            if (!unit.empty()) {
+                out << "# UNIT " << name << ' ' << unit << '\n';
+            }
+            out << "# HELP " << name << ' ' << help << '\n';
+        }
+
+    public:
+        Family(std::ostringstream& out_, std::string name_, std::string type_, std::string help_, std::string unit_ = {}) :
+                out(out_), name(std::move(name_)), type(std::move(type_)), help(std::move(help_)), unit(std::move(unit_)) {}
+
+        /// Writes a sample; suffix is appended to the family name and labels are written as given.
+        template<typename T>
+        void sample(const T& value, const std::string& labels = {}, const char* suffix = "") {
+            start();
+            out << name << suffix;
+            if (!labels.empty()) {
+                out << '{' << labels << '}';
+            }
+            out << ' ' << value << '\n';
+        }
+
+        /// Writes a sample if the value is present.
+        template<typename T>
+        void sample(const std::optional<T>& value, const std::string& labels = {}, const char* suffix = "") {
+            if (value) {
+                sample(*value, labels, suffix);
+            }
+        }
+    };
+
+    /// Returns name="value" with the value escaped as OpenMetrics requires.
+    static std::string label(const char* name, const std::string& value) {
+        std::string text = name;
+        text += "=\"";
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                text += '\\';
+                text += c;
+            } else if (c == '\n') {
+                text += "\\n";
+            } else {
+                text += c;
+            }
+        }
+        text += '"';
+        return text;
+    }
+
+    /// Client for the instrument; only used by the poller thread.
+    TempoClient& tempoClient;
+    /// Time between the starts of polls.
+    std::chrono::milliseconds interval;
+    /// Serves the snapshot.
+    httplib::Server server;
+
+    /// Guards rendered and stopping.
+    std::mutex mutex;
+    /// Wakes the poller when stopping.
+    std::condition_variable wake;
+    /// True once stop is called.
+    bool stopping = false;
+    /// Text served to scrapers.
+    std::shared_ptr<const std::string> rendered = std::make_shared<const std::string>("# EOF\n");
+    /// State after the last poll; only used by the poller thread.
+    Snapshot latest;
+    /// Polls the instrument.
+    std::thread poller;
+
+    /// Sends the request for an endpoint.
+    void request(size_t endpoint) {
+        switch (endpoint) {
+            case 0: tempoClient.status(); break;
+            case 1: tempoClient.lid(); break;
+            case 2: tempoClient.run(); break;
+            default: tempoClient.faults(false); break;
+        }
+    }
+
+    /// Decodes the response into value, or resets value if there is no valid response.
+    template<typename T>
+    bool decode(std::optional<T>& value) {
+        if (!tempoClient.decode(value.emplace())) {
+            value.reset();
+            return false;
+        }
+        return true;
+    }
+
+    /// Reads the response for an endpoint into the snapshot; returns false if there is none.
+    bool read(size_t endpoint, Snapshot& snapshot) {
+        bool success = false;
+        switch (endpoint) {
+            case 0: success = decode(snapshot.status); break;
+            case 1: success = decode(snapshot.lid); break;
+            case 2: success = decode(snapshot.run); break;
+            default: {
+                const auto& response = tempoClient.parsed();
+                snapshot.cyclerFaults.reset();
+                snapshot.lidFaults.reset();
+                if (response.valid) {
+                    if (auto count = response.body.find("cyclerFaultCount"); count != response.body.end() && count->is_number_integer()) {
+                        snapshot.cyclerFaults = count->get<int64_t>();
+                    }
+                    if (auto count = response.body.find("lidFaultCount"); count != response.body.end() && count->is_number_integer()) {
+                        snapshot.lidFaults = count->get<int64_t>();
+                    }
+                    success = true;
+                }
+                break;
+            }
+        }
+        return success;
+    }
+
+    /// Polls every endpoint once and replaces the served text.
+    void poll() {
+        for (size_t endpoint = 0; endpoint < endpointCount; ++endpoint) {
+            auto start = Clock::now();
+            request(endpoint);
+            bool success = read(endpoint, latest);
+            latest.requests[endpoint].add(std::chrono::duration<double>(Clock::now() - start).count(), !success);
+        }
+        ++latest.polls;
+        latest.pollTime = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto text = std::make_shared<const std::string>(render(latest));
+        std::scoped_lock lock(mutex);
+        rendered = std::move(text);
+    }
+
+    /// Polls until stop is called.
+    void pollUntilStopped() {
+        auto next = Clock::now();
+        std::unique_lock lock(mutex);
+        while (!stopping) {
+            lock.unlock();
+            poll();
+            next += interval;
+            if (next < Clock::now()) {
+                // a slow instrument delays the next poll instead of causing a burst of them
+                next = Clock::now();
+            }
+            lock.lock();
+            wake.wait_until(lock, next, [this]() { return stopping; });
+        }
+    }
+
+public:
+
+    /**
+     * @brief Sets up an exporter. Nothing is polled or served until listen is called.
+     * @param tempoClient_ Client for the instrument; it must not be used elsewhere until listen returns.
+     * @param interval_ Time between the starts of polls.
+     */
+    MetricsExporter(TempoClient& tempoClient_, std::chrono::milliseconds interval_) :
+            tempoClient(tempoClient_),
+            interval(interval_) {
+        server.Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+            std::shared_ptr<const std::string> text;
+            {
+                std::scoped_lock lock(mutex);
+                text = rendered;
+            }
+            res.set_content(*text, "application/openmetrics-text; version=1.0.0; charset=utf-8");
+        });
+    }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    ~MetricsExporter() {
+        stop();
+        if (poller.joinable()) {
+            poller.join();
+        }
+    }
+
+    /**
+     * @brief Renders a snapshot as an OpenMetrics text exposition.
+     * @param snapshot Instrument state and request counts.
+     * @return Text ending with the # EOF line.
+     */
+    static std::string render(const Snapshot& snapshot) {
+        std::ostringstream out;
+        out.precision(15);
+
+        Family up(out, "tempo_up", "gauge", "Whether the instrument answered /tempo/status in the last poll.");
+        up.sample(snapshot.status ? 1 : 0);
+
+        if (snapshot.status && snapshot.status->status) {
+            Family(out, "tempo_status", "info", "Instrument status.").sample(1, label("status", *snapshot.status->status), "_info");
+        }
+        if (snapshot.lid && snapshot.lid->lid) {
+            const std::string& lid = *snapshot.lid->lid;
+            Family(out, "tempo_lid", "info", "Lid state.").sample(1, label("lid", lid), "_info");
+            Family(out, "tempo_lid_moving", "gauge", "Whether the lid is opening or closing.").sample(lid == "opening" || lid == "closing" ? 1 : 0);
+        }
+
+        const ProtocolRun* run = snapshot.run && snapshot.run->protocolRun ? &*snapshot.run->protocolRun : nullptr;
+        if (run != nullptr) {
+            std::string labels = label("protocol", run->protocolName.value_or("")) + ',' + label("run", run->runName.value_or(""))
+                                 + ',' + label("plate", run->plateID.value_or(""));
+            if (run->step && run->step->stepState) {
+                labels += ',' + label("step_state", *run->step->stepState);
+            }
+            Family(out, "tempo_run", "info", "Protocol run in progress.").sample(1, labels, "_info");
+        }
+        const RunTemperature* temperature = run != nullptr && run->temperature ? &*run->temperature : nullptr;
+        if (temperature != nullptr) {
+            Family(out, "tempo_block_temperature_celsius", "gauge", "Block temperature.", "celsius").sample(temperature->currentBlockTemp);
+            Family(out, "tempo_lid_temperature_celsius", "gauge", "Lid temperature.", "celsius").sample(temperature->currentLidTemp);
+            Family(out, "tempo_sample_temperature_celsius", "gauge", "Calculated sample temperature.", "celsius").sample(temperature->currentSampleTemp);
+        }
+
+        // the run response has the timing of the step; status has the time left when no run response came back
+        const RunTime* time = run != nullptr && run->time ? &*run->time : nullptr;
+        std::optional<int64_t> remaining = time != nullptr && time->totalRemaining ? time->totalRemaining
+                                           : snapshot.status ? snapshot.status->protocolTimeRemaining : std::nullopt;
+        Family(out, "tempo_run_remaining_seconds", "gauge", "Time left in the run.", "seconds").sample(remaining);
+        if (time != nullptr) {
+            Family(out, "tempo_run_elapsed_seconds", "gauge", "Time since the run started.", "seconds").sample(time->elapsed);
+            Family(out, "tempo_step_remaining_seconds", "gauge", "Time left in the current step.", "seconds").sample(time->remaining);
+        }
+
+        const RunStep* step = run != nullptr && run->step ? &*run->step : nullptr;
+        std::optional<int64_t> stepNumber = step != nullptr && step->stepNumber ? step->stepNumber
+                                            : snapshot.status ? snapshot.status->stepNumber : std::nullopt;
+        Family(out, "tempo_step_number", "gauge", "Step being run.").sample(stepNumber);
+        if (step != nullptr) {
+            Family(out, "tempo_steps", "gauge", "Number of steps in the protocol.").sample(step->numberOfSteps);
+            Family(out, "tempo_step_repeat", "gauge", "Repeat of the current step.").sample(step->currentRepeat);
+            Family(out, "tempo_step_repeats", "gauge", "Number of repeats of the current step.").sample(step->totalRepeat);
+        }
+
+        Family faults(out, "tempo_faults", "gauge", "Number of current faults.");
+        faults.sample(snapshot.cyclerFaults, label("source", "cycler"));
+        faults.sample(snapshot.lidFaults, label("source", "lid"));
+
+        Family requests(out, "tempoclient_requests", "counter", "Requests the exporter sent to the instrument.");
+        Family errors(out, "tempoclient_request_errors", "counter", "Requests without a valid response with status 200.");
+        for (size_t i = 0; i < endpointCount; ++i) {
+            requests.sample(snapshot.requests[i].requests, label("path", endpoints[i]), "_total");
+        }
+        for (size_t i = 0; i < endpointCount; ++i) {
+            errors.sample(snapshot.requests[i].errors, label("path", endpoints[i]), "_total");
+        }
+
+        Family latency(out, "tempoclient_request_duration_seconds", "histogram", "Time from sending a request to reading its response.", "seconds");
+        for (size_t i = 0; i < endpointCount; ++i) {
+            const RequestStats& stats = snapshot.requests[i];
+            std::string path = label("path", endpoints[i]);
+            int64_t cumulative = 0;
+            for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+                cumulative += stats.buckets[bucket];
+                std::ostringstream bound;
+                bound << bucketBounds[bucket];
+                latency.sample(cumulative, path + ',' + label("le", bound.str()), "_bucket");
+            }
+            latency.sample(stats.requests, path + ',' + label("le", "+Inf"), "_bucket");
+            latency.sample(stats.requests, path, "_count");
+            latency.sample(stats.seconds, path, "_sum");
+        }
+
+        Family polls(out, "tempoclient_polls", "counter", "Polls of the instrument.");
+        polls.sample(snapshot.polls, {}, "_total");
+        if (snapshot.polls > 0) {
+            Family(out, "tempoclient_last_poll_timestamp_seconds", "gauge", "Unix time of the last poll.", "seconds").sample(snapshot.pollTime);
+        }
+
+        out << "# EOF\n";
+        return out.str();
+    }
+
+    /**
+     * @brief Polls the instrument and serves the snapshot until stop is called.
+     * @param address Address to listen on.
+     * @param port Port to listen on.
+     * @return False if the port could not be opened.
+     */
+    bool listen(const std::string& address, int port) {
+        if (!server.bind_to_port(address, port)) {
+            std::cerr << "Error. Unable to listen on " << address << ":" << port << "." << std::endl;
+            return false;
+        }
+        poller = std::thread([this]() { pollUntilStopped(); });
+        std::cerr << "Serving metrics on http://" << address << ":" << port << "/metrics" << std::endl;
+        bool success = server.listen_after_bind();
+        stop();
+        poller.join();
+        return success;
+    }
+
+    /// Stops polling and serving; listen returns once the poll and scrapes in progress finish.
+    void stop() {
+        {
+            std::scoped_lock lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        server.stop();
+    }
+};
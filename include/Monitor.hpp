@@ -8,11 +8,18 @@
 // SPDX-License-Identifier: MIT
 //
 
+#pragma once
+
+#include "PollingPolicy.hpp"
 #include "TempoClient.hpp"
 #ifdef WIN32
 #include <windows.h>
+#else
+#include "TerminalRenderer.hpp"
 #endif
 
+#include <atomic>
+#include <csignal>
 #include <thread>
 #include <chrono>
 #include <algorithm>
@@ -22,6 +29,10 @@
  * false or this class cannot update the screen.
  *
  * It is used for HTTP requests that check a status repeatedly (e.g. - lid, run, or status).
+ *
+ * On Windows, each frame is drawn over the last with the console API. Elsewhere, when stdout is
+ * a terminal, a TerminalRenderer draws the frames on the alternate screen and rewrites only the
+ * lines that changed. When stdout is not a terminal, each frame is appended to the output.
  */
 class Monitor {
 
@@ -31,40 +42,76 @@ public:
      * @brief Constructor sets up the monitor and repeatedly calls the status function.
      * StatusCall, template definition of function used for monitoring.
      * @param tempoClient_ Reference to object that makes HTTP requests.
-     * @param interval How many seconds to wait between calls to status function.
+     * @param policy Decides how long to wait between calls to status function.
      * @param displayType_ How to format the output; either json or text.
+     * @param stopOnInterrupt True to end monitoring normally on SIGINT or SIGTERM, so the final
+     *  response and request stats are still printed, instead of ending the process.
+     * @param showConnections True to print the connection counts to stderr at the end, for --stats.
      * @param statusCall Reference to function that obtains status from instrument. This can be a lambda.
      */
     template<typename StatusCall>
-    Monitor(TempoClient& tempoClient_, int32_t interval, const std::string& displayType_, StatusCall statusCall) :
+    Monitor(TempoClient& tempoClient_, PollingPolicy policy, const std::string& displayType_, bool stopOnInterrupt,
+            bool showConnections, StatusCall statusCall) :
             tempoClient(tempoClient_),
             displayType(displayType_) {
-        clearConsole();
-        int16_t bottomLine;
-
         // request status from instrument
         bool monitor = statusCall();
-        refreshScreen(bottomLine);
-        if (!monitor) {
-            clearBottom(bottomLine);
-            return;
+#ifndef WIN32
+        // a single response is printed as it was without monitoring, not drawn on the alternate screen
+        if (monitor && renderer.available()) {
+            std::cout.flush();
+            renderer.begin();
         }
-        bool done = false;
-        do {
-            std::this_thread::sleep_for(std::chrono::seconds(interval));
+#endif
+        // installed after the renderer's handlers and removed before them
+        interrupted = false;
+        auto previousInterrupt = stopOnInterrupt ? std::signal(SIGINT, [](int) { interrupted = true; }) : SIG_DFL;
+        auto previousTerminate = stopOnInterrupt ? std::signal(SIGTERM, [](int) { interrupted = true; }) : SIG_DFL;
+        clearConsole();
+        int16_t bottomLine;
+        refreshScreen(bottomLine);
+        bool done = !monitor;
+        while (!done) {
+            auto wakeTime = std::chrono::steady_clock::now() + policy.next(tempoClient.parsed().body);
+            while (!interrupted && std::chrono::steady_clock::now() < wakeTime) {
+                // short sleeps so an interrupt is noticed quickly
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                        wakeTime - std::chrono::steady_clock::now(), std::chrono::milliseconds(50)));
+            }
             // request status from instrument
-            if (!statusCall()) {
+            if (interrupted || !statusCall()) {
                 done = true;
             } else if (!refreshScreen(bottomLine)) {
                 successValue = false;
                 done = true;
             }
-        } while (!done);
+        }
 
         clearBottom(bottomLine);
+        if (stopOnInterrupt) {
+            std::signal(SIGINT, previousInterrupt);
+            std::signal(SIGTERM, previousTerminate);
+        }
+#ifndef WIN32
+        renderer.end();
+#endif
+        if (!monitor) {
+            return;
+        }
         tempoClient.print(displayType);
+        if (!showConnections) {
+            return;
+        }
+
+        const auto& connections = tempoClient.connections();
+        std::cerr << "Connections: " << connections.connects << " opened, " << connections.reused << " reused, "
+                  << connections.reconnects << " reconnected for " << connections.requests << " requests, "
+                  << connections.parses << " responses parsed" << std::endl;
     }
 
+    /// Set by SIGINT or SIGTERM while a monitor that stops on interrupt is running.
+    static inline std::atomic<bool> interrupted{false};
+
     /// Returns true for success, false if unable to upddate screen.
     [[nodiscard]] bool success() const {
         return successValue;
@@ -78,13 +125,17 @@ private:
     const std::string& displayType;
     /// False if unable to upddate screen.
     bool successValue = true;
+#ifndef WIN32
+    /// Draws the frames in place when stdout is a terminal.
+    TerminalRenderer renderer;
+#endif
 
     /**
      * @brief Refreshes output contents on terminal.
      * @param bottomLine Output parameter for number of lines printed, not number of rows in screen.
      * @return True to keep polling status, false to stop.
      */
-    bool refreshScreen(int16_t& bottomLine) const {
+    bool refreshScreen(int16_t& bottomLine) {
         int columns;
         int rows;
 #ifdef WIN32
@@ -106,26 +157,40 @@ private:
         if (!tempoClient.responseString(responseResult, displayType)) {
             return false;
         }
+        auto start = RequestStats::Clock::now();
+#ifndef WIN32
+        if (renderer.active()) {
+            bottomLine = 0;
+            bool drawn = renderer.draw(responseResult);
+            tempoClient.timed(RequestStats::output, start);
+            return drawn;
+        }
+#endif
 #ifdef WIN32
         SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), COORD{0, 0});
 #endif
         std::istringstream stream(responseResult);
         std::string line;
+        // the frame is written and flushed once instead of once per line
+        std::string frame;
 
         while (std::getline(stream, line)) {
             ++numberOfLines;
             int32_t len = columns - static_cast<int32_t>(line.length());
-            std::string clear = len > 0 ? std::string(len, ' ') : std::string();
-            std::cout << line << clear << std::endl;
+            frame += line;
+            frame.append(len > 0 ? static_cast<size_t>(len) : 0, ' ');
+            frame += '\n';
         }
         bottomLine = numberOfLines;
         std::string clear(columns, ' ');
         for (int32_t i = numberOfLines; i <= rows; ++i) {
-            std::cout << clear;
+            frame += clear;
             if (i < rows) {
-                std::cout << std::endl;
+                frame += '\n';
             }
         }
+        std::cout << frame << std::flush;
+        tempoClient.timed(RequestStats::output, start);
         return true;
     }
 
@@ -0,0 +1,163 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+
+using nlohmann::json;
+
+/**
+ * @class PollingPolicy
+ * @brief Decides how long Monitor waits before the next poll.
+ *
+ * A fixed policy always waits the same interval. An adaptive policy reads the last response and
+ * polls quickly when a change is due, and slowly when nothing is expected to change.
+ * - A lid that is opening or closing is polled at the minimum interval.
+ * - After the status or lid changes, the next poll is at the minimum interval.
+ * - During a run, the time to the next expected change is the least of protocolTimeRemaining,
+ *   and the remaining and hold values that are above zero. The step's stepTime is not used, as
+ *   it counts the seconds into the step rather than those left. The next poll is at half that
+ *   time, so polls get closer together as the change nears.
+ * - When idle, paused, or with no timing values, the interval doubles after each poll without a
+ *   change, up to the maximum.
+ *
+ * Jitter spreads the polls of many clients so they do not all reach an instrument at once. The
+ * interval is kept between the minimum and the maximum after jitter is applied.
+ */
+class PollingPolicy {
+
+public:
+
+    /// Time between polls.
+    using Interval = std::chrono::milliseconds;
+
+private:
+
+    /// Shortest wait between polls.
+    Interval minimum;
+    /// Longest wait between polls.
+    Interval maximum;
+    /// Fraction of the interval that is added or removed at random; 0 for none.
+    double jitter;
+    /// True to adapt the interval to the response, false for a fixed interval of minimum.
+    bool adaptive;
+
+    /// Status and lid state in the last response.
+    std::string lastState;
+    /// Interval chosen after the last response.
+    Interval lastInterval{0};
+    /// Source of jitter.
+    std::mt19937 random{std::random_device{}()};
+
+    /// Returns value if it is a positive number of seconds, otherwise 0.
+    static double seconds(const json& object, const char* key) {
+        if (auto value = object.find(key); value != object.end() && value->is_number() && value->get<double>() > 0) {
+            return value->get<double>();
+        }
+        return 0;
+    }
+
+    /// Returns the string value of key, or an empty string.
+    static std::string text(const json& object, const char* key) {
+        if (auto value = object.find(key); value != object.end() && value->is_string()) {
+            return *value;
+        }
+        return {};
+    }
+
+    /// Returns the seconds until the next expected change in a status or run response, or 0 if unknown.
+    static double untilChange(const json& response) {
+        double soonest = 0;
+        auto consider = [&soonest](double value) {
+            if (value > 0 && (soonest == 0 || value < soonest)) {
+                soonest = value;
+            }
+        };
+        consider(seconds(response, "protocolTimeRemaining"));
+        if (auto run = response.find("protocolRun"); run != response.end() && run->is_object()) {
+            if (auto time = run->find("time"); time != run->end() && time->is_object()) {
+                consider(seconds(*time, "remaining"));
+                consider(seconds(*time, "hold"));
+                consider(seconds(*time, "totalRemaining"));
+            }
+        }
+        if (auto time = response.find("time"); time != response.end() && time->is_object()) {
+            consider(seconds(*time, "remaining"));
+            consider(seconds(*time, "hold"));
+        }
+        return soonest;
+    }
+
+    /// Keeps an interval between the minimum and the maximum.
+    [[nodiscard]] Interval clamp(Interval interval) const {
+        return std::clamp(interval, minimum, maximum);
+    }
+
+public:
+
+    /**
+     * @brief Sets up a policy.
+     * @param minimum_ Shortest wait between polls; the only wait for a fixed policy.
+     * @param maximum_ Longest wait between polls.
+     * @param jitter_ Fraction of the interval added or removed at random, from 0 to 1.
+     * @param adaptive_ True to adapt the interval to each response.
+     */
+    PollingPolicy(Interval minimum_, Interval maximum_, double jitter_, bool adaptive_) :
+            minimum(minimum_),
+            maximum(std::max(minimum_, maximum_)),
+            jitter(std::clamp(jitter_, 0.0, 1.0)),
+            adaptive(adaptive_) {
+    }
+
+    /// Makes a policy that always waits the same number of seconds, like the monitor always has.
+    static PollingPolicy fixed(int64_t intervalSeconds) {
+        Interval interval = std::chrono::seconds(intervalSeconds);
+        return PollingPolicy(interval, interval, 0, false);
+    }
+
+    /**
+     * @brief Chooses the wait before the next poll.
+     * @param response Parsed body of the last response.
+     * @return Time to wait.
+     */
+    Interval next(const json& response) {
+        if (!adaptive) {
+            return minimum;
+        }
+        std::string lid = response.is_object() ? text(response, "lid") : std::string();
+        std::string status = response.is_object() ? text(response, "status") : std::string();
+        std::string state = status + '/' + lid;
+
+        Interval interval;
+        if (lid == "opening" || lid == "closing" || status == "opening" || status == "closing") {
+            interval = minimum;
+        } else if (state != lastState && !lastState.empty()) {
+            interval = minimum;
+        } else if (double remaining = response.is_object() ? untilChange(response) : 0; remaining > 0 && status != "paused") {
+            interval = std::chrono::duration_cast<Interval>(std::chrono::duration<double>(remaining / 2));
+        } else {
+            interval = lastInterval.count() > 0 ? lastInterval * 2 : minimum;
+        }
+        lastState = state;
+        lastInterval = clamp(interval);
+
+        if (jitter > 0) {
+            std::uniform_real_distribution<double> spread(1 - jitter, 1 + jitter);
+            return clamp(std::chrono::duration_cast<Interval>(lastInterval * spread(random)));
+        }
+        return lastInterval;
+    }
+};
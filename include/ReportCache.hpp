@@ -0,0 +1,391 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "RunReports.hpp"
+#include "TempoClient.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class ReportCache
+ * @brief Keeps a local copy of the run reports of one PTC Tempo.
+ *
+ * A finished run report never changes, so once it has been fetched it can be served from disk.
+ * The cache has one directory per host with two parts.
+ * - objects: each report body in a file named by the hash of its contents.
+ * - index.bin: one entry per report in the same most-recent-first order as the instrument, with
+ *   the report ID, the list entry as compact JSON, and the hash of the full report if it has
+ *   been fetched.
+ *
+ * The index is small enough to read whole, so listings and lookups by ID need one file read.
+ * A sync relies on the list being sorted most recent first: it reads pages from the start of
+ * the list until it reaches a report that is already cached, and then fetches only the new
+ * reports.
+ */
+class ReportCache {
+
+    /// Marks the start of an index file; the number is the format version.
+    static constexpr char magic[4] = {'T', 'R', 'C', '2'};
+    /// Number of list entries requested per page during a sync.
+    static const int64_t pageSize = 100;
+
+    /**
+     * @struct Entry
+     * @brief One report in the index.
+     */
+    struct Entry {
+        std::string id;           ///< Report ID.
+        std::string summary;      ///< List entry as compact JSON.
+        uint64_t reportHash = 0;  ///< Hash of the full report in objects, or 0 if not fetched.
+    };
+
+    /// Directory for this host.
+    std::filesystem::path directory;
+    /// Entries in most-recent-first order.
+    std::vector<Entry> entries;
+    /// Position of each entry by report ID.
+    std::unordered_map<std::string, size_t> positions;
+
+    /// Returns the FNV-1a hash of text, used to name objects by their contents.
+    static uint64_t hash(const std::string& text) {
+        uint64_t value = 14695981039346656037ull;
+        for (unsigned char c : text) {
+            value = (value ^ c) * 1099511628211ull;
+        }
+        return value == 0 ? 1 : value;
+    }
+
+    /// Returns the path of the object with the given hash.
+    [[nodiscard]] std::filesystem::path objectPath(uint64_t objectHash) const {
+        char name[24];
+        std::snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(objectHash));
+        return directory / "objects" / name;
+    }
+
+    /// Writes a value to the index in little-endian order.
+    template<typename Integer>
+    static void writeInt(std::ostream& out, Integer value) {
+        for (size_t i = 0; i < sizeof(Integer); ++i) {
+            out.put(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xff));
+        }
+    }
+
+    /// Reads a little-endian value from the index.
+    template<typename Integer>
+    static bool readInt(std::istream& in, Integer& value) {
+        uint64_t result = 0;
+        for (size_t i = 0; i < sizeof(Integer); ++i) {
+            int c = in.get();
+            if (c == EOF) {
+                return false;
+            }
+            result |= static_cast<uint64_t>(c) << (8 * i);
+        }
+        value = static_cast<Integer>(result);
+        return true;
+    }
+
+    /**
+     * @brief Reads a length-prefixed string from the index.
+     * @param in Index stream.
+     * @param text Output parameter for the string.
+     * @param fileSize Size of the index file; a length past its end means the index is damaged.
+     */
+    static bool readString(std::istream& in, std::string& text, uint64_t fileSize) {
+        uint32_t length;
+        if (!readInt(in, length)) {
+            return false;
+        }
+        auto position = in.tellg();
+        if (position < 0 || length > fileSize - static_cast<uint64_t>(position)) {
+            return false;
+        }
+        text.resize(length);
+        return static_cast<bool>(in.read(text.data(), length));
+    }
+
+    /// Returns the body of an object, or nothing if it is missing or no longer matches its hash.
+    [[nodiscard]] std::optional<std::string> object(uint64_t objectHash) const {
+        std::ifstream file(objectPath(objectHash), std::ios::in | std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+        std::stringstream body;
+        body << file.rdbuf();
+        std::string text = body.str();
+        if (hash(text) != objectHash) {
+            return std::nullopt;
+        }
+        return text;
+    }
+
+    /**
+     * @brief Stores a report body as an object and returns its hash, or 0 if it could not be written.
+     *
+     * An object that is already there is kept only if its contents still match its name, so a
+     * damaged object is replaced.
+     */
+    uint64_t store(const std::string& body) {
+        uint64_t objectHash = hash(body);
+        auto path = objectPath(objectHash);
+        if (!object(objectHash)) {
+            auto partial = path;
+            partial += ".partial";
+            std::ofstream file(partial, std::ios::out | std::ios::binary);
+            file << body;
+            // the last of the body may only reach the disk when the file is closed
+            file.close();
+            bool written = !file.fail();
+            std::error_code error;
+            if (written) {
+                std::filesystem::rename(partial, path, error);
+            }
+            if (!written || error) {
+                std::filesystem::remove(partial, error);
+                return 0;
+            }
+        }
+        return objectHash;
+    }
+
+    /// Rebuilds the positions after entries changed order.
+    void reindex() {
+        positions.clear();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            positions[entries[i].id] = i;
+        }
+    }
+
+public:
+
+    /**
+     * @brief Opens the cache for a host and reads its index, if any.
+     * @param cacheDir Directory that holds the caches of all hosts.
+     * @param host URL for PTC-Tempo; used to name the directory for this host.
+     */
+    ReportCache(const std::string& cacheDir, const std::string& host) {
+        std::string name = host;
+        for (auto& c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') {
+                c = '_';
+            }
+        }
+        directory = std::filesystem::path(cacheDir) / name;
+
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(directory / "index.bin", error);
+        std::ifstream in(directory / "index.bin", std::ios::in | std::ios::binary);
+        char header[4];
+        uint64_t count;
+        if (error || !in || !in.read(header, sizeof(header)) || std::string(header, 4) != std::string(magic, 4)
+            || !readInt(in, count)) {
+            return;
+        }
+        entries.reserve(std::min<uint64_t>(count, 100000));
+        for (uint64_t i = 0; i < count; ++i) {
+            Entry entry;
+            if (!readString(in, entry.id, fileSize) || !readString(in, entry.summary, fileSize)
+                || !readInt(in, entry.reportHash)) {
+                // a damaged index is ignored, and the next sync builds a new one
+                entries.clear();
+                return;
+            }
+            entries.push_back(std::move(entry));
+        }
+        reindex();
+    }
+
+    /// Returns true if the cache holds at least one report.
+    [[nodiscard]] bool exists() const {
+        return !entries.empty();
+    }
+
+    /// Returns the number of reports in the cache.
+    [[nodiscard]] size_t size() const {
+        return entries.size();
+    }
+
+    /**
+     * @brief Writes the index. The old index is replaced only once the new one is complete.
+     * @return True if the index was written.
+     */
+    bool save() const {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        auto path = directory / "index.bin";
+        auto partial = directory / "index.bin.partial";
+        std::ofstream out(partial, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(magic, sizeof(magic));
+        writeInt(out, static_cast<uint64_t>(entries.size()));
+        for (const auto& entry : entries) {
+            writeInt(out, static_cast<uint32_t>(entry.id.size()));
+            out << entry.id;
+            writeInt(out, static_cast<uint32_t>(entry.summary.size()));
+            out << entry.summary;
+            writeInt(out, entry.reportHash);
+        }
+        out.close();
+        if (!out.fail()) {
+            std::filesystem::rename(partial, path, error);
+            if (!error) {
+                return true;
+            }
+        }
+        std::filesystem::remove(partial, error);
+        return false;
+    }
+
+    /**
+     * @brief Gets a full report from the cache.
+     * @param id Report ID.
+     * @return The report body, or nothing if the report has not been fetched or its object is damaged.
+     */
+    [[nodiscard]] std::optional<std::string> report(const std::string& id) const {
+        auto position = positions.find(id);
+        if (position == positions.end() || entries[position->second].reportHash == 0) {
+            return std::nullopt;
+        }
+        return object(entries[position->second].reportHash);
+    }
+
+    /**
+     * @brief Stores a full report that was fetched from the instrument.
+     * @param id Report ID. Reports not in the index yet are not stored.
+     * @param body Report body as received.
+     * @return True if the report was stored and the index needs to be saved.
+     */
+    bool putReport(const std::string& id, const std::string& body) {
+        auto position = positions.find(id);
+        if (position == positions.end()) {
+            return false;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(directory / "objects", error);
+        entries[position->second].reportHash = store(body);
+        return entries[position->second].reportHash != 0;
+    }
+
+    /**
+     * @brief Builds a list of reports from the cache in the same shape as /tempo/run-reports.
+     * @param limit Number of reports, or 0 for all.
+     * @param offset Index of the first report, most recent first.
+     */
+    [[nodiscard]] json list(int64_t limit, int64_t offset) const {
+        json reports = json::array();
+        for (const auto& summary : summaries(limit, offset)) {
+            reports.push_back(json::parse(summary));
+        }
+        return json{{"reports", reports}};
+    }
+
+    /**
+     * @brief Gets list entries from the cache as compact JSON, without parsing them.
+     * @param limit Number of reports, or 0 for all.
+     * @param offset Index of the first report, most recent first.
+     */
+    [[nodiscard]] std::vector<std::string> summaries(int64_t limit, int64_t offset) const {
+        std::vector<std::string> result;
+        size_t first = offset > 0 ? static_cast<size_t>(offset) : 0;
+        size_t last = limit > 0 ? first + static_cast<size_t>(limit) : entries.size();
+        for (size_t i = first; i < last && i < entries.size(); ++i) {
+            result.push_back(entries[i].summary);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Fetches the reports added on the instrument since the last sync.
+     *
+     * The list is read from the start, page by page, until a report that is already cached is
+     * found. Those new list entries are added to the front of the index, and each new report is
+     * fetched and stored. The index is saved at the end.
+     *
+     * The new reports are fetched from the oldest, and fetching stops at the first that fails.
+     * Only the reports older than that one are added, so the cache always holds the most recent
+     * reports up to some point without gaps, and the next sync fetches the rest. List entries
+     * without an id are not cached.
+     * @param tempoClient Client connected to the instrument of this cache.
+     * @param added Output parameter for the number of reports added.
+     * @return True if every new report was added. If a request fails, this emits a message to stderr.
+     */
+    bool sync(TempoClient& tempoClient, int64_t& added) {
+        added = 0;
+        tempoClient.reportsCount();
+        json response;
+        if (!tempoClient.result(response)) {
+            std::cerr << "Error. Unable to get the report count: " << response.dump() << std::endl;
+            return false;
+        }
+        int64_t count = RunReports::count(response);
+
+        std::vector<Entry> fresh;
+        bool reachedCache = false;
+        for (int64_t offset = 0; !reachedCache && (count < 0 || offset < count); offset += pageSize) {
+            tempoClient.reports(pageSize, offset);
+            json page;
+            const json* list = tempoClient.result(page) ? RunReports::list(page) : nullptr;
+            if (list == nullptr) {
+                std::cerr << "Error. Unable to get the report list at offset " << offset << ": " << page.dump() << std::endl;
+                return false;
+            }
+            for (const auto& summary : *list) {
+                std::string id = RunReports::id(summary);
+                if (id.empty()) {
+                    continue;
+                }
+                if (positions.count(id) > 0) {
+                    reachedCache = true;
+                    break;
+                }
+                fresh.push_back(Entry{id, summary.dump(), 0});
+            }
+            if (static_cast<int64_t>(list->size()) < pageSize) {
+                break;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(directory / "objects", error);
+        size_t kept = fresh.size();
+        for (; kept > 0; --kept) {
+            Entry& entry = fresh[kept - 1];
+            tempoClient.reports(entry.id);
+            if (tempoClient.statusOK()) {
+                entry.reportHash = store(tempoClient.body());
+            }
+            if (entry.reportHash == 0) {
+                std::cerr << "Error. Unable to fetch or store the report " << entry.id << "." << std::endl;
+                break;
+            }
+        }
+        bool complete = kept == 0;
+
+        // the entries from kept on are older than the one that failed, and follow the cached ones
+        added = static_cast<int64_t>(fresh.size() - kept);
+        entries.insert(entries.begin(), std::make_move_iterator(fresh.begin() + static_cast<std::ptrdiff_t>(kept)),
+                       std::make_move_iterator(fresh.end()));
+        reindex();
+        return save() && complete;
+    }
+};
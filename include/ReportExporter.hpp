@@ -0,0 +1,305 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "RunReports.hpp"
+#include "TempoClient.hpp"
+#include "WorkerPool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class ReportExporter
+ * @brief Copies every run report from PTC Tempo into a directory.
+ *
+ * The export is planned from the report count. Pages of the report list are fetched with
+ * limit and offset, and every report found in a page is fetched by its ID. Pages and reports
+ * are fetched on a WorkerPool, so the number of concurrent requests is bounded by jobs. Each
+ * worker keeps its own TempoClient, so each one reuses its connection.
+ *
+ * Each report is written to {id}.json as received, and the list entries are appended to
+ * index.ndjson. Reports that already have a file are not fetched again, so an interrupted or
+ * failed export can be run again to pick up where it stopped. Failed requests are retried with
+ * a growing delay. Progress and throughput are written to stderr once a second.
+ */
+class ReportExporter {
+
+    /// Delay before the first retry; doubled for each retry after that.
+    static constexpr std::chrono::milliseconds retryDelay{250};
+
+    /// URL for PTC-Tempo.
+    std::string host;
+    /// Password for Automation user.
+    std::string password;
+    /// Number of seconds to wait for each response.
+    int32_t waitTime;
+    /// Directory that receives the reports.
+    std::filesystem::path directory;
+    /// Maximum number of requests at the same time.
+    size_t jobs;
+    /// Number of reports in each page of the list.
+    int64_t pageSize;
+    /// Number of times a failed request is retried.
+    int64_t retries;
+
+    /// Guards idleClients, index and failures.
+    std::mutex mutex;
+    /// Clients not in use by a worker; one is made for each worker that needs one.
+    std::vector<std::unique_ptr<TempoClient>> idleClients;
+    /// List entries of all reports.
+    std::ofstream index;
+    /// Descriptions of pages and reports that failed after all retries.
+    std::vector<std::string> failures;
+
+    /// Number of reports written.
+    std::atomic<int64_t> exported{0};
+    /// Number of reports skipped because they were already in the directory.
+    std::atomic<int64_t> skipped{0};
+    /// Number of report bytes written.
+    std::atomic<int64_t> bytes{0};
+    /// Number of requests retried.
+    std::atomic<int64_t> retried{0};
+
+    /// Takes a client for the calling worker.
+    std::unique_ptr<TempoClient> acquire() {
+        std::scoped_lock lock(mutex);
+        if (idleClients.empty()) {
+            return std::make_unique<TempoClient>(host, password, waitTime);
+        }
+        auto client = std::move(idleClients.back());
+        idleClients.pop_back();
+        return client;
+    }
+
+    /// Returns a client so another worker can reuse its connection.
+    void release(std::unique_ptr<TempoClient> client) {
+        std::scoped_lock lock(mutex);
+        idleClients.push_back(std::move(client));
+    }
+
+    /**
+     * @brief Makes a request until it succeeds or all retries are used.
+     * @param tempoClient Client that makes the request.
+     * @param request Function that makes the request.
+     * @return True if the response status is 200.
+     */
+    template<typename Request>
+    bool attempt(TempoClient& tempoClient, Request request) {
+        auto delay = retryDelay;
+        for (int64_t i = 0; ; ++i) {
+            request();
+            if (tempoClient.statusOK() || i >= retries) {
+                return tempoClient.statusOK();
+            }
+            ++retried;
+            std::this_thread::sleep_for(delay);
+            delay *= 2;
+        }
+    }
+
+    /// Records a failure after all retries.
+    void failed(const std::string& what) {
+        std::scoped_lock lock(mutex);
+        failures.push_back(what);
+    }
+
+    /**
+     * @brief Returns true if a report id can be used as a file name in the export directory.
+     *
+     * The id comes from the instrument, so an id with a path separator or .. is not used, as it
+     * could name a file outside the directory.
+     */
+    static bool safeName(const std::string& id) {
+        return !id.empty() && id.find_first_of("/\\:") == std::string::npos && id.find("..") == std::string::npos;
+    }
+
+    /**
+     * @brief Fetches one page of the list and queues the reports in it that are not exported yet.
+     */
+    void exportPage(WorkerPool& pool, int64_t offset) {
+        auto client = acquire();
+        json page;
+        bool ok = attempt(*client, [&]() { client->reports(pageSize, offset); }) && client->result(page);
+        release(std::move(client));
+        const json* list = ok ? RunReports::list(page) : nullptr;
+        if (list == nullptr) {
+            failed("page at offset " + std::to_string(offset));
+            return;
+        }
+
+        std::string lines;
+        for (const auto& entry : *list) {
+            lines += entry.dump() + '\n';
+            std::string id = RunReports::id(entry);
+            if (id.empty()) {
+                continue;
+            }
+            if (!safeName(id)) {
+                failed("report " + id + ", whose id is not a file name");
+                continue;
+            }
+            if (std::filesystem::exists(directory / (id + ".json"))) {
+                ++skipped;
+                continue;
+            }
+            pool.post([this, id]() { exportReport(id); });
+        }
+        std::scoped_lock lock(mutex);
+        index << lines;
+    }
+
+    /**
+     * @brief Fetches one report and writes it to the directory.
+     *
+     * The report is written to a temporary file that is renamed once complete, so a file with
+     * the report's name always holds a whole report.
+     */
+    void exportReport(const std::string& id) {
+        auto client = acquire();
+        bool ok = attempt(*client, [&]() { client->reports(id); });
+        if (ok) {
+            auto path = directory / (id + ".json");
+            auto partial = directory / (id + ".json.partial");
+            std::ofstream file(partial, std::ios::out | std::ios::binary);
+            file << client->body();
+            // the last of the report may only reach the disk when the file is closed
+            file.close();
+            ok = !file.fail();
+            std::error_code error;
+            if (ok) {
+                std::filesystem::rename(partial, path, error);
+                ok = !error;
+            }
+            if (!ok) {
+                // a partial file would be taken for a whole report by the next export
+                std::filesystem::remove(partial, error);
+            }
+            if (ok) {
+                ++exported;
+                bytes += static_cast<int64_t>(client->body().size());
+            }
+        }
+        release(std::move(client));
+        if (!ok) {
+            failed("report " + id);
+        }
+    }
+
+    /// Writes one line of progress to stderr.
+    void progress(int64_t total, std::chrono::steady_clock::time_point start, bool last) const {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = seconds > 0 ? static_cast<double>(exported) / seconds : 0;
+        double megabytes = static_cast<double>(bytes) / 1e6;
+        std::cerr << "\rExported " << exported << " of " << total << " reports (" << skipped << " already present), "
+                  << std::fixed << std::setprecision(1) << rate << " reports/s, "
+                  << (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << (last ? "\n" : "") << std::flush;
+    }
+
+public:
+
+    /**
+     * @brief Sets up the export. Nothing is fetched until run is called.
+     * @param host_ URL for PTC-Tempo.
+     * @param password_ Plaintext password for Automation user on PTC-Tempo.
+     * @param waitTime_ Number of seconds to wait for each response.
+     * @param directory_ Directory that receives the reports; created if needed.
+     * @param jobs_ Maximum number of requests at the same time.
+     * @param pageSize_ Number of reports in each page of the list.
+     * @param retries_ Number of times a failed request is retried.
+     */
+    ReportExporter(const std::string& host_, const std::string& password_, int32_t waitTime_,
+                   const std::string& directory_, size_t jobs_, int64_t pageSize_, int64_t retries_) :
+            host(host_),
+            password(password_),
+            waitTime(waitTime_),
+            directory(directory_),
+            jobs(jobs_),
+            pageSize(pageSize_ > 0 ? pageSize_ : 100),
+            retries(retries_ > 0 ? retries_ : 0) {
+    }
+
+    /**
+     * @brief Exports every report.
+     * @return True if every page and report was exported; failures are listed on stderr.
+     */
+    bool run() {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            std::cerr << "Error. Unable to create " << directory << ": " << error.message() << std::endl;
+            return false;
+        }
+        index.open(directory / "index.ndjson", std::ios::out | std::ios::trunc);
+
+        TempoClient tempoClient(host, password, waitTime);
+        tempoClient.reportsCount();
+        if (!tempoClient.statusOK()) {
+            return tempoClient.print();
+        }
+        json countResponse;
+        int64_t total = tempoClient.result(countResponse) ? RunReports::count(countResponse) : -1;
+        if (total < 0) {
+            std::cerr << "Error. The response to the report count has no count." << std::endl;
+            return false;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::mutex doneMutex;
+        std::condition_variable doneSignal;
+        bool done = false;
+        std::thread reporter([&]() {
+            std::unique_lock lock(doneMutex);
+            while (!doneSignal.wait_for(lock, std::chrono::seconds(1), [&]() { return done; })) {
+                progress(total, start, false);
+            }
+        });
+        {
+            WorkerPool pool(jobs);
+            for (int64_t offset = 0; offset < total; offset += pageSize) {
+                pool.post([this, &pool, offset]() { exportPage(pool, offset); });
+            }
+            pool.wait();
+        }
+        {
+            std::scoped_lock lock(doneMutex);
+            done = true;
+        }
+        doneSignal.notify_one();
+        reporter.join();
+        progress(total, start, true);
+
+        tempoClient.reportsCount();
+        json after;
+        if (tempoClient.result(after) && RunReports::count(after) > total) {
+            std::cerr << RunReports::count(after) - total << " reports were added during the export. "
+                      << "Run the export again to add them." << std::endl;
+        }
+        if (retried > 0) {
+            std::cerr << retried << " requests were retried." << std::endl;
+        }
+        for (const auto& failure : failures) {
+            std::cerr << "Failed: " << failure << std::endl;
+        }
+        return failures.empty();
+    }
+};
@@ -0,0 +1,210 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "TempoClient.hpp"
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using nlohmann::json;
+
+/**
+ * @class ReportStream
+ * @brief Writes run reports to an output stream while the list of reports is still arriving.
+ *
+ * The list body is fed to write in whatever pieces the HTTP library receives. A small scanner
+ * tracks strings and nesting depth, and cuts out each object in the first array of the body.
+ * Only the report being cut out is held in memory, so memory use does not grow with the number
+ * of reports. Each report is parsed on its own and written in one of these formats.
+ * - json: A JSON array of reports, indented like other output.
+ * - ndjson: One report per line in compact JSON.
+ * - text: Each report as text, with a blank line between reports.
+ *
+ * If the body holds no array, it is printed whole like any other response once it has arrived.
+ */
+class ReportStream {
+
+    /// Number of spaces for indenting JSON and text output.
+    static const int indent = 2;
+
+    /// Where the reports are written.
+    std::ostream& out;
+    /// Output format: json, ndjson or text.
+    std::string format;
+
+    /// Nesting depth of objects and arrays at the current byte.
+    int depth = 0;
+    /// Depth of the objects in the report array, or -1 until the array is found.
+    int reportDepth = -1;
+    /// True after the report array has ended.
+    bool arrayDone = false;
+    /// True while inside a JSON string.
+    bool inString = false;
+    /// True if the previous byte in a string was a backslash.
+    bool escape = false;
+    /// True while the bytes of a report are being collected.
+    bool collecting = false;
+    /// Bytes of the report being collected. The capacity is reused for the next report.
+    std::string report;
+    /// Body received before the report array was found; used if there is no array.
+    std::string prefix;
+    /// Number of reports written.
+    size_t reports = 0;
+    /// False if a report could not be parsed.
+    bool valid = true;
+
+    /// Parses the collected report and writes it in the output format.
+    void emit() {
+        json entry;
+        try {
+            entry = json::parse(report);
+        } catch (json::exception& ex) {
+            std::cerr << ex.what() << std::endl;
+            valid = false;
+            return;
+        }
+        if (format == "ndjson") {
+            out << entry.dump() << '\n';
+        } else if (format == "text") {
+            std::string text = entry.dump(indent);
+            out << (reports > 0 ? "\n" : "") << TempoClient::formatResponseForTextDisplay(text);
+        } else {
+            std::string text = entry.dump(indent);
+            out << (reports > 0 ? ",\n  " : "[\n  ");
+            for (char c : text) {
+                out << c;
+                if (c == '\n') {
+                    out << "  ";
+                }
+            }
+        }
+        ++reports;
+    }
+
+public:
+
+    /**
+     * @brief Sets up the stream. Nothing is written until reports arrive.
+     * @param out_ Stream that receives the reports, usually std::cout.
+     * @param format_ Output format: json, ndjson or text. Anything else is treated as json.
+     */
+    ReportStream(std::ostream& out_, std::string_view format_) :
+            out(out_),
+            format(format_) {
+    }
+
+    /**
+     * @brief Scans the next piece of the response body and writes any reports it completes.
+     *
+     * This has the signature of an httplib::ContentReceiver.
+     * @param data Next bytes of the body.
+     * @param length Number of bytes.
+     * @return True to keep receiving, false if the output stream failed.
+     */
+    bool write(const char* data, size_t length) {
+        if (arrayDone) {
+            return true;
+        }
+        size_t start = 0;
+        for (size_t i = 0; i < length; ++i) {
+            char c = data[i];
+            if (inString) {
+                if (escape) {
+                    escape = false;
+                } else if (c == '\\') {
+                    escape = true;
+                } else if (c == '"') {
+                    inString = false;
+                }
+                continue;
+            }
+            switch (c) {
+                case '"':
+                    inString = true;
+                    break;
+                case '{':
+                    if (depth == reportDepth && !collecting) {
+                        collecting = true;
+                        start = i;
+                    }
+                    ++depth;
+                    break;
+                case '[':
+                    ++depth;
+                    if (reportDepth < 0) {
+                        reportDepth = depth;
+                        prefix.clear();
+                        prefix.shrink_to_fit();
+                    }
+                    break;
+                case '}':
+                    --depth;
+                    if (collecting && depth == reportDepth) {
+                        report.append(data + start, i + 1 - start);
+                        emit();
+                        report.clear();
+                        collecting = false;
+                    }
+                    break;
+                case ']':
+                    --depth;
+                    if (depth < reportDepth) {
+                        arrayDone = true;
+                        return static_cast<bool>(out);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (collecting) {
+            report.append(data + start, length - start);
+        } else if (reportDepth < 0) {
+            prefix.append(data, length);
+        }
+        return static_cast<bool>(out);
+    }
+
+    /**
+     * @brief Finishes the output after the whole body has been received.
+     * @return True if every report was valid JSON and was written.
+     */
+    bool finish() {
+        if (reportDepth < 0) {
+            // no array in the body, so print it like any other response
+            try {
+                json response = prefix.empty() ? json::object() : json::parse(prefix);
+                response["httpCode"] = 200;
+                std::string text = response.dump(indent);
+                if (format == "ndjson") {
+                    out << response.dump() << '\n';
+                } else if (format == "text") {
+                    out << TempoClient::formatResponseForTextDisplay(text);
+                } else {
+                    out << text << '\n';
+                }
+            } catch (json::exception& ex) {
+                std::cerr << ex.what() << std::endl;
+                return false;
+            }
+        } else if (format == "json") {
+            out << (reports > 0 ? "\n]\n" : "[]\n");
+        }
+        out.flush();
+        return valid && static_cast<bool>(out);
+    }
+
+    /// Returns the number of reports written.
+    [[nodiscard]] size_t count() const {
+        return reports;
+    }
+};
@@ -0,0 +1,402 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "RunReports.hpp"
+#include "WorkerPool.hpp"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class ReportTable
+ * @brief Writes run reports as a table, one row per report and one column per field.
+ *
+ * Fields are paths into a report, with dots between the keys, e.g. "protocol.name" or
+ * "steps.0.temperature". A field that is not in the list entry is looked up in the full report
+ * when a loader is given, so the report cache can fill in details the list does not have.
+ *
+ * Two formats are written.
+ * - csv: A header line with the field names, then one line per report as in RFC 4180. Missing
+ *   values are empty, and objects and arrays are written as compact JSON.
+ * - columnar: A binary layout for dataframes, described below.
+ *
+ * The reports are split into chunks that are parsed and formatted on a WorkerPool, one chunk
+ * per task. The chunks are written in order as they are finished, and only a few chunks per
+ * thread are in memory at once, so the output is the same as from a single thread.
+ *
+ * The columnar file starts with "TCOL", a version, the number of columns and each column name.
+ * A row group follows for each chunk: the number of rows, the length of the rest of the group,
+ * and each column in field order. A column is a type byte, a bitmap with a bit set for each row
+ * that has a value, and the values.
+ * - int64 (0) and double (1): 8 bytes per row.
+ * - bool (2): 1 byte per row.
+ * - string (3): rows + 1 offsets of 4 bytes into the text, then the text. Values that are not
+ *   strings in a column of mixed types are written as compact JSON.
+ *
+ * Numbers are little-endian, and lengths are 4 bytes except the group length, which is 8.
+ */
+class ReportTable {
+
+public:
+
+    /// Gets the full report with an ID, or nothing if it is not available.
+    using Loader = std::function<std::optional<std::string>(const std::string& id)>;
+
+private:
+
+    /// Number of reports formatted by each task.
+    static const size_t chunkRows = 512;
+    /// Number of chunks per thread formatted ahead of the one being written.
+    static const size_t chunksAhead = 4;
+    /// Marks the start of a columnar file.
+    static constexpr char magic[4] = {'T', 'C', 'O', 'L'};
+    /// Columnar format version.
+    static const uint32_t version = 1;
+
+    /// Column types in the columnar format.
+    enum class ColumnType : uint8_t { integer = 0, number = 1, boolean = 2, text = 3 };
+
+    /// Field names as given.
+    std::vector<std::string> fields;
+    /// JSON pointer for each field.
+    std::vector<json::json_pointer> pointers;
+    /// True for CSV, false for the columnar format.
+    bool csv;
+    /// Number of threads that format chunks.
+    size_t threads;
+    /// Gets full reports for fields that are not in the list entry.
+    Loader loader;
+    /// Number of list entries that could not be parsed.
+    std::atomic<int64_t> damaged{0};
+
+    /// Converts a dotted field name to a JSON pointer.
+    static json::json_pointer pointer(const std::string& field) {
+        std::string path;
+        for (char c : field) {
+            if (c == '.') {
+                path += '/';
+            } else if (c == '~') {
+                path += "~0";
+            } else if (c == '/') {
+                path += "~1";
+            } else {
+                path += c;
+            }
+        }
+        return json::json_pointer(field.empty() ? path : '/' + path);
+    }
+
+    /// Appends a little-endian value.
+    template<typename Integer>
+    static void putFixed(std::string& out, Integer value) {
+        for (size_t i = 0; i < sizeof(Integer); ++i) {
+            out.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xff));
+        }
+    }
+
+    /// Appends a value as a CSV cell.
+    static void putCell(std::string& out, const json* value) {
+        if (value == nullptr || value->is_null()) {
+            return;
+        }
+        if (value->is_boolean()) {
+            out += value->get<bool>() ? "true" : "false";
+            return;
+        }
+        if (value->is_number()) {
+            out += value->dump();
+            return;
+        }
+        std::string text = value->is_string() ? value->get_ref<const std::string&>() : value->dump();
+        if (text.find_first_of(",\"\r\n") == std::string::npos) {
+            out += text;
+            return;
+        }
+        out += '"';
+        for (char c : text) {
+            if (c == '"') {
+                out += '"';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+
+    /**
+     * @brief Parses the reports of a chunk and finds the value of each field.
+     * @param entries List entries as compact JSON.
+     * @param documents Output parameter that holds the parsed entries and full reports.
+     * @param values Output parameter with one value per field for each row, or nullptr if missing.
+     */
+    void resolve(const std::vector<std::string>& entries, size_t first, size_t last,
+                 std::vector<json>& documents, std::vector<const json*>& values) {
+        size_t rows = last - first;
+        documents.assign(rows * 2, json());
+        values.assign(rows * fields.size(), nullptr);
+        for (size_t row = 0; row < rows; ++row) {
+            json& entry = documents[row * 2];
+            entry = json::parse(entries[first + row], nullptr, false);
+            if (entry.is_discarded()) {
+                ++damaged;
+                entry = json();
+                continue;
+            }
+            json& report = documents[row * 2 + 1];
+            bool loaded = false;
+            for (size_t column = 0; column < fields.size(); ++column) {
+                const json* value = nullptr;
+                if (entry.contains(pointers[column])) {
+                    value = &entry.at(pointers[column]);
+                } else if (loader) {
+                    if (!loaded) {
+                        loaded = true;
+                        if (auto body = loader(RunReports::id(entry))) {
+                            report = json::parse(*body, nullptr, false);
+                        }
+                    }
+                    if (!report.is_discarded() && report.contains(pointers[column])) {
+                        value = &report.at(pointers[column]);
+                    }
+                }
+                values[row * fields.size() + column] = value;
+            }
+        }
+    }
+
+    /// Formats the reports from first to last as CSV lines.
+    std::string formatCsv(const std::vector<std::string>& entries, size_t first, size_t last) {
+        std::vector<json> documents;
+        std::vector<const json*> values;
+        resolve(entries, first, last, documents, values);
+        std::string out;
+        for (size_t row = 0; row < last - first; ++row) {
+            for (size_t column = 0; column < fields.size(); ++column) {
+                if (column > 0) {
+                    out += ',';
+                }
+                putCell(out, values[row * fields.size() + column]);
+            }
+            out += "\r\n";
+        }
+        return out;
+    }
+
+    /// Chooses the narrowest type that holds every value of a column.
+    static ColumnType columnType(const std::vector<const json*>& values, size_t column, size_t columns) {
+        bool integers = true;
+        bool numbers = true;
+        bool booleans = true;
+        for (size_t i = column; i < values.size(); i += columns) {
+            const json* value = values[i];
+            if (value == nullptr || value->is_null()) {
+                continue;
+            }
+            integers = integers && (value->is_number_integer()
+                                    && !(value->is_number_unsigned() && value->get<uint64_t>() > INT64_MAX));
+            numbers = numbers && value->is_number();
+            booleans = booleans && value->is_boolean();
+        }
+        if (integers && numbers) {
+            return ColumnType::integer;
+        }
+        if (numbers) {
+            return ColumnType::number;
+        }
+        return booleans ? ColumnType::boolean : ColumnType::text;
+    }
+
+    /// Formats the reports from first to last as one columnar row group.
+    std::string formatColumnar(const std::vector<std::string>& entries, size_t first, size_t last) {
+        std::vector<json> documents;
+        std::vector<const json*> values;
+        resolve(entries, first, last, documents, values);
+        size_t rows = last - first;
+        size_t columns = fields.size();
+
+        std::string body;
+        for (size_t column = 0; column < columns; ++column) {
+            ColumnType type = columnType(values, column, columns);
+            body.push_back(static_cast<char>(type));
+            std::string bitmap((rows + 7) / 8, '\0');
+            for (size_t row = 0; row < rows; ++row) {
+                const json* value = values[row * columns + column];
+                if (value != nullptr && !value->is_null()) {
+                    bitmap[row / 8] = static_cast<char>(bitmap[row / 8] | (1 << (row % 8)));
+                }
+            }
+            body += bitmap;
+
+            std::string text;
+            for (size_t row = 0; row < rows; ++row) {
+                const json* value = values[row * columns + column];
+                bool present = value != nullptr && !value->is_null();
+                if (type == ColumnType::integer) {
+                    putFixed(body, present ? value->get<int64_t>() : int64_t(0));
+                } else if (type == ColumnType::number) {
+                    double number = present ? value->get<double>() : 0;
+                    uint64_t bits;
+                    std::memcpy(&bits, &number, sizeof(bits));
+                    putFixed(body, bits);
+                } else if (type == ColumnType::boolean) {
+                    body.push_back(present && value->get<bool>() ? 1 : 0);
+                } else {
+                    putFixed(body, static_cast<uint32_t>(text.size()));
+                    if (present) {
+                        text += value->is_string() ? value->get_ref<const std::string&>() : value->dump();
+                    }
+                }
+            }
+            if (type == ColumnType::text) {
+                putFixed(body, static_cast<uint32_t>(text.size()));
+                body += text;
+            }
+        }
+
+        std::string group;
+        putFixed(group, static_cast<uint32_t>(rows));
+        putFixed(group, static_cast<uint64_t>(body.size()));
+        return group + body;
+    }
+
+    /// Returns the header line or the columnar file header.
+    [[nodiscard]] std::string header() const {
+        std::string out;
+        if (csv) {
+            for (size_t column = 0; column < fields.size(); ++column) {
+                if (column > 0) {
+                    out += ',';
+                }
+                json name = fields[column];
+                putCell(out, &name);
+            }
+            out += "\r\n";
+            return out;
+        }
+        out.append(magic, sizeof(magic));
+        putFixed(out, version);
+        putFixed(out, static_cast<uint32_t>(fields.size()));
+        for (const auto& field : fields) {
+            putFixed(out, static_cast<uint32_t>(field.size()));
+            out += field;
+        }
+        return out;
+    }
+
+public:
+
+    /**
+     * @brief Sets up a table.
+     * @param fields_ Dotted paths of the fields, one column each. If empty, the keys of the first
+     *  report with a value that is not an object or an array are used.
+     * @param format Either csv or columnar.
+     * @param threads_ Number of threads that format chunks. Values less than 1 are treated as 1.
+     * @param loader_ Gets full reports for fields that are not in the list entry; may be empty.
+     */
+    ReportTable(const std::vector<std::string>& fields_, const std::string& format, size_t threads_, Loader loader_ = nullptr) :
+            fields(fields_),
+            csv(format != "columnar"),
+            threads(threads_ > 0 ? threads_ : 1),
+            loader(std::move(loader_)) {
+    }
+
+    /// Returns true if a format name is csv or columnar.
+    static bool validFormat(const std::string& format) {
+        return format == "csv" || format == "columnar";
+    }
+
+    /// Returns the field names, including the ones chosen by write when none were given.
+    [[nodiscard]] const std::vector<std::string>& columns() const {
+        return fields;
+    }
+
+    /// Returns the number of list entries that were not valid JSON; they are written as empty rows.
+    [[nodiscard]] int64_t damagedRows() const {
+        return damaged;
+    }
+
+    /**
+     * @brief Writes the table.
+     * @param entries List entries of the reports as compact JSON, one row each.
+     * @param out Stream that receives the table.
+     * @return True if everything was written to the stream.
+     */
+    bool write(const std::vector<std::string>& entries, std::ostream& out) {
+        if (fields.empty() && !entries.empty()) {
+            json first = json::parse(entries.front(), nullptr, false);
+            if (first.is_object()) {
+                for (const auto& [key, value] : first.items()) {
+                    if (!value.is_structured()) {
+                        fields.push_back(key);
+                    }
+                }
+            }
+        }
+        pointers.clear();
+        for (const auto& field : fields) {
+            pointers.push_back(pointer(field));
+        }
+        std::string start = header();
+        out.write(start.data(), static_cast<std::streamsize>(start.size()));
+
+        size_t chunks = (entries.size() + chunkRows - 1) / chunkRows;
+        std::vector<std::string> formatted(chunks);
+        std::vector<bool> ready(chunks, false);
+        std::mutex mutex;
+        std::condition_variable chunkReady;
+        // declared last so its threads are joined before the state they use goes away
+        WorkerPool pool(std::min(threads, std::max<size_t>(chunks, 1)));
+
+        auto post = [&](size_t chunk) {
+            pool.post([&, chunk]() {
+                size_t first = chunk * chunkRows;
+                size_t last = std::min(first + chunkRows, entries.size());
+                std::string text = csv ? formatCsv(entries, first, last) : formatColumnar(entries, first, last);
+                {
+                    std::scoped_lock lock(mutex);
+                    formatted[chunk] = std::move(text);
+                    ready[chunk] = true;
+                }
+                chunkReady.notify_all();
+            });
+        };
+        size_t posted = 0;
+        for (; posted < chunks && posted < threads * chunksAhead; ++posted) {
+            post(posted);
+        }
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            std::string text;
+            {
+                std::unique_lock lock(mutex);
+                chunkReady.wait(lock, [&]() { return static_cast<bool>(ready[chunk]); });
+                text = std::move(formatted[chunk]);
+            }
+            if (posted < chunks) {
+                post(posted++);
+            }
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        out.flush();
+        return static_cast<bool>(out);
+    }
+};
@@ -0,0 +1,209 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "LatencyHistogram.hpp"
+#include "nlohmann/json.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+using nlohmann::json;
+
+/**
+ * @class RequestStats
+ * @brief Times each phase of the requests a TempoClient makes, with a histogram per path and phase.
+ *
+ * The phases of a request are:
+ * - connect: from sending a request that opened a new connection until the response started
+ *   to arrive. The HTTP library has no hook between the TCP connect and sending the request, so
+ *   this holds the connect, and for HTTPS the handshake, as well as the instrument's time.
+ *   Comparing it with wait shows what a new connection costs.
+ * - wait: the same, for a request sent on a connection that was already open.
+ * - read: from when the response started to arrive until the whole body arrived. Only GET
+ *   requests report the start of the response, so PUT and POST requests count reading in wait.
+ * - parse: JSON parsing or typed decoding of the body.
+ * - format: building the output text, including the text display format.
+ * - output: writing the output to the terminal.
+ *
+ * Run report IDs in paths are replaced by {id}, so all single report requests share a path.
+ */
+class RequestStats {
+
+public:
+
+    /// Clock for the phases.
+    using Clock = std::chrono::steady_clock;
+
+    /// Phase of a request.
+    enum Phase {
+        connect,
+        wait,
+        read,
+        parse,
+        format,
+        output,
+        phaseCount
+    };
+
+    /// Names of the phases in the output.
+    static constexpr std::array<const char*, phaseCount> phaseNames = {
+            "connect", "wait", "read", "parse", "format", "output"};
+
+    /**
+     * @struct Endpoint
+     * @brief Counts and phase times of the requests for one path.
+     */
+    struct Endpoint {
+        int64_t requests = 0;                               ///< Requests sent.
+        int64_t connections = 0;                            ///< Requests that opened a new connection.
+        std::array<LatencyHistogram, phaseCount> phases;    ///< Microseconds spent in each phase.
+    };
+
+private:
+
+    /// Counts and times by path.
+    std::map<std::string, Endpoint> endpoints;
+
+    /// Returns microseconds as milliseconds with three decimals.
+    static double milliseconds(double micros) {
+        return static_cast<double>(static_cast<int64_t>(micros + 0.5)) / 1000;
+    }
+
+public:
+
+    /**
+     * @brief Returns the path a request is counted under.
+     * @param target Path and query string of the request.
+     * @return The path without the query, and with a run report ID replaced by {id}.
+     */
+    static std::string endpoint(const std::string& target) {
+        std::string path = target.substr(0, target.find('?'));
+        static const std::string reports = "/tempo/run-reports/";
+        if (path.size() > reports.size() && path.compare(0, reports.size(), reports) == 0 && path != reports + "count") {
+            return reports + "{id}";
+        }
+        return path;
+    }
+
+    /**
+     * @brief Counts a request.
+     * @param path Path from endpoint.
+     * @param connected True if the request opened a new connection.
+     */
+    void request(const std::string& path, bool connected) {
+        auto& counts = endpoints[path];
+        ++counts.requests;
+        counts.connections += connected ? 1 : 0;
+    }
+
+    /**
+     * @brief Adds the time of one phase.
+     * @param path Path from endpoint.
+     * @param phase Phase of the request.
+     * @param time Time spent in the phase.
+     */
+    void add(const std::string& path, Phase phase, Clock::duration time) {
+        endpoints[path].phases[phase].record(std::chrono::duration_cast<std::chrono::microseconds>(time).count());
+    }
+
+    /// Adds the time since start to a phase.
+    void since(const std::string& path, Phase phase, Clock::time_point start) {
+        add(path, phase, Clock::now() - start);
+    }
+
+    /// Returns true if no request was counted.
+    [[nodiscard]] bool empty() const {
+        return endpoints.empty();
+    }
+
+    /// Returns the counts and times by path.
+    [[nodiscard]] const std::map<std::string, Endpoint>& paths() const {
+        return endpoints;
+    }
+
+    /**
+     * @brief Returns the counts, and the count, mean, p50, p99, p999 and maximum of each phase in
+     * milliseconds, by path.
+     */
+    [[nodiscard]] json toJson() const {
+        json paths = json::object();
+        for (const auto& [path, counts] : endpoints) {
+            json& entry = paths[path];
+            entry["requests"] = counts.requests;
+            entry["connections"] = counts.connections;
+            entry["phases"] = json::object();
+            for (size_t phase = 0; phase < phaseCount; ++phase) {
+                const LatencyHistogram& histogram = counts.phases[phase];
+                if (histogram.count() == 0) {
+                    continue;
+                }
+                entry["phases"][phaseNames[phase]] = {
+                        {"count", histogram.count()},
+                        {"mean", milliseconds(histogram.mean())},
+                        {"p50", milliseconds(static_cast<double>(histogram.percentile(0.5)))},
+                        {"p99", milliseconds(static_cast<double>(histogram.percentile(0.99)))},
+                        {"p999", milliseconds(static_cast<double>(histogram.percentile(0.999)))},
+                        {"max", milliseconds(static_cast<double>(histogram.max()))}};
+            }
+        }
+        return json{{"unit", "ms"}, {"paths", paths}};
+    }
+
+    /// Prints a table of the phase times in milliseconds, one row per path and phase.
+    void print(std::ostream& out) const {
+        if (endpoints.empty()) {
+            out << "No requests were timed." << std::endl;
+            return;
+        }
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-28s %-8s %8s %10s %10s %10s %10s %10s",
+                      "path", "phase", "count", "mean ms", "p50 ms", "p99 ms", "p999 ms", "max ms");
+        out << line << '\n';
+        for (const auto& [path, counts] : endpoints) {
+            for (size_t phase = 0; phase < phaseCount; ++phase) {
+                const LatencyHistogram& histogram = counts.phases[phase];
+                if (histogram.count() == 0) {
+                    continue;
+                }
+                std::snprintf(line, sizeof(line), "%-28s %-8s %8lld %10.3f %10.3f %10.3f %10.3f %10.3f",
+                              path.c_str(), phaseNames[phase], static_cast<long long>(histogram.count()),
+                              histogram.mean() / 1000, static_cast<double>(histogram.percentile(0.5)) / 1000,
+                              static_cast<double>(histogram.percentile(0.99)) / 1000,
+                              static_cast<double>(histogram.percentile(0.999)) / 1000,
+                              static_cast<double>(histogram.max()) / 1000);
+                out << line << '\n';
+            }
+        }
+        out << std::flush;
+    }
+
+    /**
+     * @brief Writes toJson to a file.
+     * @param path File to write.
+     * @return False if the file could not be written.
+     */
+    [[nodiscard]] bool write(const std::string& path) const {
+        std::ofstream file(path, std::ios::trunc);
+        file << toJson().dump(2) << std::endl;
+        if (!file) {
+            std::cerr << "Error. Could not write the request timings to " << path << "." << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
@@ -8,8 +8,32 @@
 // SPDX-License-Identifier: MIT
 //
 
+#pragma once
+
+#include "BatchScript.hpp"
 #include "Config.hpp"
+#include "Fleet.hpp"
 #include "Monitor.hpp"
+#include "ReportCache.hpp"
+#include "ReportExporter.hpp"
+#include "ReportStream.hpp"
+#include "ReportTable.hpp"
+#include "Telemetry.hpp"
+#include "TempoProxy.hpp"
+#include "MetricsExporter.hpp"
+#include "LoadGenerator.hpp"
+#include "Dispatcher.hpp"
+#include "Inventory.hpp"
+#ifndef WIN32
+#include "Daemon.hpp"
+#endif
+
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
 
 using nlohmann::json;
 
@@ -25,29 +49,299 @@ using nlohmann::json;
  *  - and calls Monitor object for repeatedly checking status of PTC Tempo.
  */
 class Router {
-    CLI::App* lidCommand;       ///< Contains subcommand to get lid status.
-    CLI::App* openCommand;      ///< Contains subcommand to open lid.
-    CLI::App* closeCommand;     ///< Contains subcommand to close lid.
-    CLI::App* statusCommand;    ///< Contains status subcommand and options.
-    CLI::App* faultCommand;     ///< Contains errors subcommand and options.
-    CLI::App* reportsCommand;   ///< Contains reports subcommand and options.
-    CLI::App* protocolsCommand; ///< Contains protocols subcommand and options.
-    CLI::App* runCommand;       ///< Contains subcommand and options to get run status or run protocol.
-    CLI::App* configCommand;    ///< Contains subcommand to update/print config file.
-    CLI::App* licenseCommand;   ///< Contains subcommand to print license info.
-    CLI::App* versionCommand;   ///< Contains subcommand to print version info.
-
-    CLI::App* stopCommand;      ///< Contains subcommand to stop currently active protocol run.
-    CLI::App* skipCommand;      ///< Contains subcommand to skip currently active step.
-    CLI::App* pauseCommand;     ///< Contains subcommand to pause currently active run.
-    CLI::App* resumeCommand;    ///< Contains subcommand to resume a protocol run.
+    /// Number of spaces for indenting JSON and text output.
+    static const int indent = 2;
+
+    /// Commands of the command line, in the order of the help.
+    enum class Command : uint8_t {
+        lid, open, close, status, errors, reports, protocols, run, stop, skip, pause, resume, license, version, config,
+        proxy, exporter, bench, wait, batch, dispatch, daemon, inventory, telemetry,
+        none  ///< No command; the default tempo request.
+    };
+    /// Number of commands.
+    static constexpr size_t commandCount = static_cast<size_t>(Command::none);
+
+    /**
+     * @struct CommandInfo
+     * @brief Entry of the command table: the name and help of a command and the functions that handle it.
+     */
+    struct CommandInfo {
+        Command command;                         ///< Command of the entry; the same as its position in the table.
+        const char* name;                        ///< Name on the command line.
+        const char* description;                 ///< Description in the help.
+        void (Router::*options)(CLI::App&);      ///< Adds the options of the command, or nullptr if it has none.
+        bool (*local)(Router&);                  ///< Runs a command that needs no client for --host, or nullptr.
+        bool (*request)(Router&, TempoClient&);  ///< Makes the one request of the command, or nullptr.
+    };
+
+    std::array<CLI::App*, commandCount> commandApps{}; ///< Subcommand of each command, or nullptr if it is not on this platform.
+    std::array<bool, commandCount> optionsAdded{};     ///< True once the options of a command have been added.
 
     Settings settings;          ///< Stores values from config file and command line options.
     Config tempoConfig;         ///< Manages config file.
 
+    // state kept between the commands served by a daemon
+    Settings defaults;          ///< Settings from the config file, restored before each command.
+    std::filesystem::file_time_type configTime; ///< Write time of the config file when it was read.
+    bool resident = false;      ///< True while serving commands as a daemon.
+    std::map<std::string, std::unique_ptr<TempoClient>> clients; ///< Open clients by host, password and wait time.
+    TempoClient* lastClient = nullptr; ///< Client used by the current command.
+    std::unique_ptr<TempoClient> commandClient; ///< Client made for the current command when not serving as a daemon.
+    RequestStats requestStats;  ///< Phase times of the requests of the current command, with --stats.
+
     /// Root command line arg handler for client app.
     CLI::App tempo = CLI::App("PTC Tempo command line interface to Automation API");
 
+    /**
+     * @brief Checks the command line options for the reports command.
+     *
+     * If the options are invalid, this emits a message to stderr and returns false.
+     * - countReports is mutually exclusive with all other report options.
+     * - runId is mutually exclusive with all other report options.
+     *
+     * @return True if command line options are valid for reports command, false if any are invalid.
+     */
+    bool checkReportsOptions() const {
+        if (!settings.runId.empty()) {
+            if (settings.countReports || ( settings.limit != 0 ) || ( settings.offset != 0 ) ) {
+                std::cerr << "Error. The --id option is not used with any other option." << std::endl;
+                return false;
+            }
+        } else if (settings.countReports) {
+            if ( !settings.runId.empty() || ( settings.limit != 0 ) || ( settings.offset != 0 ) ) {
+                std::cerr << "Error. The --count option is not used with any other option." << std::endl;
+                return false;
+            }
+        } else if ( !settings.runId.empty() || settings.countReports ) {
+            std::cerr << "Error. The --count and --id options are not used with --limit or --offset options." << std::endl;
+            return false;
+        }
+        if (settings.streamReports && (!settings.runId.empty() || settings.countReports)) {
+            std::cerr << "Error. The --stream option is not used with the --id or --count options." << std::endl;
+            return false;
+        }
+        if (!settings.exportDir.empty() && (!settings.runId.empty() || settings.countReports || settings.streamReports
+                                            || ( settings.limit != 0 ) || ( settings.offset != 0 ))) {
+            std::cerr << "Error. The --export option is only used with the --pageSize and --retries options." << std::endl;
+            return false;
+        }
+        if (settings.syncReports && (!settings.runId.empty() || settings.countReports || settings.streamReports
+                                     || settings.cachedReports || !settings.exportDir.empty()
+                                     || ( settings.limit != 0 ) || ( settings.offset != 0 ))) {
+            std::cerr << "Error. The --sync option is not used with any other option." << std::endl;
+            return false;
+        }
+        if (settings.cachedReports && (!settings.runId.empty() || settings.streamReports || !settings.exportDir.empty())) {
+            std::cerr << "Error. The --cached option is only used with the --limit, --offset, --count or --table options." << std::endl;
+            return false;
+        }
+        if (!settings.tableFile.empty() && (!settings.runId.empty() || settings.countReports || settings.streamReports
+                                            || !settings.exportDir.empty() || settings.syncReports)) {
+            std::cerr << "Error. The --table option is only used with the --limit, --offset, --cached, --fields and --format options." << std::endl;
+            return false;
+        }
+        if (settings.tableFile.empty() && (!settings.tableFields.empty() || settings.tableFormat != "csv")) {
+            std::cerr << "Error. The --fields and --format options require the --table option." << std::endl;
+            return false;
+        }
+        if (!ReportTable::validFormat(settings.tableFormat)) {
+            std::cerr << "Error. The --format option is either csv or columnar." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Prints a response that did not come straight from a TempoClient, in the display format.
+     * @param response Response to print.
+     */
+    void print(const json& response) const {
+        std::string responseResult = response.dump(indent);
+        if (settings.displayType == "text") {
+            responseResult = TempoClient::formatResponseForTextDisplay(responseResult);
+        }
+        std::cout << responseResult << std::endl;
+    }
+
+    /**
+     * @brief Copies the run reports added on PTC Tempo since the last sync into the report cache.
+     *
+     * This prints the number of reports added and the number now in the cache.
+     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
+     * @return True if the sync finished.
+     */
+    bool syncReports(TempoClient& tempoClient) const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
+        ReportCache cache(settings.cacheDir, settings.host);
+        int64_t added;
+        if (!cache.sync(tempoClient, added)) {
+            return false;
+        }
+        json response;
+        response["added"] = added;
+        response["cached"] = cache.size();
+        response["httpCode"] = 200;
+        print(response);
+        return true;
+    }
+
+    /**
+     * @brief Lists or counts the run reports in the report cache without contacting PTC Tempo.
+     * @return True if the options are valid.
+     */
+    bool cachedReports() const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
+        ReportCache cache(settings.cacheDir, settings.host);
+        json response;
+        if (settings.countReports) {
+            response["count"] = cache.size();
+        } else {
+            response = cache.list(settings.limit, settings.offset);
+        }
+        response["httpCode"] = 200;
+        print(response);
+        return true;
+    }
+
+    /**
+     * @brief Gets one run report from the report cache, or from PTC Tempo if it is not cached.
+     *
+     * A report fetched from PTC Tempo is added to the cache if its ID is already in the index
+     * from an earlier sync. A cached report whose object is damaged is fetched again, and the
+     * copy from PTC Tempo replaces the object.
+     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
+     * @return True if the report was printed.
+     */
+    bool cachedReport(TempoClient& tempoClient) const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
+        ReportCache cache(settings.cacheDir, settings.host);
+        if (auto body = cache.report(settings.runId)) {
+            try {
+                json response = json::parse(*body);
+                response["httpCode"] = 200;
+                print(response);
+                return true;
+            } catch (json::exception& ex) {
+                // the report is fetched again from the instrument
+                std::cerr << ex.what() << std::endl;
+            }
+        }
+        tempoClient.reports(settings.runId);
+        if (tempoClient.statusOK() && cache.putReport(settings.runId, tempoClient.body())) {
+            cache.save();
+        }
+        return tempoClient.print(settings.displayType);
+    }
+
+    /**
+     * @brief Exports every run report on PTC Tempo into the export directory.
+     * @return True if every report was exported.
+     */
+    bool exportReports() const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
+        ReportExporter exporter(settings.host, settings.password, static_cast<int32_t>(settings.waitTime),
+                                settings.exportDir, static_cast<size_t>(settings.jobs), settings.pageSize, settings.retries);
+        return exporter.run();
+    }
+
+    /**
+     * @brief Writes a list of run reports to stdout as they arrive from PTC Tempo.
+     *
+     * The output format is the display type; json, ndjson or text. If the response status is not
+     * 200, this reports the error the same way as TempoClient::print.
+     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
+     * @return True if all reports were received and written.
+     */
+    bool streamReports(TempoClient& tempoClient) const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
+        ReportStream stream(std::cout, settings.displayType);
+        tempoClient.reports(settings.limit, settings.offset, [&stream](const char* data, size_t length) {
+            return stream.write(data, length);
+        });
+        if (!tempoClient.statusOK()) {
+            return tempoClient.print(settings.displayType);
+        }
+        return stream.finish();
+    }
+
+    /**
+     * @brief Writes a list of run reports as a CSV or columnar table.
+     *
+     * The list comes from PTC Tempo, or from the report cache with --cached. Fields that are
+     * not in the list entries are read from the full reports in the report cache, so a sync
+     * before the table gives access to every field of a report. The table goes to the --table
+     * file, or to stdout for "-", and a summary goes to stderr.
+     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
+     * @return True if the table was written.
+     */
+    bool tableReports(TempoClient& tempoClient) const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
+        ReportCache cache(settings.cacheDir, settings.host);
+        std::vector<std::string> entries;
+        if (settings.cachedReports) {
+            entries = cache.summaries(settings.limit, settings.offset);
+        } else {
+            tempoClient.reports(settings.limit, settings.offset);
+            const json* list = tempoClient.statusOK() ? RunReports::list(tempoClient.parsed().body) : nullptr;
+            if (list == nullptr) {
+                return tempoClient.print(settings.displayType);
+            }
+            entries.reserve(list->size());
+            for (const auto& entry : *list) {
+                entries.push_back(entry.dump());
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ReportTable table(settings.tableFields, settings.tableFormat, std::thread::hardware_concurrency(),
+                          [&cache](const std::string& id) { return cache.report(id); });
+        bool written;
+        if (settings.tableFile == "-") {
+            written = table.write(entries, std::cout);
+        } else {
+            std::string partial = settings.tableFile + ".partial";
+            {
+                std::ofstream file(partial, std::ios::out | std::ios::binary | std::ios::trunc);
+                written = table.write(entries, file);
+                file.close();
+                written = written && !file.fail();
+            }
+            std::error_code error;
+            if (written) {
+                std::filesystem::rename(partial, settings.tableFile, error);
+                written = !error;
+            }
+            if (!written) {
+                // a table from an earlier run is kept rather than replaced by part of this one
+                std::filesystem::remove(partial, error);
+            }
+        }
+        if (!written) {
+            std::cerr << "Error. Unable to write " << settings.tableFile << "." << std::endl;
+            return false;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cerr << "Wrote " << entries.size() << " reports with " << table.columns().size() << " columns in "
+                  << seconds << " s" << std::endl;
+        if (table.damagedRows() > 0) {
+            std::cerr << "Error. " << table.damagedRows() << " list entries were not valid JSON and were written as empty rows." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
     /**
      * @brief Handles all commands related to run reports.
      *
@@ -60,49 +354,60 @@ class Router {
      *
      * This function also checks whether the user provided invalid command line options. If the options
      * are invalid, this emits a message to stderr and returns false.
-     * - countReports is mutually exclusive with all other report options.
-     * - runId is mutually exclusive with all other report options.
      *
      * @param tempoClient Object that manages HTTP calls to PTC Tempo.
      * @return True if command line options are valid for reports command, false if any are invalid.
      */
     bool handleReports(TempoClient& tempoClient) const {
+        if (!checkReportsOptions()) {
+            return false;
+        }
         if (!settings.runId.empty()) {
-            if (settings.countReports || ( settings.limit != 0 ) || ( settings.offset != 0 ) ) {
-                std::cerr << "Error. The --id option is not used with any other option." << std::endl;
-                return false;
-            }
             tempoClient.reports(settings.runId);
         } else if (settings.countReports) {
-            if ( !settings.runId.empty() || ( settings.limit != 0 ) || ( settings.offset != 0 ) ) {
-                std::cerr << "Error. The --count option is not used with any other option." << std::endl;
-                return false;
-            }
             tempoClient.reportsCount();
         } else {
-            if ( !settings.runId.empty() || settings.countReports ) {
-                std::cerr << "Error. The --count and --id options are not used with --limit or --offset options." << std::endl;
-                return false;
-            }
             tempoClient.reports(settings.limit, settings.offset);
         }
         return true;
     }
 
     /**
-     * @brief Handles requests for run status or to start a run.
+     * @brief Checks the adaptive polling options.
+     * @return True if the minimum interval is above zero and not more than the maximum.
+     */
+    bool checkPollingOptions() const {
+        if (settings.adaptive && (settings.minInterval <= 0 || settings.maxInterval < settings.minInterval)) {
+            std::cerr << "Error. The --minInterval option must be above 0 and not more than --maxInterval." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Makes the policy that decides how long to wait between polls when monitoring.
      *
-     * If the user provides a protocol name on the command line, this will start a run. If the
-     * user does not provide a protocol name, this will get current run status.
+     * Without --adaptive, every poll waits --interval seconds.
+     */
+    PollingPolicy pollingPolicy() const {
+        if (!settings.adaptive) {
+            return PollingPolicy::fixed(settings.interval);
+        }
+        auto toInterval = [](double seconds) {
+            return std::chrono::duration_cast<PollingPolicy::Interval>(std::chrono::duration<double>(seconds));
+        };
+        return PollingPolicy(toInterval(settings.minInterval), toInterval(settings.maxInterval), settings.jitter, true);
+    }
+
+    /**
+     * @brief Checks the command line options for the run command.
      *
-     * This checks for these invalid conditions for command line options.
      * - When getting run status, this checks if the user set any other command line options.
      * - When starting a run, this checks if the user requested both a public protocol and a template.
      *
-     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
      * @return True if command line options are valid for run command, false if any are invalid.
      */
-    bool handleRun(TempoClient& tempoClient) {
+    bool checkRunOptions() const {
         if (settings.protocol.empty()) {
             if ( settings.publicProtocols || settings.templateProtocol
                 || !settings.plateID.empty() || !settings.runName.empty()
@@ -110,20 +415,142 @@ class Router {
                 std::cerr << "Error. The --volume, --plate, --name, --public, --templates, --monitor, and --temp options require the --protocol option." << std::endl;
                 return false;
             }
-            // get the run status
-            tempoClient.run();
+        } else if ( settings.publicProtocols && settings.templateProtocol ) {
+            std::cerr << "Error. The --public and --templates options are mutually exclusive." << std::endl;
+            return false;
+        }
+        if (!settings.recordFile.empty() && !settings.monitor) {
+            std::cerr << "Error. The --record option requires the --monitor flag." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Prints samples or a summary of a recorded telemetry file, without contacting PTC Tempo.
+     *
+     * The --from and --to options are seconds after the first sample in the file. With --every,
+     * the samples in each bucket of that many seconds are combined into one, with the mean of
+     * each temperature. With --display ndjson, each sample is written on its own line as it is read.
+     * @return True if the file was read.
+     */
+    bool readTelemetry() const {
+        TelemetryReader reader(settings.telemetryFile);
+        if (!reader.isOpen()) {
+            std::cerr << "Error. Could not read the telemetry file " << settings.telemetryFile << "." << std::endl;
+            return false;
+        }
+        if (settings.telemetryInfo) {
+            json info;
+            info["file"] = settings.telemetryFile;
+            info["blocks"] = reader.blockCount();
+            info["samples"] = reader.sampleCount();
+            info["firstTime"] = reader.firstTime();
+            info["lastTime"] = reader.lastTime();
+            info["seconds"] = static_cast<double>(reader.lastTime() - reader.firstTime()) / 1000;
+            info["bytes"] = reader.fileSize();
+            info["bytesPerSample"] = reader.sampleCount() > 0
+                    ? static_cast<double>(reader.validSize()) / static_cast<double>(reader.sampleCount()) : 0;
+            info["incompleteBytes"] = reader.fileSize() - reader.validSize();
+            print(info);
             return true;
         }
 
-        if ( settings.publicProtocols && settings.templateProtocol ) {
-            std::cerr << "Error. The --public and --templates options are mutually exclusive." << std::endl;
+        auto toMillis = [](double seconds) {
+            return static_cast<int64_t>(seconds * 1000);
+        };
+        int64_t from = reader.firstTime() + toMillis(settings.telemetryFrom);
+        int64_t to = settings.telemetryTo < 0 ? reader.lastTime() : reader.firstTime() + toMillis(settings.telemetryTo);
+        bool lines = settings.displayType == "ndjson";
+        json samples = json::array();
+        bool success = reader.read(from, to, toMillis(settings.telemetryEvery), [&](const TelemetrySample& sample) {
+            if (lines) {
+                std::cout << sample.toJson().dump() << '\n';
+            } else {
+                samples.push_back(sample.toJson());
+            }
+        });
+        if (lines) {
+            std::cout << std::flush;
+        } else {
+            json response;
+            response["samples"] = std::move(samples);
+            print(response);
+        }
+        return success;
+    }
+
+    /// Returns the path of the index of the inventory file, which has the same name with the extension .idx.
+    [[nodiscard]] std::string inventoryIndex() const {
+        return std::filesystem::path(settings.inventoryFile).replace_extension(".idx").string();
+    }
+
+    /**
+     * @brief Replaces the --instrument, --group and --tag options with the hosts they name in the
+     * inventory.
+     *
+     * One instrument, without --hosts, becomes the host of the command; more become the --hosts
+     * list. The names are cleared afterwards, so the settings can be copied for the commands of
+     * a batch without naming the instruments twice.
+     * @return False if the inventory cannot be read or does not have a name; this emits a message to stderr.
+     */
+    bool selectInstruments() {
+        Inventory inventory(settings.inventoryFile, inventoryIndex());
+        std::vector<uint32_t> selected;
+        if (!inventory.isOpen() || !inventory.select(settings.instrumentNames, settings.groupNames, settings.tagNames, selected)) {
             return false;
         }
+        if (selected.size() == 1 && settings.hosts.empty()) {
+            settings.host = inventory.instrument(selected.front()).host;
+        } else {
+            for (uint32_t position : selected) {
+                settings.hosts.emplace_back(inventory.instrument(position).host);
+            }
+        }
+        settings.instrumentNames.clear();
+        settings.groupNames.clear();
+        settings.tagNames.clear();
+        return true;
+    }
 
-        json run;
-        run["protocolName"] = settings.protocol;
-        run["location"] = settings.publicProtocols ? "public" : settings.templateProtocol ? "templates" : "user";
-        // apply a default plateID and runName one isn't provide
+    /**
+     * @brief Prints the instruments of the inventory, or those chosen by --instrument, --group and
+     * --tag, compiling its index first if it changed or --compile was given.
+     * @return True if the inventory was read and every name was found.
+     */
+    bool listInventory() {
+        if (settings.compileInventory && !Inventory::compile(settings.inventoryFile, inventoryIndex())) {
+            return false;
+        }
+        Inventory inventory(settings.inventoryFile, inventoryIndex());
+        if (!inventory.isOpen()) {
+            return false;
+        }
+        std::vector<uint32_t> selected;
+        if (settings.instrumentNames.empty() && settings.groupNames.empty() && settings.tagNames.empty()) {
+            for (uint32_t position = 0; position < inventory.size(); ++position) {
+                selected.push_back(position);
+            }
+        } else if (!inventory.select(settings.instrumentNames, settings.groupNames, settings.tagNames, selected)) {
+            return false;
+        }
+        json instruments = json::array();
+        for (uint32_t position : selected) {
+            instruments.push_back(inventory.toJson(position));
+        }
+        json response;
+        response["instruments"] = std::move(instruments);
+        print(response);
+        return true;
+    }
+
+    /**
+     * @brief Applies a default plateID and runName if the user did not provide them.
+     *
+     * Once applied, the values stay the same for the rest of the session, so calling this again does not
+     * change them.
+     */
+    void applyRunDefaults() {
         // consider moving this to the config for defaults
         if (settings.plateID.empty() || settings.runName.empty()) {
             auto timestamp = std::chrono::system_clock::now();
@@ -136,6 +563,45 @@ class Router {
                 settings.runName = "run" + settings.protocol + suffix;
             }
         }
+    }
+
+    /**
+     * @brief Handles requests for run status or to start a run.
+     *
+     * If the user provides a protocol name on the command line, this will start a run. If the
+     * user does not provide a protocol name, this will get current run status.
+     *
+     * This checks for these invalid conditions for command line options.
+     * - When getting run status, this checks if the user set any other command line options.
+     * - When starting a run, this checks if the user requested both a public protocol and a template.
+     *
+     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
+     * @return True if command line options are valid for run command, false if any are invalid.
+     */
+    bool handleRun(TempoClient& tempoClient) {
+        if (!checkRunOptions()) {
+            return false;
+        }
+        if (settings.protocol.empty()) {
+            // get the run status
+            tempoClient.run();
+            return true;
+        }
+
+        tempoClient.run(runBody());
+        return true;
+    }
+
+    /**
+     * @brief Returns the body of the request that starts a run with the run options in the settings.
+     *
+     * Applies the default plateID and runName if they were not given.
+     */
+    json runBody() {
+        json run;
+        run["protocolName"] = settings.protocol;
+        run["location"] = settings.publicProtocols ? "public" : settings.templateProtocol ? "templates" : "user";
+        applyRunDefaults();
         run["runName"] = settings.runName;
         run["plateID"] = settings.plateID;
         if (settings.volume > 0) {
@@ -144,14 +610,245 @@ class Router {
         if (settings.lidTemp > 0) {
             run["lidTemp"] = settings.lidTemp;
         }
-        tempoClient.run(run);
-        return true;
+        return run;
+    }
+
+    /// Adds the options of the lid command.
+    void lidOptions(CLI::App& app) {
+        app.add_flag("--monitor", settings.monitor, "Monitor lid status.");
+        app.add_option("--interval", settings.interval, "Set interval for polling lid status. Requires --monitor flag.");
+        app.add_flag("--adaptive", settings.adaptive, "Poll quickly while the lid moves and slowly otherwise. Requires --monitor flag.");
+    }
+
+    /// Adds the options of the status command.
+    void statusOptions(CLI::App& app) {
+        app.add_flag("--monitor", settings.monitor, "Monitor instrument status.");
+        app.add_option("--interval", settings.interval, "Set interval for instrument status refresh. Requires --monitor flag.");
+        app.add_flag("--adaptive", settings.adaptive, "Adapt the refresh interval to the progress of the run. Requires --monitor flag.");
+    }
+
+    /// Adds the options of the errors command.
+    void errorsOptions(CLI::App& app) {
+        app.add_flag("--clear", settings.clearFaults, "Clear device faults.");
+    }
+
+    /// Adds the options of the reports command.
+    void reportsOptions(CLI::App& app) {
+        app.add_option("--id", settings.runId, "Run id of the report to retrieve. Not used with any other options.");
+        app.add_option("--limit", settings.limit, "Number of reports to retrieve. Not used with --id or --count options.");
+        app.add_option("--offset", settings.offset, "Offset at which to start retrieving the list of reports. Not used with --id or --count options.");
+        app.add_flag("--count", settings.countReports, "Returns the total count of reports. Not used with any other options.");
+        app.add_flag("--stream", settings.streamReports, "Writes each report as it arrives. With --display ndjson, writes one report per line. Not used with --id or --count options.");
+        app.add_option("--export", settings.exportDir, "Directory to export all reports into, one file per report.");
+        app.add_option("--pageSize", settings.pageSize, "Number of reports in each page of the list. Requires the --export option.");
+        app.add_option("--retries", settings.retries, "Number of times a failed request is retried. Requires the --export option.");
+        app.add_flag("--sync", settings.syncReports, "Copies the reports added since the last sync into the local cache. Not used with any other options.");
+        app.add_flag("--cached", settings.cachedReports, "Lists or counts reports from the local cache instead of the instrument.");
+        app.add_option("--cacheDir", settings.cacheDir, "Directory of the local report cache. Default: reports-cache");
+        app.add_option("--table", settings.tableFile, "File to write the reports into as a table, one row per report, or - for stdout.");
+        app.add_option("--fields", settings.tableFields, "Comma separated list of report fields for the table columns, e.g. id,protocol.name. Requires the --table option.")->delimiter(',');
+        app.add_option("--format", settings.tableFormat, "Table format: csv or columnar. Default: csv. Requires the --table option.");
+    }
+
+    /// Adds the options of the protocols command.
+    void protocolsOptions(CLI::App& app) {
+        app.add_flag("--public", settings.publicProtocols, "List the Public protocols instead of user protocols.");
+    }
+
+    /// Adds the options of the run command.
+    void runOptions(CLI::App& app) {
+        app.add_option("--protocol", settings.protocol, "Name of the protocol to run.");
+        app.add_option("--name", settings.runName, "Name for the run. Requires the --protocol option.");
+        app.add_option("--plate", settings.plateID, "ID of the plate used in the run. Requires the --protocol option.");
+        app.add_option("--volume", settings.volume, "Volume for the run. Requires the --protocol option.");
+        app.add_option("--temp", settings.lidTemp, "Lid temperature for the run. Requires the --protocol option.");
+        app.add_flag("--public", settings.publicProtocols, "Protocol is in the Public location instead of user location. Requires the --protocol option.");
+        app.add_flag("--templates", settings.templateProtocol, "Use a template protocol. Requires the --protocol option.");
+        app.add_flag("--monitor", settings.monitor, "Monitor run status. Requires the --protocol option.");
+        app.add_option("--interval", settings.interval, "Set interval for run status refresh. Requires --monitor flag.");
+        app.add_flag("--adaptive", settings.adaptive, "Adapt the refresh interval to the progress of the run. Requires --monitor flag.");
+        app.add_option("--record", settings.recordFile, "Appends each run status to a telemetry file. Requires --monitor flag.");
+    }
+
+    /// Adds the options of the proxy command.
+    void proxyOptions(CLI::App& app) {
+        app.add_option("--address", settings.proxyAddress, "Address to listen on. Default: 127.0.0.1");
+        app.add_option("--port", settings.proxyPort, "Port to listen on. Default: 8081");
+        app.add_option("--threads", settings.proxyThreads, "Number of client requests served at the same time. Default: 64");
+        app.add_option("--ttl", settings.keepTimes, "Comma separated list of path=seconds that set how long responses for a path are kept, e.g. /tempo/status=2.")->delimiter(',');
+    }
+
+    /// Adds the options of the exporter command.
+    void exporterOptions(CLI::App& app) {
+        app.add_option("--address", settings.metricsAddress, "Address to listen on. Default: 127.0.0.1");
+        app.add_option("--port", settings.metricsPort, "Port to listen on. Default: 9464");
+        app.add_option("--interval", settings.interval, "Set interval in seconds for polling the instrument. Default: 1");
+    }
+
+    /// Adds the options of the bench command.
+    void benchOptions(CLI::App& app) {
+        app.add_option("--rate", settings.benchRate, "Requests per second for all connections, or 0 to send each request as soon as the last is answered. Default: 10");
+        app.add_option("--concurrency", settings.benchConcurrency, "Number of connections. Default: 8");
+        app.add_option("--duration", settings.benchDuration, "Seconds to send requests for. Default: 10");
+        app.add_option("--mix", settings.benchMix, "Comma separated list of name=weight, where name is tempo, status, lid, run, errors, protocols, count or reports. Default: status=4,lid=2,run=2,tempo=1,reports=1")->delimiter(',');
+        app.add_option("--pageSize", settings.pageSize, "Number of reports in each reports request. Default: 100");
+    }
+
+    /// Adds the options of the wait command.
+    void waitOptions(CLI::App& app) {
+        app.add_option("condition", settings.waitCondition, "Condition of the form field=value or field!=value, where field is status or lid. Separate several values with |.")->required();
+        app.add_option("--timeout", settings.waitTimeout, "Seconds to poll before failing. Default: 600");
+        app.add_option("--interval", settings.waitInterval, "Seconds between polls. Default: 0.5");
+    }
+
+    /// Adds the options of the batch command.
+    void batchOptions(CLI::App& app) {
+        app.add_option("file", settings.batchFile, "File of commands, or - for stdin. Default: -");
+        app.add_flag("--continue", settings.batchContinue, "Runs the rest of the commands after one fails.");
+    }
+
+    /// Adds the options of the dispatch command.
+    void dispatchOptions(CLI::App& app) {
+        app.add_option("queue", settings.queueFile, "File of runs, one line of run command options each, or - for stdin.")->required();
+        app.add_option("--interval", settings.dispatchInterval, "Seconds between the polls of each instrument. Default: 2");
+        app.add_option("--lid", settings.readyLids, "Lid states in which a run may be started, e.g. closedWithPlate. Default: any");
+        app.add_option("--attempts", settings.dispatchAttempts, "Times to try to start a run before failing it. Default: 3");
+    }
+
+    /// Adds the options of the config command.
+    void configOptions(CLI::App& app) {
+        tempoConfig.options(app);
+    }
+
+    /// Adds the options of the daemon command.
+    void daemonOptions(CLI::App& app) {
+        app.add_option("--socket", settings.socketPath, "Path of the socket. Default: TEMPOCLIENT_SOCKET or tempoclient.sock");
+    }
+
+    /// Adds the options of the inventory command.
+    void inventoryOptions(CLI::App& app) {
+        app.add_flag("--compile", settings.compileInventory, "Compiles the index of the inventory even if it is up to date.");
+    }
+
+    /// Adds the options of the telemetry command.
+    void telemetryOptions(CLI::App& app) {
+        app.add_option("file", settings.telemetryFile, "Telemetry file to read.")->required();
+        app.add_option("--from", settings.telemetryFrom, "Seconds after the first sample where reading starts.");
+        app.add_option("--to", settings.telemetryTo, "Seconds after the first sample where reading ends.");
+        app.add_option("--every", settings.telemetryEvery, "Combines the samples in each bucket of this many seconds into one.");
+        app.add_flag("--info", settings.telemetryInfo, "Prints the number of blocks and samples, the time range and the size of the file.");
+    }
+
+    /**
+     * @brief Returns the table of commands, in the order of the Command enum.
+     *
+     * route, routeFleet and request look up the command here instead of comparing names.
+     */
+    static const std::array<CommandInfo, commandCount>& commandTable() {
+        static constexpr std::array<CommandInfo, commandCount> table = {{
+            {Command::lid, "lid", "Gets the instrument lid status.", &Router::lidOptions, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.lid(); return true; }},
+            {Command::open, "open", "Opens the instrument lid.", nullptr, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.openLid(); return true; }},
+            {Command::close, "close", "Closes the instrument lid.", nullptr, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.closeLid(); return true; }},
+            {Command::status, "status", "Gets a brief status of the instrument and currently running protocol.", &Router::statusOptions, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.status(); return true; }},
+            {Command::errors, "errors", "Gets a list of device faults.", &Router::errorsOptions, nullptr,
+             [](Router& router, TempoClient& tempoClient) { tempoClient.faults(router.settings.clearFaults); return true; }},
+            {Command::reports, "reports", "Gets a list of run reports for the Automation user or retrieves the details of a specific run report.", &Router::reportsOptions, nullptr,
+             [](Router& router, TempoClient& tempoClient) { return router.handleReports(tempoClient); }},
+            {Command::protocols, "protocols", "Lists all protocols present in the Automation user's My Files folder.", &Router::protocolsOptions, nullptr,
+             [](Router& router, TempoClient& tempoClient) { tempoClient.protocols(router.settings.publicProtocols); return true; }},
+            {Command::run, "run", "If used without options, it provides run status. If used with --protocol option, it starts a run.", &Router::runOptions, nullptr,
+             [](Router& router, TempoClient& tempoClient) { return router.handleRun(tempoClient); }},
+            {Command::stop, "stop", "Stops the protocol run.", nullptr, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.stop(); return true; }},
+            {Command::skip, "skip", "Skips the currently active step in the protocol run.", nullptr, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.skip(); return true; }},
+            {Command::pause, "pause", "Pauses the protocol run.", nullptr, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.pause(); return true; }},
+            {Command::resume, "resume", "Resumes the protocol run.", nullptr, nullptr,
+             [](Router&, TempoClient& tempoClient) { tempoClient.resume(); return true; }},
+            {Command::license, "license", "Prints the copyright licenses.", nullptr,
+             [](Router&) { Config::license(); return true; }, nullptr},
+            {Command::version, "version", "Prints the versions and checks the Automation API compatibility.", nullptr, nullptr, nullptr},
+            {Command::config, "config", "Sets the default values in config.json.", &Router::configOptions,
+             [](Router& router) {
+                 router.tempoConfig.save();
+                 router.tempoConfig.print(router.settings.displayType);
+                 return true;
+             }, nullptr},
+            {Command::proxy, "proxy", "Serves the instrument's API to many clients, sharing and briefly keeping its responses.", &Router::proxyOptions,
+             [](Router& router) { return router.runProxy(); }, nullptr},
+            {Command::exporter, "exporter", "Polls the instrument in the background and serves its state as OpenMetrics for Prometheus.", &Router::exporterOptions,
+             [](Router& router) { return router.runExporter(); }, nullptr},
+            {Command::bench, "bench", "Sends a mix of requests at a set rate and reports the throughput, latency percentiles, errors and timeouts.", &Router::benchOptions,
+             [](Router& router) { return router.runBench(); }, nullptr},
+            {Command::wait, "wait", "Polls the status or lid until a condition holds, e.g. lid=opened or status!=running.", &Router::waitOptions, nullptr, nullptr},
+            {Command::batch, "batch", "Runs the commands in a file, one per line, over one connection and times each of them.", &Router::batchOptions,
+             [](Router& router) { return router.runBatch(); }, nullptr},
+            {Command::dispatch, "dispatch", "Starts a queue of runs, each on the next instrument of --hosts that is idle, and reports the utilisation of each instrument.", &Router::dispatchOptions,
+             [](Router& router) { return router.runDispatch(); }, nullptr},
+#ifndef WIN32
+            {Command::daemon, "daemon", "Serves commands over a local socket, keeping the config and instrument connections open.", &Router::daemonOptions,
+             [](Router& router) { return router.runDaemon(); }, nullptr},
+#else
+            {Command::daemon, "daemon", "Serves commands over a local socket, keeping the config and instrument connections open.", &Router::daemonOptions, nullptr, nullptr},
+#endif
+            {Command::inventory, "inventory", "Lists the instruments of the inventory, or those chosen by --instrument, --group and --tag.", &Router::inventoryOptions,
+             [](Router& router) { return router.listInventory(); }, nullptr},
+            {Command::telemetry, "telemetry", "Prints the samples in a telemetry file recorded with run --record.", &Router::telemetryOptions,
+             [](Router& router) { return router.readTelemetry(); }, nullptr},
+        }};
+        static_assert([]() {
+            for (size_t i = 0; i < commandCount; ++i) {
+                if (static_cast<size_t>(table[i].command) != i) {
+                    return false;
+                }
+            }
+            return true;
+        }(), "The command table is not in the order of the Command enum.");
+        return table;
+    }
+
+    /// Returns the position of a command in the command table.
+    static size_t index(Command command) {
+        return static_cast<size_t>(command);
+    }
+
+    /**
+     * @brief Adds the options of a command to its subcommand, once.
+     *
+     * This runs when the parsing of the command starts, so the options of the other commands
+     * are never set up. It runs again for each command of a batch or daemon, after tempo.clear().
+     * @param command Command whose options are added.
+     */
+    void addOptions(Command command) {
+        const CommandInfo& info = commandTable()[index(command)];
+        if (optionsAdded[index(command)] || info.options == nullptr) {
+            return;
+        }
+        optionsAdded[index(command)] = true;
+        (this->*info.options)(*commandApps[index(command)]);
+    }
+
+    /// Returns the parsed command, or Command::none if the command line has none.
+    Command parsedCommand() const {
+        for (size_t i = 0; i < commandCount; ++i) {
+            if (commandApps[i] != nullptr && commandApps[i]->parsed()) {
+                return static_cast<Command>(i);
+            }
+        }
+        return Command::none;
     }
 
 public:
 
     /**
-     * @brief Constructor sets up all the command line options used to run the client app.
+     * @brief Constructor sets up the global options and the commands of the command line.
+     *
+     * The options of each command are added by addOptions when that command is parsed.
      */
     Router() {
         tempo.require_subcommand(0, 1);
@@ -160,57 +857,473 @@ public:
         tempo.add_option("--waitTime", settings.waitTime, "Sets how long to wait for a response in seconds.");
         tempo.add_option("--interval", settings.interval, "Sets polling interval in seconds when monitoring.");
         tempo.add_option("--display", settings.displayType, "Sets output display format - options: text or json.");
+        tempo.add_option("--minInterval", settings.minInterval, "Sets the shortest polling interval in seconds with --adaptive.");
+        tempo.add_option("--maxInterval", settings.maxInterval, "Sets the longest polling interval in seconds with --adaptive.");
+        tempo.add_option("--jitter", settings.jitter, "Sets the fraction of the polling interval that varies at random with --adaptive.");
+        tempo.add_option("--hosts", settings.hosts, "Comma separated list of instrument host strings. Sends the command to all of them at once.")->delimiter(',');
+        tempo.add_option("--jobs", settings.jobs, "Sets the maximum number of concurrent requests with --hosts or reports --export.");
+        tempo.add_option("--instrument", settings.instrumentNames, "Comma separated list of instrument names in the inventory that receive the command.")->delimiter(',');
+        tempo.add_option("--group", settings.groupNames, "Comma separated list of inventory groups whose instruments receive the command.")->delimiter(',');
+        tempo.add_option("--tag", settings.tagNames, "Comma separated list of inventory tags whose instruments receive the command.")->delimiter(',');
+        tempo.add_option("--inventory", settings.inventoryFile, "Sets the inventory file of named instruments. Default: inventory.json");
+        tempo.add_flag("--local", settings.local, "Runs the command in this process even if a daemon is running.");
+        tempo.add_option("--socket", settings.socketPath, "Sets the path of the daemon socket that the command is sent to. Default: TEMPOCLIENT_SOCKET or tempoclient.sock");
+        tempo.add_flag("--stats", settings.stats, "Prints the time of each phase of the requests to stderr at exit, with percentiles for each path.");
+        tempo.add_option("--statsFile", settings.statsFile, "Writes the time of each phase of the requests to this file as JSON at exit.");
 
-        lidCommand = tempo.add_subcommand("lid", "Gets the instrument lid status.");
-        lidCommand->add_flag("--monitor", settings.monitor, "Monitor lid status.");
-        lidCommand->add_option("--interval", settings.interval, "Set interval for polling lid status. Requires --monitor flag.");
+        for (const auto& info : commandTable()) {
+#ifdef WIN32
+            if (info.command == Command::daemon) {
+                continue;
+            }
+#endif
+            CLI::App* app = tempo.add_subcommand(info.name, info.description);
+            commandApps[index(info.command)] = app;
+            if (info.options != nullptr) {
+                // most runs use one command, so only its options are set up, as its parsing starts
+                Command command = info.command;
+                app->preparse_callback([this, command](size_t) {
+                    addOptions(command);
+                });
+            }
+        }
+    }
 
-        openCommand = tempo.add_subcommand("open", "Opens the instrument lid.");
-        closeCommand = tempo.add_subcommand("close", "Closes the instrument lid.");
-        
-        statusCommand = tempo.add_subcommand("status", "Gets a brief status of the instrument and currently running protocol.");
-        statusCommand->add_flag("--monitor", settings.monitor, "Monitor instrument status.");
-        statusCommand->add_option("--interval", settings.interval, "Set interval for instrument status refresh. Requires --monitor flag.");
+    /**
+     * @brief Initialize the settings using the config file and command line args.
+     */
+    void initialize() {
+        configTime = tempoConfig.modified();
+        tempoConfig.initialize(settings);
+        defaults = settings;
+    }
 
-        faultCommand = tempo.add_subcommand("errors", "Gets a list of device faults.");
-        faultCommand->add_flag("--clear", settings.clearFaults, "Clear device faults.");
+    /**
+     * @brief Parses and runs one command line, as main does, for the daemon and the batch command.
+     * @param args Arguments after the program name.
+     * @param base Settings before the arguments are parsed.
+     * @param allowed Returns false, with a message to stderr, for commands that may not run here.
+     * @return Exit code of the command.
+     */
+    int execute(const std::vector<std::string>& args, const Settings& base, const std::function<bool()>& allowed) {
+        settings = base;
+        tempo.clear();
+        std::vector<std::string> reversed(args.rbegin(), args.rend());
+        try {
+            tempo.parse(reversed);
+        } catch (const CLI::ParseError& error) {
+            return tempo.exit(error);
+        }
+        if (!allowed()) {
+            return 1;
+        }
+        return run();
+    }
 
-        reportsCommand = tempo.add_subcommand("reports", "Gets a list of run reports for the Automation user or retrieves the details of a specific run report.");
-        reportsCommand->add_option("--id", settings.runId, "Run id of the report to retrieve. Not used with any other options.");
-        reportsCommand->add_option("--limit", settings.limit, "Number of reports to retrieve. Not used with --id or --count options.");
-        reportsCommand->add_option("--offset", settings.offset, "Offset at which to start retrieving the list of reports. Not used with --id or --count options.");
-        reportsCommand->add_flag("--count", settings.countReports, "Returns the total count of reports. Not used with any other options.");
+#ifndef WIN32
+    /**
+     * @brief Runs one command sent to the daemon, as main does for a command line.
+     *
+     * The settings go back to the values from the config file before the arguments are parsed,
+     * and the config file is read again if it was written since it was last read. Connections to
+     * instruments are kept for the next command.
+     * @param args Arguments after the program name.
+     * @return Exit code of the command.
+     */
+    int serve(const std::vector<std::string>& args) {
+        if (tempoConfig.modified() != configTime) {
+            settings = Settings();
+            initialize();
+        }
+        return execute(args, defaults, [this]() {
+            Command command = parsedCommand();
+            if (settings.monitor || command == Command::daemon || command == Command::proxy || command == Command::exporter
+                || command == Command::bench || command == Command::batch || command == Command::dispatch) {
+                std::cerr << "Error. Monitoring and the daemon, proxy, exporter, bench, batch and dispatch commands are not run by the daemon." << std::endl;
+                return false;
+            }
+            return true;
+        });
+    }
 
-        protocolsCommand = tempo.add_subcommand("protocols", "Lists all protocols present in the Automation user's My Files folder.");
-        protocolsCommand->add_flag("--public", settings.publicProtocols, "List the Public protocols instead of user protocols.");
+    /**
+     * @brief Serves commands on the daemon socket until the process is stopped.
+     * @return True if the daemon stopped normally.
+     */
+    bool runDaemon() {
+        // the same path that Daemon::socketPath finds for the commands sent to this daemon
+        std::string socketPath = settings.socketPath.empty() ? Daemon::defaultPath() : settings.socketPath;
+        resident = true;
+        TempoClient::exitOnError(false);
+        Daemon daemon(socketPath, [this](const std::vector<std::string>& args) {
+            return serve(args);
+        });
+        bool success = daemon.run();
+        resident = false;
+        TempoClient::exitOnError(true);
+        clients.clear();
+        return success;
+    }
+#endif
 
-        runCommand = tempo.add_subcommand("run", "If used without options, it provides run status. If used with --protocol option, it starts a run.");
-        runCommand->add_option("--protocol", settings.protocol, "Name of the protocol to run.");
-        runCommand->add_option("--name", settings.runName, "Name for the run. Requires the --protocol option.");
-        runCommand->add_option("--plate", settings.plateID, "ID of the plate used in the run. Requires the --protocol option.");
-        runCommand->add_option("--volume", settings.volume, "Volume for the run. Requires the --protocol option.");
-        runCommand->add_option("--temp", settings.lidTemp, "Lid temperature for the run. Requires the --protocol option.");
-        runCommand->add_flag("--public", settings.publicProtocols, "Protocol is in the Public location instead of user location. Requires the --protocol option.");
-        runCommand->add_flag("--templates", settings.templateProtocol, "Use a template protocol. Requires the --protocol option.");
-        runCommand->add_flag("--monitor", settings.monitor, "Monitor run status. Requires the --protocol option.");
-        runCommand->add_option("--interval", settings.interval, "Set interval for run status refresh. Requires --monitor flag.");
+    /// Set by SIGINT or SIGTERM to stop the proxy, exporter or bench.
+    static inline std::atomic<bool> stopServing{false};
 
-        stopCommand = tempo.add_subcommand("stop", "Stops the protocol run.");
-        skipCommand = tempo.add_subcommand("skip", "Skips the currently active step in the protocol run.");
-        pauseCommand = tempo.add_subcommand("pause", "Pauses the protocol run.");
-        resumeCommand = tempo.add_subcommand("resume", "Resumes the protocol run.");
+    /**
+     * @brief Runs a server, or the bench load, in a thread until it returns or the process is interrupted.
+     * @param listen Serves until stop is called; returns false if it could not start.
+     * @param stop Makes listen return.
+     * @return Value returned by listen.
+     */
+    static bool serveUntilInterrupted(const std::function<bool()>& listen, const std::function<void()>& stop) {
+        stopServing = false;
+        auto previousInterrupt = std::signal(SIGINT, [](int) { stopServing = true; });
+        auto previousTerminate = std::signal(SIGTERM, [](int) { stopServing = true; });
+        std::atomic<bool> listening{true};
+        bool success = true;
+        std::thread server([&]() {
+            success = listen();
+            listening = false;
+        });
+        while (listening && !stopServing) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        stop();
+        server.join();
+        std::signal(SIGINT, previousInterrupt);
+        std::signal(SIGTERM, previousTerminate);
+        return success;
+    }
 
-        licenseCommand = tempo.add_subcommand("license", "Prints the copyright licenses.");
-        versionCommand = tempo.add_subcommand("version", "Prints the versions and checks the Automation API compatibility.");
-        configCommand = tempo.add_subcommand("config", "Sets the default values in config.json.");
-        tempoConfig.options(*configCommand);
+    /**
+     * @brief Serves the Automation API of the instrument in the settings to other clients until interrupted.
+     * @return True if the proxy stopped normally, false if the options are invalid or the port could not be opened.
+     */
+    bool runProxy() const {
+        if (!settings.hosts.empty()) {
+            std::cerr << "Error. The proxy command serves one instrument; run one proxy for each host." << std::endl;
+            return false;
+        }
+        std::vector<std::pair<std::string, TempoProxy::Duration>> keepTimes;
+        for (const auto& text : settings.keepTimes) {
+            std::pair<std::string, TempoProxy::Duration> keepTime;
+            if (!TempoProxy::parseKeepTime(text, keepTime)) {
+                std::cerr << "Error. The --ttl option takes values of the form /tempo/status=1.5, not " << text << "." << std::endl;
+                return false;
+            }
+            keepTimes.push_back(keepTime);
+        }
+        TempoProxy proxy(settings.host, static_cast<int32_t>(settings.waitTime), keepTimes, static_cast<size_t>(settings.proxyThreads));
+
+        bool success = serveUntilInterrupted([&]() {
+            return proxy.listen(settings.proxyAddress, static_cast<int>(settings.proxyPort));
+        }, [&]() {
+            proxy.stop();
+        });
+        std::cerr << proxy.stats().dump() << std::endl;
+        return success;
     }
 
     /**
-     * @brief Initialize the settings using the config file and command line args.
+     * @brief Serves the state of the instrument in the settings as OpenMetrics until interrupted.
+     * @return True if the exporter stopped normally, false if the options are invalid or the port could not be opened.
      */
-    void initialize() {
-        tempoConfig.initialize(settings);
+    bool runExporter() {
+        if (!settings.hosts.empty()) {
+            std::cerr << "Error. The exporter command serves one instrument; run one exporter for each host." << std::endl;
+            return false;
+        }
+        if (settings.interval <= 0) {
+            std::cerr << "Error. The --interval option must be at least 1 second." << std::endl;
+            return false;
+        }
+        MetricsExporter exporter(client(), std::chrono::seconds(settings.interval));
+        return serveUntilInterrupted([&]() {
+            return exporter.listen(settings.metricsAddress, static_cast<int>(settings.metricsPort));
+        }, [&]() {
+            exporter.stop();
+        });
+    }
+
+    /**
+     * @brief Sends the request mix of the bench command to the instrument in the settings and
+     * prints the results.
+     * @return True if the load ran, false if the options are invalid.
+     */
+    bool runBench() {
+        if (!settings.hosts.empty()) {
+            std::cerr << "Error. The bench command loads one instrument or proxy; run one bench for each host." << std::endl;
+            return false;
+        }
+        if (settings.benchRate < 0 || settings.benchConcurrency < 1 || settings.benchDuration <= 0 || settings.pageSize < 1) {
+            std::cerr << "Error. The --rate option must be at least 0, and the --concurrency, --duration and --pageSize options more than 0." << std::endl;
+            return false;
+        }
+        int64_t pageSize = settings.pageSize;
+        const std::map<std::string, LoadGenerator::Request> requestTypes = {
+                {"tempo", [](TempoClient& tempoClient) { tempoClient.tempo(); }},
+                {"status", [](TempoClient& tempoClient) { tempoClient.status(); }},
+                {"lid", [](TempoClient& tempoClient) { tempoClient.lid(); }},
+                {"run", [](TempoClient& tempoClient) { tempoClient.run(); }},
+                {"errors", [](TempoClient& tempoClient) { tempoClient.faults(false); }},
+                {"protocols", [](TempoClient& tempoClient) { tempoClient.protocols(false); }},
+                {"count", [](TempoClient& tempoClient) { tempoClient.reportsCount(); }},
+                {"reports", [pageSize](TempoClient& tempoClient) { tempoClient.reports(pageSize); }}};
+
+        LoadGenerator generator(settings.host, settings.password, static_cast<int32_t>(settings.waitTime),
+                                static_cast<size_t>(settings.benchConcurrency), settings.benchRate, settings.benchDuration);
+        for (const auto& entry : settings.benchMix) {
+            auto separator = entry.find('=');
+            std::string name = entry.substr(0, separator);
+            int64_t weight = 1;
+            if (separator != std::string::npos) {
+                char* end = nullptr;
+                weight = std::strtoll(entry.c_str() + separator + 1, &end, 10);
+                if (*end != '\0' || weight < 1) {
+                    weight = 0;
+                }
+            }
+            auto requestType = requestTypes.find(name);
+            if (requestType == requestTypes.end() || weight < 1) {
+                std::cerr << "Error. The --mix option takes values of the form status=4 with one of tempo, status, lid, run, errors, protocols, count or reports, not " << entry << "." << std::endl;
+                return false;
+            }
+            generator.add(name, weight, requestType->second);
+        }
+
+        bool success = serveUntilInterrupted([&]() {
+            return generator.run();
+        }, [&]() {
+            generator.stop();
+        });
+        print(generator.results());
+        return success;
+    }
+
+    /**
+     * @brief Runs the commands of the batch file in order, in this process, and prints the time
+     * each one took to stderr.
+     *
+     * The commands share the config and the options given before batch on the command line, and
+     * reuse one TempoClient per instrument, so after the first request every command is sent on
+     * a connection that is already open. The batch stops at the first command that fails
+     * unless --continue is given.
+     * @return True if every command succeeded.
+     */
+    bool runBatch() {
+        std::vector<BatchScript::Step> steps;
+        bool read;
+        if (settings.batchFile == "-") {
+            read = BatchScript::read(std::cin, steps);
+        } else {
+            std::ifstream file(settings.batchFile);
+            if (!file) {
+                std::cerr << "Error. Could not open the batch file " << settings.batchFile << "." << std::endl;
+                return false;
+            }
+            read = BatchScript::read(file, steps);
+        }
+        if (!read) {
+            return false;
+        }
+
+        // options of the batch command line apply to every command in it
+        const Settings base = settings;
+        bool wasResident = resident;
+        resident = true;
+        TempoClient::exitOnError(false);
+        bool success = true;
+        int failures = 0;
+        auto batchStart = std::chrono::steady_clock::now();
+        for (const auto& step : steps) {
+            auto start = std::chrono::steady_clock::now();
+            int exitCode = execute(step.args, base, [this]() {
+                Command command = parsedCommand();
+                if (command == Command::daemon || command == Command::proxy || command == Command::exporter || command == Command::bench
+                    || command == Command::batch) {
+                    std::cerr << "Error. The daemon, proxy, exporter, bench and batch commands are not run in a batch." << std::endl;
+                    return false;
+                }
+                return true;
+            });
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout.flush();
+            char line[64];
+            std::snprintf(line, sizeof(line), "%10.3f ms", milliseconds);
+            std::cerr << "[" << step.line << "] " << step.text << "  " << line << (exitCode == 0 ? "" : "  failed with exit code " + std::to_string(exitCode)) << std::endl;
+            if (exitCode != 0) {
+                ++failures;
+                success = false;
+                if (!base.batchContinue) {
+                    break;
+                }
+            }
+        }
+        double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count();
+        char line[64];
+        std::snprintf(line, sizeof(line), "%.3f ms", total);
+        std::cerr << steps.size() << " commands, " << failures << " failed, " << line << std::endl;
+
+        settings = base;
+        resident = wasResident;
+        TempoClient::exitOnError(!resident);
+        if (!resident) {
+            clients.clear();
+        }
+        return success;
+    }
+
+    /**
+     * @brief Starts the runs of the queue file on the instruments of --hosts, or the one
+     * instrument of --host, as they become idle, and prints what happened to each run and the
+     * utilisation of each instrument.
+     *
+     * Each line of the queue holds the options of the run command for one run. They are parsed
+     * by the run command, so each run is started with the same body as run --protocol; a run
+     * without --plate or --name gets plate and run names numbered by its line. Ctrl+C stops the
+     * dispatch; runs in progress go on.
+     * @return True if every run of the queue completed.
+     */
+    bool runDispatch() {
+        if (settings.dispatchInterval <= 0 || settings.dispatchAttempts < 1) {
+            std::cerr << "Error. The --interval option must be more than 0 and the --attempts option at least 1." << std::endl;
+            return false;
+        }
+        std::vector<BatchScript::Step> lines;
+        bool read;
+        if (settings.queueFile == "-") {
+            read = BatchScript::read(std::cin, lines);
+        } else {
+            std::ifstream file(settings.queueFile);
+            if (!file) {
+                std::cerr << "Error. Could not open the queue file " << settings.queueFile << "." << std::endl;
+                return false;
+            }
+            read = BatchScript::read(file, lines);
+        }
+        if (!read) {
+            return false;
+        }
+        if (lines.empty()) {
+            std::cerr << "Error. The queue file " << settings.queueFile << " has no runs." << std::endl;
+            return false;
+        }
+
+        const Settings base = settings;
+        Dispatcher dispatcher(base.hosts.empty() ? std::vector<std::string>{base.host} : base.hosts, base.password,
+                              static_cast<int32_t>(base.waitTime), base.dispatchInterval, base.readyLids,
+                              static_cast<int32_t>(base.dispatchAttempts));
+        for (const auto& line : lines) {
+            settings = base;
+            tempo.clear();
+            std::vector<std::string> args(line.args.rbegin(), line.args.rend());
+            args.emplace_back("run");
+            try {
+                tempo.parse(args);
+            } catch (const CLI::ParseError& error) {
+                std::cerr << "Error. Line " << line.line << " of the queue: " << error.what() << std::endl;
+                settings = base;
+                return false;
+            }
+            if (tempo.get_subcommands().size() != 1 || settings.protocol.empty() || settings.monitor || !checkRunOptions()) {
+                std::cerr << "Error. Line " << line.line << " of the queue must give the --protocol option of a run, and no other command." << std::endl;
+                settings = base;
+                return false;
+            }
+            if (settings.plateID.empty()) {
+                settings.plateID = "plate" + std::to_string(line.line);
+            }
+            if (settings.runName.empty()) {
+                settings.runName = "run" + settings.protocol + std::to_string(line.line);
+            }
+            dispatcher.add(runBody());
+        }
+        settings = base;
+
+        bool success = serveUntilInterrupted([&]() {
+            return dispatcher.run();
+        }, [&]() {
+            dispatcher.stop();
+        });
+        print(dispatcher.results());
+        return success && dispatcher.succeeded();
+    }
+
+    /**
+     * @brief Polls the status or lid until the condition of the wait command holds, then prints
+     * the last response.
+     *
+     * Failed requests are polled again until the timeout, since an instrument can drop a
+     * request while it moves the lid or starts a run.
+     * @param tempoClient Object that manages HTTP calls to PTC Tempo.
+     * @return True if the condition held before the timeout.
+     */
+    bool waitFor(TempoClient& tempoClient) {
+        WaitCondition condition;
+        if (!WaitCondition::parse(settings.waitCondition, condition)) {
+            std::cerr << "Error. The wait condition is of the form status=idle, lid!=opening or lid=closed|closedWithPlate, not " << settings.waitCondition << "." << std::endl;
+            return false;
+        }
+        if (settings.waitInterval <= 0 || settings.waitTimeout < 0) {
+            std::cerr << "Error. The --interval option must be more than 0 and the --timeout option at least 0." << std::endl;
+            return false;
+        }
+        bool lid = condition.field == "lid";
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(settings.waitTimeout));
+        auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(settings.waitInterval));
+        std::string value;
+        while (true) {
+            if (lid) {
+                tempoClient.lid();
+            } else {
+                tempoClient.status();
+            }
+            if (tempoClient.statusOK()) {
+                value = lid ? tempoClient.getLidStatus() : tempoClient.getRunStatus();
+                if (condition.holds(value)) {
+                    return tempoClient.print(settings.displayType);
+                }
+            }
+            if (std::chrono::steady_clock::now() + interval > deadline) {
+                break;
+            }
+            std::this_thread::sleep_for(interval);
+        }
+        std::cerr << "Error. " << settings.waitCondition << " did not hold within " << settings.waitTimeout << " seconds; "
+                  << condition.field << " was " << (value.empty() ? "not read" : value) << "." << std::endl;
+        return false;
+    }
+
+    /// Returns true if the request phases are timed for --stats or --statsFile.
+    [[nodiscard]] bool statsRequested() const {
+        return settings.stats || !settings.statsFile.empty();
+    }
+
+    /**
+     * @brief Gets the client for the instrument in the settings.
+     *
+     * A daemon keeps one client per host, password and wait time, so later commands reuse the
+     * connection; its exit code is cleared for the new command. Otherwise, a new client is made
+     * for this command. With --stats, the client times its requests into requestStats.
+     */
+    TempoClient& client() {
+        auto waitTime = static_cast<int32_t>(settings.waitTime);
+        if (!resident) {
+            commandClient = std::make_unique<TempoClient>(settings.host, settings.password, waitTime);
+            lastClient = commandClient.get();
+        } else {
+            std::string key = settings.host + '\n' + settings.password + '\n' + std::to_string(waitTime);
+            auto& pooled = clients[key];
+            if (!pooled) {
+                pooled = std::make_unique<TempoClient>(settings.host, settings.password, waitTime);
+            }
+            lastClient = pooled.get();
+            // a command that fails before its first request must not return the code of the last one
+            lastClient->clearExitCode();
+        }
+        lastClient->collectStats(statsRequested() ? &requestStats : nullptr);
+        return *lastClient;
     }
 
     /// Returns reference to root command line application handler.
@@ -225,14 +1338,13 @@ public:
      * @param success Output parameter indicates monitoring completely successfully.
      * @return True if command was processed.
      */
-    bool routeMonitorCommands(const CLI::App& command, TempoClient& tempoClient, bool& success) {
-        auto monitorInterval = static_cast<int32_t>(settings.interval);
+    bool routeMonitorCommands(Command command, TempoClient& tempoClient, bool& success) {
         success = true;
         bool processed = false;
-        if (command.get_name() == lidCommand->get_name()) {
+        if (command == Command::lid) {
             processed = true;
             if (settings.monitor) {
-                auto monitor = Monitor(tempoClient, monitorInterval, settings.displayType, [&tempoClient]() {
+                auto monitor = Monitor(tempoClient, pollingPolicy(), settings.displayType, statsRequested(), settings.stats, [&tempoClient]() {
                     tempoClient.lid();
                     return tempoClient.getLidStatus() == "opening" || tempoClient.getLidStatus() == "closing";
                 });
@@ -241,10 +1353,10 @@ public:
             }
             tempoClient.lid();
 
-        } else if (command.get_name() == statusCommand->get_name()) {
+        } else if (command == Command::status) {
             processed = true;
             if (settings.monitor) {
-                auto monitor = Monitor(tempoClient, monitorInterval, settings.displayType, [&tempoClient]() {
+                auto monitor = Monitor(tempoClient, pollingPolicy(), settings.displayType, statsRequested(), settings.stats, [&tempoClient]() {
                     tempoClient.status();
                     return tempoClient.getRunStatus() == "running" || tempoClient.getRunStatus() == "paused";
                 });
@@ -253,17 +1365,42 @@ public:
             }
             tempoClient.status();
 
-        } else if (command.get_name() == runCommand->get_name()) {
+        } else if (command == Command::run) {
             processed = true;
             if (!handleRun(tempoClient)) {
                 success = false;
             } else
             if (settings.monitor && (tempoClient.getRunStatus() == "running" || tempoClient.getRunStatus() == "paused")) {
-                auto monitor = Monitor(tempoClient, monitorInterval, settings.displayType, [&tempoClient]() {
+                std::optional<TelemetryWriter> recorder;
+                if (!settings.recordFile.empty()) {
+                    recorder.emplace(settings.recordFile);
+                    if (!recorder->isOpen()) {
+                        std::cerr << "Error. Could not open the telemetry file " << settings.recordFile << "." << std::endl;
+                        success = false;
+                        return processed;
+                    }
+                }
+                bool recordFailed = false;
+                auto monitor = Monitor(tempoClient, pollingPolicy(), settings.displayType, statsRequested(), settings.stats, [&tempoClient, &recorder, &recordFailed]() {
                     tempoClient.run();
+                    if (recorder && tempoClient.statusOK()) {
+                        auto now = std::chrono::system_clock::now().time_since_epoch();
+                        if (!recorder->add(TelemetrySample::fromRun(tempoClient.parsed().body,
+                                           std::chrono::duration_cast<std::chrono::milliseconds>(now).count()))) {
+                            // monitoring goes on; the error is reported once the screen is back
+                            recordFailed = true;
+                            recorder.reset();
+                        }
+                    }
                     return tempoClient.getRunStatus() == "running" || tempoClient.getRunStatus() == "paused";
                 });
-                success = monitor.success();
+                if (recorder && !recorder->flush()) {
+                    recordFailed = true;
+                }
+                if (recordFailed) {
+                    std::cerr << "Error. Could not write to the telemetry file " << settings.recordFile << ". Recording stopped." << std::endl;
+                }
+                success = monitor.success() && !recordFailed;
                 return processed;
             }
 
@@ -274,6 +1411,98 @@ public:
         return processed;
     }
 
+    /**
+     * @brief Makes the HTTP request for a command without printing the response.
+     *
+     * This covers all commands that make exactly one request to PTC Tempo. The lid, status and
+     * run monitoring, and the version check, are handled by their own functions.
+     * @param command Which command to process.
+     * @param tempoClient Reference to client connection object.
+     * @return True if a request was made, false if the options are invalid or the command is not handled here.
+     */
+    bool request(Command command, TempoClient& tempoClient) {
+        if (command == Command::none || commandTable()[index(command)].request == nullptr) {
+            return false;
+        }
+        return commandTable()[index(command)].request(*this, tempoClient);
+    }
+
+    /**
+     * @brief Sends one command to every instrument in the --hosts list and prints the merged responses.
+     *
+     * The command line options are checked once before any request is made, so an invalid option is
+     * reported once rather than once per instrument. Monitoring and the version check are not
+     * supported for a fleet.
+     * @param command Which command to process, or Command::none for the default tempo request.
+     * @return True if every instrument returned status 200.
+     */
+    bool routeFleet(Command command) {
+        if (settings.monitor || settings.streamReports || !settings.exportDir.empty() || settings.syncReports || settings.cachedReports
+            || !settings.tableFile.empty()) {
+            std::cerr << "Error. The --monitor, --stream, --export, --sync, --cached and --table options are not used with the --hosts option." << std::endl;
+            return false;
+        }
+        if (command == Command::version || command == Command::wait) {
+            std::cerr << "Error. The version and wait commands are not used with the --hosts option." << std::endl;
+            return false;
+        } else if (command == Command::reports && !checkReportsOptions()) {
+            return false;
+        } else if (command == Command::run) {
+            if (!checkRunOptions()) {
+                return false;
+            }
+            applyRunDefaults();
+        }
+
+        Fleet fleet(settings.hosts, settings.password, static_cast<int32_t>(settings.waitTime), static_cast<size_t>(settings.jobs));
+        json results;
+        bool success = fleet.run([this, command](TempoClient& tempoClient) {
+            if (command == Command::none) {
+                tempoClient.tempo();
+            } else {
+                request(command, tempoClient);
+            }
+        }, results);
+
+        print(results);
+        return success;
+    }
+
+    /**
+     * @brief Routes the command and prints or writes the request timings if they were asked for.
+     *
+     * With --stats or --statsFile, an error response does not end the process, so the timings
+     * of the requests before it are still written; the exit code is the same.
+     * @return 0 for success, 1 for failure, anything greater than 1 is an HTTP status code or
+     *  HTTP client error.
+     */
+    int run() {
+        bool timed = statsRequested();
+        requestStats = RequestStats();
+        lastClient = nullptr;
+        if (timed) {
+            TempoClient::exitOnError(false);
+        }
+        bool success = route();
+        if (timed) {
+            TempoClient::exitOnError(!resident);
+            if (settings.stats) {
+                requestStats.print(std::cerr);
+            }
+            if (!settings.statsFile.empty() && !requestStats.write(settings.statsFile)) {
+                success = false;
+            }
+        }
+        if (success) {
+            return 0;
+        }
+        // a pooled client keeps the code of its last printed error, so it is only read on failure
+        if (lastClient != nullptr && lastClient->exitCode() != 0) {
+            return lastClient->exitCode();
+        }
+        return 1;
+    }
+
     /**
      * @brief This function routes a subcommand and options from the command line to the correct
      * function in the tempoClient object.
@@ -281,74 +1510,63 @@ public:
      * It obtains the subcommands from the tempo object. It performs some validity checks of the
      * command line args. If the subcommand does not require any HTTP connection, such as license
      * and config, it runs those and returns. If the subcommand requires HTTP connection, it makes
-     * a tempoClient object and calls the proper method therein.
+     * a tempoClient object and calls the proper method therein. If a list of hosts was given, the
+     * command is sent to all of them by routeFleet instead.
      *
      * @return True for success, false for failure. If failure occurs, this emits a message
      *  to stderr.
      */
     bool route() {
 
-        auto commands = tempo.get_subcommands();
-
-        // Process config and license command without creating a TempoClient
-        if (commands.size() > 1) {
+        // Process inventory, config, license, telemetry, proxy, exporter, bench, batch, dispatch and daemon commands before the TempoClient of other commands
+        if (tempo.get_subcommands().size() > 1) {
             std::cerr << "No more than one command" << std::endl;
             return false;
-        } else if (!commands.empty()) {
-            const CLI::App* command = *commands.begin();
-            if (command->get_name() == licenseCommand->get_name()) {
-                Config::license();
-                return true;
+        }
+        const Command command = parsedCommand();
+        if (command != Command::inventory && (!settings.instrumentNames.empty() || !settings.groupNames.empty() || !settings.tagNames.empty())
+            && !selectInstruments()) {
+            return false;
+        }
+        if (command != Command::none && commandTable()[index(command)].local != nullptr) {
+            return commandTable()[index(command)].local(*this);
+        }
 
-            } else if (command->get_name() == configCommand->get_name()) {
-                tempoConfig.save();
-                tempoConfig.print(settings.displayType);
-                return true;
-            }
+        if (!settings.hosts.empty()) {
+            return routeFleet(command);
         }
 
         // process requests to the instrument
-        TempoClient tempoClient(settings.host, settings.password, static_cast<int32_t>(settings.waitTime));
+        TempoClient& tempoClient = client();
 
-        if (commands.empty()) {
+        if (command == Command::none) {
             tempoClient.tempo();
             return tempoClient.print(settings.displayType);
         }
 
-        const CLI::App* command = *commands.begin();
-
-        if (bool success; routeMonitorCommands(*command, tempoClient, success)) {
+        if (settings.monitor && !checkPollingOptions()) {
+            return false;
+        }
+        if (command == Command::wait) {
+            return waitFor(tempoClient);
+        } else if (bool success; routeMonitorCommands(command, tempoClient, success)) {
             return success;
-        } else if (command->get_name() == reportsCommand->get_name()) {
-            if (!handleReports(tempoClient)) {
-                return false;
-            }
-
-        } else if (command->get_name() == openCommand->get_name()) {
-            tempoClient.openLid();
-
-        } else if (command->get_name() == closeCommand->get_name()) {
-            tempoClient.closeLid();
-
-       } else if (command->get_name() == protocolsCommand->get_name()) {
-            tempoClient.protocols(settings.publicProtocols);
-
-        } else if (command->get_name() == faultCommand->get_name()) {
-            tempoClient.faults(settings.clearFaults);
-            
-        } else if (command->get_name() == stopCommand->get_name()) {
-            tempoClient.stop();
-
-        } else if (command->get_name() == skipCommand->get_name()) {
-            tempoClient.skip();
-
-        } else if (command->get_name() == pauseCommand->get_name()) {
-            tempoClient.pause();
-
-        } else if (command->get_name() == resumeCommand->get_name()) {
-            tempoClient.resume();
-        } else if (command->get_name() == versionCommand->get_name()) {
+        } else if (command == Command::version) {
             return tempoClient.version(settings.displayType);
+        } else if (command == Command::reports && !settings.tableFile.empty()) {
+            return tableReports(tempoClient);
+        } else if (command == Command::reports && settings.streamReports) {
+            return streamReports(tempoClient);
+        } else if (command == Command::reports && !settings.exportDir.empty()) {
+            return exportReports();
+        } else if (command == Command::reports && settings.syncReports) {
+            return syncReports(tempoClient);
+        } else if (command == Command::reports && settings.cachedReports) {
+            return cachedReports();
+        } else if (command == Command::reports && !settings.runId.empty()) {
+            return cachedReport(tempoClient);
+        } else if (!request(command, tempoClient)) {
+            return false;
         }
 
         return tempoClient.print(settings.displayType);
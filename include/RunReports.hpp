@@ -0,0 +1,83 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "nlohmann/json.hpp"
+#include <string>
+
+using nlohmann::json;
+
+/**
+ * @class RunReports
+ * @brief Finds the values the client needs inside run report responses.
+ *
+ * The list, count and report responses are read the same way wherever reports are exported,
+ * cached or converted, so these lookups live in one place.
+ */
+class RunReports {
+
+public:
+
+    /**
+     * @brief Finds the list of reports in a response from /tempo/run-reports.
+     * @param response Parsed response body.
+     * @return The first array in the response, or nullptr if there is none.
+     */
+    static const json* list(const json& response) {
+        if (response.is_array()) {
+            return &response;
+        }
+        if (response.is_object()) {
+            for (const auto& [key, value] : response.items()) {
+                if (value.is_array()) {
+                    return &value;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Gets the ID of a report, as used with /tempo/run-reports/{id}.
+     * @param report A report or an entry in the list of reports.
+     * @return The ID, or an empty string if the report has none.
+     */
+    static std::string id(const json& report) {
+        for (const char* key : {"id", "runId", "reportId", "guid"}) {
+            if (auto value = report.find(key); value != report.end() && value->is_string()) {
+                return *value;
+            }
+        }
+        return {};
+    }
+
+    /**
+     * @brief Gets the number of reports from a response from /tempo/run-reports/count.
+     * @param response Parsed response body.
+     * @return The count, or -1 if the response has no count.
+     */
+    static int64_t count(const json& response) {
+        if (response.is_number_integer()) {
+            return response;
+        }
+        if (response.is_object()) {
+            if (auto value = response.find("count"); value != response.end() && value->is_number_integer()) {
+                return *value;
+            }
+            for (const auto& [key, value] : response.items()) {
+                if (value.is_number_integer() && key != "httpCode") {
+                    return value;
+                }
+            }
+        }
+        return -1;
+    }
+};
@@ -8,7 +8,10 @@
 // SPDX-License-Identifier: MIT
 //
 
+#pragma once
+
 #include <string>
+#include <vector>
 
 /**
  * @struct Settings
@@ -23,6 +26,17 @@ struct Settings {
     std::string password;            ///< Password for Automation user on PTC Tempo.
     int64_t waitTime = 10;           ///< Number of seconds to wait for response.
 
+    // fleet
+    std::vector<std::string> hosts;  ///< URLs for several PTC Tempo instruments that all receive the command.
+    int64_t jobs = 16;               ///< Maximum number of concurrent requests for a fleet or an export.
+
+    // inventory
+    std::string inventoryFile = "inventory.json"; ///< JSON inventory of named instruments; its index is kept beside it.
+    std::vector<std::string> instrumentNames; ///< Names of instruments in the inventory that receive the command.
+    std::vector<std::string> groupNames;  ///< Groups of the inventory whose instruments receive the command.
+    std::vector<std::string> tagNames;    ///< Tags of the inventory whose instruments receive the command.
+    bool compileInventory = false;   ///< True to compile the index of the inventory even if it is up to date.
+
     // faults
     bool clearFaults = false;        ///< True to clear all cycler and lid faults.
 
@@ -31,6 +45,16 @@ struct Settings {
     int64_t limit = 0;               ///< Number of run reports to retrieve.
     int64_t offset = 0;              ///< Offset into list of run reports. Can range from 0 to count.
     bool countReports = false;       ///< True to get count of run reports.
+    bool streamReports = false;      ///< True to write run reports as they arrive instead of buffering the list.
+    std::string exportDir;           ///< Directory that receives every run report.
+    int64_t pageSize = 100;          ///< Number of run reports in each page of the list when exporting.
+    int64_t retries = 3;             ///< Number of times a failed request is retried when exporting.
+    bool syncReports = false;        ///< True to copy run reports added since the last sync into the cache.
+    bool cachedReports = false;      ///< True to list or count run reports from the cache instead of the instrument.
+    std::string cacheDir = "reports-cache"; ///< Directory that holds the run report cache of each instrument.
+    std::string tableFile;           ///< File that receives the run reports as a table, or - for stdout.
+    std::vector<std::string> tableFields; ///< Dotted paths of the report fields written as table columns.
+    std::string tableFormat = "csv"; ///< Table format: csv or columnar.
 
     // run
     std::string protocol;            ///< Name of protocol.
@@ -40,9 +64,56 @@ struct Settings {
     std::string plateID;             ///< User provided plate-ID for run.
     bool publicProtocols = false;    ///< True to load protocol from public folder.
     bool templateProtocol = false;   ///< True to use template instead of protocol.
+    std::string recordFile;          ///< Telemetry file that receives each run status sample when monitoring.
+
+    // telemetry
+    std::string telemetryFile;       ///< Telemetry file to read.
+    double telemetryFrom = 0;        ///< Seconds after the first sample where reading starts.
+    double telemetryTo = -1;         ///< Seconds after the first sample where reading ends, or -1 for the end.
+    double telemetryEvery = 0;       ///< Seconds in each downsampling bucket, or 0 for every sample.
+    bool telemetryInfo = false;      ///< True to print a summary of the telemetry file instead of samples.
 
     // monitoring and displaying
     bool monitor = false;            ///< True to monitor responses from PTC Tempo.
     int64_t interval = 1;            ///< Number of seconds for polling interval when monitoring.
-    std::string displayType;         ///< Output format: either json or text.
+    bool adaptive = false;           ///< True to adapt the polling interval to the progress of the run or lid.
+    double minInterval = 0.5;        ///< Shortest adaptive polling interval in seconds.
+    double maxInterval = 60;         ///< Longest adaptive polling interval in seconds.
+    double jitter = 0.1;             ///< Fraction of the adaptive polling interval that varies at random.
+    std::string displayType;         ///< Output format: either json or text, or ndjson for streamed reports.
+    bool stats = false;              ///< True to print the time of each request phase at exit.
+    std::string statsFile;           ///< File that receives the time of each request phase as JSON at exit.
+
+    // proxy
+    std::string proxyAddress = "127.0.0.1"; ///< Address the proxy listens on.
+    int64_t proxyPort = 8081;        ///< Port the proxy listens on.
+    int64_t proxyThreads = 64;       ///< Number of client requests the proxy serves at the same time.
+    std::vector<std::string> keepTimes; ///< Keep times of proxy paths, each of the form path=seconds.
+
+    // exporter
+    std::string metricsAddress = "127.0.0.1"; ///< Address the metrics exporter listens on.
+    int64_t metricsPort = 9464;      ///< Port the metrics exporter listens on.
+
+    // load generator
+    double benchRate = 10;           ///< Requests per second sent by the bench command, or 0 for as fast as answered.
+    int64_t benchConcurrency = 8;    ///< Number of connections the bench command sends requests on.
+    double benchDuration = 10;       ///< Seconds the bench command sends requests for.
+    std::vector<std::string> benchMix = {"status=4", "lid=2", "run=2", "tempo=1", "reports=1"}; ///< Request types of the bench command, each of the form name=weight.
+
+    // batch
+    std::string batchFile = "-";     ///< Batch file of commands to run, or - for stdin.
+    bool batchContinue = false;      ///< True to run the rest of the batch after a command fails.
+    std::string waitCondition;       ///< Condition the wait command polls for, e.g. lid=opened.
+    double waitTimeout = 600;        ///< Seconds the wait command polls before it fails.
+    double waitInterval = 0.5;       ///< Seconds between the polls of the wait command.
+
+    // dispatcher
+    std::string queueFile;           ///< File of runs for the dispatch command, one line of run options each, or - for stdin.
+    double dispatchInterval = 2;     ///< Seconds between the polls of each instrument by the dispatch command.
+    std::vector<std::string> readyLids; ///< Lid states in which the dispatch command may start a run; empty for any.
+    int64_t dispatchAttempts = 3;    ///< Times the dispatch command tries to start a run before it fails it.
+
+    // daemon
+    std::string socketPath;          ///< Path of the daemon socket; empty for the default.
+    bool local = false;              ///< True to run the command in this process even if a daemon is running.
 };
@@ -0,0 +1,738 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "MappedFile.hpp"
+#include "nlohmann/json.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @struct TelemetrySample
+ * @brief One poll of /tempo/protocol-run during a run.
+ *
+ * The names of the fields are the names in the response. Numbers missing from the response are
+ * stored as -1, temperatures as NaN, and text as an empty string.
+ */
+struct TelemetrySample {
+    int64_t time = 0;              ///< Milliseconds since the Unix epoch when the sample was taken.
+    std::string status;            ///< Run status.
+    std::string lid;               ///< Lid status.
+    std::string stepState;         ///< State of the step, e.g. lidPreheat.
+    int64_t stepNumber = -1;       ///< Step being run.
+    int64_t numberOfSteps = -1;    ///< Number of steps in the protocol.
+    int64_t currentRepeat = -1;    ///< Repeat of the current step.
+    int64_t totalRepeat = -1;      ///< Number of repeats of the current step.
+    int64_t stepTime = -1;         ///< Seconds into the step.
+    int64_t elapsed = -1;          ///< Seconds since the run started.
+    int64_t hold = -1;             ///< Seconds in the current hold.
+    int64_t remaining = -1;        ///< Seconds left in the current step.
+    int64_t totalRemaining = -1;   ///< Seconds left in the run.
+    double currentBlockTemp = std::numeric_limits<double>::quiet_NaN();   ///< Block temperature in degrees C.
+    double currentLidTemp = std::numeric_limits<double>::quiet_NaN();     ///< Lid temperature in degrees C.
+    double currentSampleTemp = std::numeric_limits<double>::quiet_NaN();  ///< Sample temperature in degrees C.
+
+    /// Text columns, in file order.
+    static constexpr std::array<std::pair<const char*, std::string TelemetrySample::*>, 3> textColumns{{
+        {"status", &TelemetrySample::status},
+        {"lid", &TelemetrySample::lid},
+        {"stepState", &TelemetrySample::stepState}}};
+
+    /// Integer columns, in file order.
+    static constexpr std::array<std::pair<const char*, int64_t TelemetrySample::*>, 9> integerColumns{{
+        {"stepNumber", &TelemetrySample::stepNumber},
+        {"numberOfSteps", &TelemetrySample::numberOfSteps},
+        {"currentRepeat", &TelemetrySample::currentRepeat},
+        {"totalRepeat", &TelemetrySample::totalRepeat},
+        {"stepTime", &TelemetrySample::stepTime},
+        {"elapsed", &TelemetrySample::elapsed},
+        {"hold", &TelemetrySample::hold},
+        {"remaining", &TelemetrySample::remaining},
+        {"totalRemaining", &TelemetrySample::totalRemaining}}};
+
+    /// Temperature columns, in file order.
+    static constexpr std::array<std::pair<const char*, double TelemetrySample::*>, 3> temperatureColumns{{
+        {"currentBlockTemp", &TelemetrySample::currentBlockTemp},
+        {"currentLidTemp", &TelemetrySample::currentLidTemp},
+        {"currentSampleTemp", &TelemetrySample::currentSampleTemp}}};
+
+    /**
+     * @brief Makes a sample from a response of /tempo/protocol-run.
+     * @param response Parsed response body.
+     * @param time_ Milliseconds since the Unix epoch.
+     */
+    static TelemetrySample fromRun(const json& response, int64_t time_) {
+        TelemetrySample sample;
+        sample.time = time_;
+        if (!response.is_object()) {
+            return sample;
+        }
+        auto text = [](const json& object, const char* key, std::string& value) {
+            if (auto found = object.find(key); found != object.end() && found->is_string()) {
+                value = *found;
+            }
+        };
+        auto integer = [](const json& object, const char* key, int64_t& value) {
+            if (auto found = object.find(key); found != object.end() && found->is_number()) {
+                value = found->get<int64_t>();
+            }
+        };
+        auto number = [](const json& object, const char* key, double& value) {
+            if (auto found = object.find(key); found != object.end() && found->is_number()) {
+                value = found->get<double>();
+            }
+        };
+        auto child = [](const json& object, const char* key) -> const json* {
+            auto found = object.find(key);
+            return found != object.end() && found->is_object() ? &*found : nullptr;
+        };
+
+        text(response, "status", sample.status);
+        text(response, "lid", sample.lid);
+        const json* run = child(response, "protocolRun");
+        if (run == nullptr) {
+            return sample;
+        }
+        if (const json* step = child(*run, "step")) {
+            text(*step, "stepState", sample.stepState);
+            integer(*step, "stepNumber", sample.stepNumber);
+            integer(*step, "numberOfSteps", sample.numberOfSteps);
+            integer(*step, "currentRepeat", sample.currentRepeat);
+            integer(*step, "totalRepeat", sample.totalRepeat);
+            integer(*step, "stepTime", sample.stepTime);
+        }
+        if (const json* time = child(*run, "time")) {
+            integer(*time, "elapsed", sample.elapsed);
+            integer(*time, "hold", sample.hold);
+            integer(*time, "remaining", sample.remaining);
+            integer(*time, "totalRemaining", sample.totalRemaining);
+        }
+        if (const json* temperature = child(*run, "temperature")) {
+            number(*temperature, "currentBlockTemp", sample.currentBlockTemp);
+            number(*temperature, "currentLidTemp", sample.currentLidTemp);
+            number(*temperature, "currentSampleTemp", sample.currentSampleTemp);
+        }
+        return sample;
+    }
+
+    /// Converts the sample to a flat JSON object, leaving out missing values.
+    [[nodiscard]] json toJson() const {
+        json object;
+        object["time"] = time;
+        for (const auto& [name, member] : textColumns) {
+            if (!(this->*member).empty()) {
+                object[name] = this->*member;
+            }
+        }
+        for (const auto& [name, member] : integerColumns) {
+            if (this->*member >= 0) {
+                object[name] = this->*member;
+            }
+        }
+        for (const auto& [name, member] : temperatureColumns) {
+            if (!std::isnan(this->*member)) {
+                object[name] = this->*member;
+            }
+        }
+        return object;
+    }
+};
+
+/**
+ * @class TelemetryFormat
+ * @brief Encodes and decodes the blocks of a telemetry file.
+ *
+ * A file starts with "TTEL" and a format version, followed by blocks. Each block holds the
+ * samples of one flush, stored by column.
+ * - Block header: "TBLK", sample count, payload length, payload checksum, first and last time.
+ * - Text columns: a dictionary of the distinct strings in the block, then one index per sample.
+ * - Times: the change from the previous change, in milliseconds. Samples at a steady interval
+ *   take one byte each.
+ * - Integer columns: the change from the previous sample.
+ * - Temperatures: the bits XORed with the previous sample; the zero bytes at either end of the
+ *   result are left out, so an unchanged temperature takes one byte.
+ *
+ * Variable-length integers are LEB128, with signed values zigzag encoded. Numbers in headers are
+ * little-endian. Blocks are only ever appended, and a block that was cut short by a crash is
+ * recognized by its length and checksum and left out.
+ */
+class TelemetryFormat {
+
+public:
+
+    /// Marks the start of a telemetry file.
+    static constexpr char fileMagic[4] = {'T', 'T', 'E', 'L'};
+    /// Format version written after the file magic.
+    static const uint32_t version = 1;
+    /// Length of the file header.
+    static const size_t fileHeaderSize = 8;
+    /// Marks the start of a block.
+    static constexpr char blockMagic[4] = {'T', 'B', 'L', 'K'};
+    /// Length of a block header.
+    static const size_t blockHeaderSize = 32;
+
+    /**
+     * @struct BlockHeader
+     * @brief Describes one block of samples.
+     */
+    struct BlockHeader {
+        uint32_t samples = 0;   ///< Number of samples.
+        uint32_t length = 0;    ///< Length of the payload after the header.
+        uint32_t checksum = 0;  ///< FNV-1a hash of the payload.
+        int64_t firstTime = 0;  ///< Time of the first sample.
+        int64_t lastTime = 0;   ///< Time of the last sample.
+    };
+
+    /// Returns the 32-bit FNV-1a hash of bytes.
+    static uint32_t checksum(const char* bytes, size_t length) {
+        uint32_t value = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            value = (value ^ static_cast<unsigned char>(bytes[i])) * 16777619u;
+        }
+        return value;
+    }
+
+    /// Appends a little-endian value.
+    template<typename Integer>
+    static void putFixed(std::string& out, Integer value) {
+        for (size_t i = 0; i < sizeof(Integer); ++i) {
+            out.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xff));
+        }
+    }
+
+    /// Reads a little-endian value.
+    template<typename Integer>
+    static Integer getFixed(const char* bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < sizeof(Integer); ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+        }
+        return static_cast<Integer>(value);
+    }
+
+    /// Appends an unsigned LEB128 value.
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    /// Reads an unsigned LEB128 value; returns false at the end of the bytes.
+    static bool getVarint(const char*& bytes, const char* end, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; bytes < end && shift < 64; shift += 7) {
+            auto byte = static_cast<unsigned char>(*bytes++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Maps a signed value to an unsigned one with small magnitudes first.
+    static uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    /// Reverses zigzag.
+    static int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    /// Appends a double XORed with the previous one.
+    static void putXor(std::string& out, double value, uint64_t& previous) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint64_t delta = bits ^ previous;
+        previous = bits;
+        if (delta == 0) {
+            out.push_back(0);
+            return;
+        }
+        int leading = 0;
+        while (leading < 7 && ((delta >> (8 * (7 - leading))) & 0xff) == 0) {
+            ++leading;
+        }
+        int trailing = 0;
+        while (trailing < 7 - leading && ((delta >> (8 * trailing)) & 0xff) == 0) {
+            ++trailing;
+        }
+        out.push_back(static_cast<char>(0x80 | (leading << 3) | trailing));
+        for (int i = trailing; i < 8 - leading; ++i) {
+            out.push_back(static_cast<char>((delta >> (8 * i)) & 0xff));
+        }
+    }
+
+    /// Reads a double written by putXor.
+    static bool getXor(const char*& bytes, const char* end, double& value, uint64_t& previous) {
+        if (bytes >= end) {
+            return false;
+        }
+        auto control = static_cast<unsigned char>(*bytes++);
+        uint64_t delta = 0;
+        if (control != 0) {
+            int leading = (control >> 3) & 7;
+            int trailing = control & 7;
+            int count = 8 - leading - trailing;
+            if (count <= 0 || end - bytes < count) {
+                return false;
+            }
+            for (int i = 0; i < count; ++i) {
+                delta |= static_cast<uint64_t>(static_cast<unsigned char>(*bytes++)) << (8 * (trailing + i));
+            }
+        }
+        previous ^= delta;
+        std::memcpy(&value, &previous, sizeof(value));
+        return true;
+    }
+
+    /**
+     * @brief Encodes samples as one block, header included.
+     * @param samples Samples in time order; at least one.
+     */
+    static std::string encode(const std::vector<TelemetrySample>& samples) {
+        std::string payload;
+        for (const auto& [name, member] : TelemetrySample::textColumns) {
+            std::vector<const std::string*> dictionary;
+            std::string indexes;
+            for (const auto& sample : samples) {
+                const std::string& text = sample.*member;
+                size_t index = 0;
+                while (index < dictionary.size() && *dictionary[index] != text) {
+                    ++index;
+                }
+                if (index == dictionary.size()) {
+                    dictionary.push_back(&text);
+                }
+                putVarint(indexes, index);
+            }
+            putVarint(payload, dictionary.size());
+            for (const auto* text : dictionary) {
+                putVarint(payload, text->size());
+                payload += *text;
+            }
+            payload += indexes;
+        }
+        int64_t previousTime = samples.front().time;
+        int64_t previousDelta = 0;
+        for (size_t i = 1; i < samples.size(); ++i) {
+            int64_t delta = samples[i].time - previousTime;
+            putVarint(payload, zigzag(delta - previousDelta));
+            previousTime = samples[i].time;
+            previousDelta = delta;
+        }
+        for (const auto& [name, member] : TelemetrySample::integerColumns) {
+            int64_t previous = 0;
+            for (const auto& sample : samples) {
+                putVarint(payload, zigzag(sample.*member - previous));
+                previous = sample.*member;
+            }
+        }
+        for (const auto& [name, member] : TelemetrySample::temperatureColumns) {
+            uint64_t previous = 0;
+            for (const auto& sample : samples) {
+                putXor(payload, sample.*member, previous);
+            }
+        }
+
+        std::string block(blockMagic, sizeof(blockMagic));
+        putFixed(block, static_cast<uint32_t>(samples.size()));
+        putFixed(block, static_cast<uint32_t>(payload.size()));
+        putFixed(block, checksum(payload.data(), payload.size()));
+        putFixed(block, samples.front().time);
+        putFixed(block, samples.back().time);
+        return block + payload;
+    }
+
+    /**
+     * @brief Reads a block header.
+     * @param bytes Start of the block.
+     * @param available Number of bytes from the start of the block to the end of the file.
+     * @param header Output parameter for the header.
+     * @return True if the header is valid and the whole payload is present.
+     */
+    static bool header(const char* bytes, size_t available, BlockHeader& header) {
+        if (available < blockHeaderSize || std::memcmp(bytes, blockMagic, sizeof(blockMagic)) != 0) {
+            return false;
+        }
+        header.samples = getFixed<uint32_t>(bytes + 4);
+        header.length = getFixed<uint32_t>(bytes + 8);
+        header.checksum = getFixed<uint32_t>(bytes + 12);
+        header.firstTime = getFixed<int64_t>(bytes + 16);
+        header.lastTime = getFixed<int64_t>(bytes + 24);
+        return header.samples > 0 && available - blockHeaderSize >= header.length;
+    }
+
+    /**
+     * @brief Decodes the payload of a block.
+     * @param header Header of the block.
+     * @param payload Start of the payload.
+     * @param samples Output parameter for the samples.
+     * @return True if the checksum matches and the payload is complete.
+     */
+    static bool decode(const BlockHeader& header, const char* payload, std::vector<TelemetrySample>& samples) {
+        if (checksum(payload, header.length) != header.checksum) {
+            return false;
+        }
+        const char* bytes = payload;
+        const char* end = payload + header.length;
+        samples.assign(header.samples, TelemetrySample());
+        uint64_t value;
+        for (const auto& [name, member] : TelemetrySample::textColumns) {
+            std::vector<std::string> dictionary;
+            if (!getVarint(bytes, end, value)) {
+                return false;
+            }
+            dictionary.resize(value);
+            for (auto& text : dictionary) {
+                if (!getVarint(bytes, end, value) || static_cast<uint64_t>(end - bytes) < value) {
+                    return false;
+                }
+                text.assign(bytes, value);
+                bytes += value;
+            }
+            for (auto& sample : samples) {
+                if (!getVarint(bytes, end, value) || value >= dictionary.size()) {
+                    return false;
+                }
+                sample.*member = dictionary[value];
+            }
+        }
+        samples.front().time = header.firstTime;
+        int64_t previousDelta = 0;
+        for (size_t i = 1; i < samples.size(); ++i) {
+            if (!getVarint(bytes, end, value)) {
+                return false;
+            }
+            previousDelta += unzigzag(value);
+            samples[i].time = samples[i - 1].time + previousDelta;
+        }
+        for (const auto& [name, member] : TelemetrySample::integerColumns) {
+            int64_t previous = 0;
+            for (auto& sample : samples) {
+                if (!getVarint(bytes, end, value)) {
+                    return false;
+                }
+                previous += unzigzag(value);
+                sample.*member = previous;
+            }
+        }
+        for (const auto& [name, member] : TelemetrySample::temperatureColumns) {
+            uint64_t previous = 0;
+            for (auto& sample : samples) {
+                if (!getXor(bytes, end, sample.*member, previous)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @class TelemetryReader
+ * @brief Reads a telemetry file through a memory map.
+ *
+ * Opening the file reads only the block headers. A range query decodes only the blocks whose
+ * time range overlaps the query, so reading a few minutes of a long run touches a few pages.
+ */
+class TelemetryReader {
+
+    /**
+     * @struct Block
+     * @brief Position and header of one block in the file.
+     */
+    struct Block {
+        size_t offset;                       ///< Offset of the payload in the file.
+        TelemetryFormat::BlockHeader header; ///< Block header.
+    };
+
+    /// Mapped contents of the file.
+    MappedFile file;
+    /// Complete blocks in file order.
+    std::vector<Block> blocks;
+    /// Length of the file header and the complete blocks.
+    size_t validLength = 0;
+    /// True if the file starts with a telemetry file header.
+    bool validHeader = false;
+
+    /**
+     * @struct Bucket
+     * @brief Samples combined into one for downsampling.
+     */
+    struct Bucket {
+        TelemetrySample last;                               ///< Last sample in the bucket.
+        std::array<double, 3> sums{};                       ///< Sum of each temperature.
+        std::array<int64_t, 3> counts{};                    ///< Number of each temperature.
+        int64_t samples = 0;                                ///< Number of samples.
+
+        void add(const TelemetrySample& sample) {
+            last = sample;
+            for (size_t i = 0; i < TelemetrySample::temperatureColumns.size(); ++i) {
+                double value = sample.*TelemetrySample::temperatureColumns[i].second;
+                if (!std::isnan(value)) {
+                    sums[i] += value;
+                    ++counts[i];
+                }
+            }
+            ++samples;
+        }
+
+        /// Returns the last sample with each temperature replaced by its mean.
+        [[nodiscard]] TelemetrySample result() const {
+            TelemetrySample sample = last;
+            for (size_t i = 0; i < TelemetrySample::temperatureColumns.size(); ++i) {
+                sample.*TelemetrySample::temperatureColumns[i].second =
+                        counts[i] > 0 ? sums[i] / static_cast<double>(counts[i]) : std::numeric_limits<double>::quiet_NaN();
+            }
+            return sample;
+        }
+    };
+
+public:
+
+    /**
+     * @brief Maps a file and reads its block headers.
+     * @param path Path of the telemetry file.
+     */
+    explicit TelemetryReader(const std::string& path) : file(path) {
+        if (!file.isOpen() || file.size() < TelemetryFormat::fileHeaderSize
+            || std::memcmp(file.data(), TelemetryFormat::fileMagic, sizeof(TelemetryFormat::fileMagic)) != 0) {
+            return;
+        }
+        validHeader = true;
+        size_t offset = TelemetryFormat::fileHeaderSize;
+        TelemetryFormat::BlockHeader header;
+        while (TelemetryFormat::header(file.data() + offset, file.size() - offset, header)) {
+            blocks.push_back(Block{offset + TelemetryFormat::blockHeaderSize, header});
+            offset += TelemetryFormat::blockHeaderSize + header.length;
+        }
+        validLength = offset;
+    }
+
+    /// Returns true if the file is a telemetry file.
+    [[nodiscard]] bool isOpen() const {
+        return validHeader;
+    }
+
+    /// Returns the length of the file header and the complete blocks; anything after is a cut-short block.
+    [[nodiscard]] size_t validSize() const {
+        return validLength;
+    }
+
+    /// Returns the offset where the last block starts, or where the next block would start if there are none.
+    [[nodiscard]] size_t lastBlockStart() const {
+        return blocks.empty() ? validLength : blocks.back().offset - TelemetryFormat::blockHeaderSize;
+    }
+
+    /// Returns the length of the file.
+    [[nodiscard]] size_t fileSize() const {
+        return file.size();
+    }
+
+    /// Returns the number of blocks.
+    [[nodiscard]] size_t blockCount() const {
+        return blocks.size();
+    }
+
+    /// Returns the number of samples in all blocks.
+    [[nodiscard]] int64_t sampleCount() const {
+        int64_t count = 0;
+        for (const auto& block : blocks) {
+            count += block.header.samples;
+        }
+        return count;
+    }
+
+    /// Returns the time of the first sample, or 0 if there are none.
+    [[nodiscard]] int64_t firstTime() const {
+        return blocks.empty() ? 0 : blocks.front().header.firstTime;
+    }
+
+    /// Returns the time of the last sample, or 0 if there are none.
+    [[nodiscard]] int64_t lastTime() const {
+        return blocks.empty() ? 0 : blocks.back().header.lastTime;
+    }
+
+    /// Returns true if the checksum of the last block matches.
+    [[nodiscard]] bool lastBlockValid() const {
+        if (blocks.empty()) {
+            return true;
+        }
+        const auto& block = blocks.back();
+        return TelemetryFormat::checksum(file.data() + block.offset, block.header.length) == block.header.checksum;
+    }
+
+    /**
+     * @brief Reads the samples in a time range, optionally combined into buckets.
+     *
+     * With downsampling, each bucket of every milliseconds gives one sample: the last sample in
+     * the bucket, with each temperature replaced by the mean over the bucket.
+     * @param from First time to include, in milliseconds since the Unix epoch.
+     * @param to Last time to include.
+     * @param every Bucket length in milliseconds, or 0 for every sample.
+     * @param visit Called with each sample in time order.
+     * @return False if a block in the range is damaged; the samples before it were visited.
+     */
+    bool read(int64_t from, int64_t to, int64_t every, const std::function<void(const TelemetrySample&)>& visit) const {
+        std::vector<TelemetrySample> samples;
+        Bucket bucket;
+        int64_t bucketStart = 0;
+        for (const auto& block : blocks) {
+            if (block.header.lastTime < from || block.header.firstTime > to) {
+                continue;
+            }
+            if (!TelemetryFormat::decode(block.header, file.data() + block.offset, samples)) {
+                std::cerr << "Error. Damaged telemetry block at offset " << block.offset << "." << std::endl;
+                return false;
+            }
+            for (const auto& sample : samples) {
+                if (sample.time < from || sample.time > to) {
+                    continue;
+                }
+                if (every <= 0) {
+                    visit(sample);
+                    continue;
+                }
+                if (bucket.samples > 0 && sample.time >= bucketStart + every) {
+                    visit(bucket.result());
+                    bucket = Bucket();
+                }
+                if (bucket.samples == 0) {
+                    bucketStart = from + (sample.time - from) / every * every;
+                }
+                bucket.add(sample);
+            }
+        }
+        if (bucket.samples > 0) {
+            visit(bucket.result());
+        }
+        return true;
+    }
+};
+
+/**
+ * @class TelemetryWriter
+ * @brief Appends samples to a telemetry file.
+ *
+ * Samples are kept in memory until a block is full or old enough, and then the block is
+ * appended and flushed in one piece. A crash loses at most the samples of the block being
+ * filled. When an existing file is opened, a block that was cut short by an earlier crash is
+ * removed before anything is appended.
+ */
+class TelemetryWriter {
+
+    /// Path of the file.
+    std::string path;
+    /// File opened for appending.
+    std::ofstream out;
+    /// Samples not written yet.
+    std::vector<TelemetrySample> pending;
+    /// Number of samples in a full block.
+    size_t blockSamples;
+    /// Longest time span of a block in milliseconds.
+    int64_t blockSpan;
+
+public:
+
+    /**
+     * @brief Opens or creates a telemetry file. Use isOpen to check for success.
+     * @param path_ Path of the file.
+     * @param blockSamples_ Number of samples in a full block.
+     * @param blockSpan_ Longest time span of a block in milliseconds.
+     */
+    explicit TelemetryWriter(const std::string& path_, size_t blockSamples_ = 32, int64_t blockSpan_ = 30000) :
+            path(path_),
+            blockSamples(blockSamples_ > 0 ? blockSamples_ : 1),
+            blockSpan(blockSpan_) {
+        std::error_code error;
+        auto size = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+        if (size > 0) {
+            size_t validSize;
+            {
+                TelemetryReader reader(path);
+                if (!reader.isOpen()) {
+                    std::cerr << "Error. " << path << " is not a telemetry file." << std::endl;
+                    return;
+                }
+                validSize = reader.validSize();
+                if (!reader.lastBlockValid()) {
+                    // only the block being written when a recording was cut short is dropped
+                    validSize = reader.lastBlockStart();
+                }
+            }
+            if (validSize < size) {
+                std::filesystem::resize_file(path, validSize, error);
+            }
+        }
+        out.open(path, std::ios::out | std::ios::binary | std::ios::app);
+        if (out && size == 0) {
+            std::string header(TelemetryFormat::fileMagic, sizeof(TelemetryFormat::fileMagic));
+            TelemetryFormat::putFixed(header, TelemetryFormat::version);
+            out << header << std::flush;
+        }
+    }
+
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    /// Writes any pending samples.
+    ~TelemetryWriter() {
+        flush();
+    }
+
+    /// Returns true if the file is open for appending.
+    [[nodiscard]] bool isOpen() const {
+        return out.is_open() && static_cast<bool>(out);
+    }
+
+    /**
+     * @brief Adds a sample, and writes a block when it is full.
+     * @return True unless a block could not be written.
+     */
+    bool add(const TelemetrySample& sample) {
+        pending.push_back(sample);
+        if (pending.size() >= blockSamples || sample.time - pending.front().time >= blockSpan) {
+            return flush();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Writes the pending samples as one block.
+     * @return True if the block was written.
+     */
+    bool flush() {
+        if (pending.empty() || !out.is_open()) {
+            return true;
+        }
+        std::string block = TelemetryFormat::encode(pending);
+        pending.clear();
+        out.write(block.data(), static_cast<std::streamsize>(block.size()));
+        out.flush();
+        return static_cast<bool>(out);
+    }
+};
@@ -8,8 +8,14 @@
 // SPDX-License-Identifier: MIT
 //
 
+#pragma once
+
+#include "RequestStats.hpp"
+#include "TextFormatter.hpp"
+#include "TypedResponses.hpp"
 #include "nlohmann/json.hpp"
 #include <iostream>
+#include <optional>
 
 // define CPPHTTPLIB_OPENSSL_SUPPORT is set as an option in the CMakeLists.txt
 #include "httplib.h"
@@ -41,6 +47,118 @@ class TempoClient {
 
     /// Response from a call to PTC-Tempo.
     httplib::Result httpResult{nullptr, httplib::Error::Unknown, httplib::Headers()};
+    /// Time to wait for a response before the read fails.
+    std::chrono::seconds readTimeout;
+
+public:
+
+    /**
+     * @struct ConnectionStats
+     * @brief Counts how the HTTP connection to PTC-Tempo was used.
+     */
+    struct ConnectionStats {
+        int64_t requests = 0;     ///< Number of requests sent, not counting retries.
+        int64_t connects = 0;     ///< Number of TCP connections opened.
+        int64_t reused = 0;       ///< Number of requests sent over a connection that was already open.
+        int64_t reconnects = 0;   ///< Number of requests retried because PTC-Tempo dropped the connection.
+        int64_t parses = 0;       ///< Number of response bodies parsed as JSON.
+    };
+
+    /**
+     * @struct ParsedResponse
+     * @brief Body of the current response, parsed once, and the status fields read from it.
+     */
+    struct ParsedResponse {
+        json body = json::object();  ///< Parsed body; an empty object if the body is empty or not valid JSON.
+        bool valid = false;          ///< True if there is a response with status 200 and its body is valid JSON.
+        std::string error;           ///< Reason the body is not valid.
+        std::string status;          ///< Value of "status", used when monitoring runs and status.
+        std::string lid;             ///< Value of "lid", used when monitoring the lid.
+    };
+
+private:
+
+    /// Connection counts for this client.
+    ConnectionStats connectionStats;
+    /// True to end the process when print finds an error, as the command line always has.
+    static inline bool exitsOnError = true;
+    /// Exit code of the last error found by print, or 0.
+    int lastExitCode = 0;
+
+    /// Parsed body of httpResult; empty until parsed is called for the current response.
+    std::optional<ParsedResponse> parsedResponse;
+
+    /// Receives the phase times of each request, or null to not time them.
+    RequestStats* requestStats = nullptr;
+    /// Path of the last request as counted in requestStats.
+    std::string lastEndpoint;
+    /// Time the first part of the current response arrived, if it has.
+    std::optional<RequestStats::Clock::time_point> firstByte;
+
+    /// Notes the arrival of the first part of a response body; passed to the HTTP library as progress.
+    bool arrived() {
+        if (!firstByte) {
+            firstByte = RequestStats::Clock::now();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Sends a request and stores the response in httpResult.
+     *
+     * The connection is kept open between requests. The instrument may close an idle connection at
+     * any time, so if a request fails to write on a connection that was reused, or fails to read
+     * before any of the response arrived and well before the read timeout, an idempotent request
+     * is sent once more on a new connection. A read that times out is not sent again, since the
+     * instrument got the request and is only slow to answer it.
+     * @param path Path of the request, used to count it in the request stats.
+     * @param call Function that makes the HTTP call and returns its result.
+     * @param idempotent True if the request can be sent twice without side effects.
+     */
+    template<typename Call>
+    void send(const std::string& path, Call call, bool idempotent) {
+        parsedResponse.reset();
+        lastExitCode = 0;
+        ++connectionStats.requests;
+        auto connects = connectionStats.connects;
+        auto start = RequestStats::Clock::now();
+        firstByte.reset();
+        httpResult = call();
+        if (connects == connectionStats.connects) {
+            ++connectionStats.reused;
+            // a dropped connection fails at once, while a slow response takes the whole read timeout
+            bool dropped = httpResult.error() == httplib::Error::Write ||
+                           (httpResult.error() == httplib::Error::Read && !firstByte &&
+                            RequestStats::Clock::now() - start < readTimeout / 2);
+            if (idempotent && dropped) {
+                ++connectionStats.reconnects;
+                firstByte.reset();
+                httpResult = call();
+            }
+        }
+        if (requestStats != nullptr) {
+            auto end = RequestStats::Clock::now();
+            bool connected = connects != connectionStats.connects;
+            lastEndpoint = RequestStats::endpoint(path);
+            requestStats->request(lastEndpoint, connected);
+            requestStats->add(lastEndpoint, connected ? RequestStats::connect : RequestStats::wait, firstByte.value_or(end) - start);
+            if (firstByte) {
+                requestStats->add(lastEndpoint, RequestStats::read, end - *firstByte);
+            }
+        }
+    }
+
+    /// Sends a GET request for path.
+    void get(const std::string& path) {
+        send(path, [this, &path]() {
+            return httpClient.Get(path, [this](uint64_t, uint64_t) { return arrived(); });
+        }, true);
+    }
+
+    /// Sends a PUT request without a body for path.
+    void put(const std::string& path) {
+        send(path, [this, &path]() { return httpClient.Put(path); }, false);
+    }
 
 public:
 
@@ -51,16 +169,86 @@ public:
      * @param waitTime Number of seconds to wait for a response.
      *
      * After the constructor is called, the host object may be used to make HTTP calls; no
-     * need to add HTTP headers or set up further authorization.
+     * need to add HTTP headers or set up further authorization. The connection is kept alive
+     * between calls, so a monitoring session uses the same connection for every poll. When built
+     * with USE_ZLIB, the client asks for compressed responses.
      */
-    TempoClient(const std::string& host, const std::string& password, int32_t waitTime) : httpClient(host) {
+    TempoClient(const std::string& host, const std::string& password, int32_t waitTime) :
+            httpClient(host),
+            readTimeout(waitTime) {
         httpClient.set_basic_auth("Automation", password);
         httpClient.set_read_timeout(time_t(waitTime));
+        httpClient.set_keep_alive(true);
+        compression(true);
+        // called once for each new socket, which makes it the place to count connections
+        httpClient.set_socket_options([this](httplib::socket_t) {
+            ++connectionStats.connects;
+        });
 #if defined(CPPHTTPLIB_OPENSSL_SUPPORT)
         httpClient.enable_server_certificate_verification(false);
 #endif
     }
 
+    TempoClient(const TempoClient&) = delete;
+    TempoClient& operator=(const TempoClient&) = delete;
+
+    /**
+     * @brief Sets whether PTC-Tempo is asked to compress responses.
+     *
+     * This only has an effect when the client is built with USE_ZLIB, and it is on by default.
+     * The HTTP library inflates a gzip or deflate body as it arrives, so the response body and
+     * the pieces handed to a ContentReceiver are always plain JSON.
+     * @param on True to accept gzip and deflate, false to ask for uncompressed responses.
+     */
+    void compression([[maybe_unused]] bool on) {
+#if defined(CPPHTTPLIB_ZLIB_SUPPORT)
+        httpClient.set_decompress(true);
+        httpClient.set_default_headers({{"Accept-Encoding", on ? "gzip, deflate" : "identity"}});
+#endif
+    }
+
+    /**
+     * @brief Times the phases of the following requests.
+     * @param stats Receives the phase times, or null to stop timing. It must outlive the requests.
+     */
+    void collectStats(RequestStats* stats) {
+        requestStats = stats;
+    }
+
+    /**
+     * @brief Adds the time since start to a phase of the last request, if requests are timed.
+     *
+     * This is for phases that happen outside the client, such as Monitor drawing a response.
+     * @param phase Phase of the request.
+     * @param start Time the phase started.
+     */
+    void timed(RequestStats::Phase phase, RequestStats::Clock::time_point start) {
+        if (requestStats != nullptr && !lastEndpoint.empty()) {
+            requestStats->since(lastEndpoint, phase, start);
+        }
+    }
+
+    /**
+     * @brief Sets whether print ends the process when the response is an error.
+     *
+     * This applies to every client in the process. A process that outlives one command, such as
+     * the daemon, turns this off and reads the exit code from exitCode instead.
+     * @param on True to call exit, false to return false from print.
+     */
+    static void exitOnError(bool on) {
+        exitsOnError = on;
+    }
+
+    /// Returns the exit code of the last error found by print, or 0 if print found none.
+    [[nodiscard]] int exitCode() const {
+        return lastExitCode;
+    }
+
+    /// Forgets the exit code of the last error, so a client kept between commands starts each one at 0.
+    void clearExitCode() {
+        lastExitCode = 0;
+    }
+
     /**
      * @brief Makes a get call to the tempo endpoint.
      *
@@ -70,7 +258,7 @@ public:
      * waitTime has expired or it received a response.
      */
     void tempo() {
-        httpResult = httpClient.Get("/tempo");
+        get("/tempo");
     }
 
     /**
@@ -79,7 +267,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void openLid() {
-        httpResult = httpClient.Put("/tempo/lid/open");
+        put("/tempo/lid/open");
     }
 
     /**
@@ -88,7 +276,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void closeLid() {
-        httpResult = httpClient.Put("/tempo/lid/close");
+        put("/tempo/lid/close");
     }
 
     /**
@@ -97,7 +285,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void lid() {
-        httpResult = httpClient.Get("/tempo/lid");
+        get("/tempo/lid");
     }
 
     /**
@@ -106,7 +294,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void status() {
-        httpResult = httpClient.Get("/tempo/status");
+        get("/tempo/status");
     }
 
     /**
@@ -117,9 +305,11 @@ public:
      * @param clearFaults True to clear list of current faults, false to get list of faults.
      */
     void faults(bool clearFaults) {
-        httpResult = clearFaults ?
-            httpClient.Put("/tempo/errors/clear") :
-            httpClient.Get("/tempo/errors");
+        if (clearFaults) {
+            put("/tempo/errors/clear");
+        } else {
+            get("/tempo/errors");
+        }
     }
 
     /**
@@ -132,10 +322,10 @@ public:
     void protocols(bool publicProtocols) {
 
         if (publicProtocols) {
-            httpResult = httpClient.Get("/tempo/protocols/public");
+            get("/tempo/protocols/public");
 
         } else {
-            httpResult = httpClient.Get("/tempo/protocols/user");
+            get("/tempo/protocols/user");
         }
     }
 
@@ -147,15 +337,42 @@ public:
      * @param offset Index into number of run reports. Can range from 0 to count, where count is total number of run reports.
      */
     void reports(int64_t limit = 0, int64_t offset = 0) {
+        get(reportsPath(limit, offset));
+    }
+
+    /**
+     * @brief Gets a list of run reports from PTC Tempo and hands the body to receiver as it arrives.
+     *
+     * The body is not stored in the httpResult data member, so memory use does not depend on the
+     * number of reports. The receiver is only called if the response status is 200.
+     * This is a blocking call. It will not return until either the waitTime has expired or it received the whole response.
+     * @param limit Number of run reports to retrieve.
+     * @param offset Index into number of run reports. Can range from 0 to count, where count is total number of run reports.
+     * @param receiver Called with each piece of the body. Return false from it to cancel the request.
+     */
+    void reports(int64_t limit, int64_t offset, const httplib::ContentReceiver& receiver) {
+        std::string path = reportsPath(limit, offset);
+        send(path, [this, &path, &receiver]() {
+            bool ok = false;
+            return httpClient.Get(path, [this, &ok](const httplib::Response& response) {
+                ok = response.status == 200;
+                return arrived();
+            }, [&ok, &receiver](const char* data, size_t length) {
+                return !ok || receiver(data, length);
+            });
+        }, false);
+    }
+
+    /// Returns the path and query string for a list of run reports.
+    static std::string reportsPath(int64_t limit, int64_t offset) {
         if (limit <= 0 && offset <= 0) {
-            httpResult = httpClient.Get("/tempo/run-reports");
+            return "/tempo/run-reports";
         } else if (limit > 0 && offset == 0) {
-            httpResult = httpClient.Get("/tempo/run-reports?limit=" + std::to_string(limit));
+            return "/tempo/run-reports?limit=" + std::to_string(limit);
         } else if (limit == 0) {
-            httpResult = httpClient.Get("/tempo/run-reports?offset=" + std::to_string(offset));
-        } else {
-            httpResult = httpClient.Get("/tempo/run-reports?limit=" + std::to_string(limit) + "&offset=" + std::to_string(offset));
+            return "/tempo/run-reports?offset=" + std::to_string(offset);
         }
+        return "/tempo/run-reports?limit=" + std::to_string(limit) + "&offset=" + std::to_string(offset);
     }
 
     /**
@@ -180,7 +397,7 @@ public:
             versionJson["httpCode"] = httpResult->status;
             if (httpResult->status == 200) {
                 try {
-                    json response = json::parse(httpResult->body);
+                    json response = parsed().body;
                     auto device = response["device"];
                     auto details = device["details"];
                     std::string apiVersion = details["automationAPI"];
@@ -217,7 +434,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void reportsCount() {
-        httpResult = httpClient.Get("/tempo/run-reports/count");
+        get("/tempo/run-reports/count");
     }
 
     /**
@@ -225,7 +442,7 @@ public:
      * @param runId Which report to obtain. Value should be a GUID obtained from list of run reports.
      */
     void reports(const std::string& runId) {
-        httpResult = httpClient.Get("/tempo/run-reports/"+runId);
+        get("/tempo/run-reports/"+runId);
     }
 
     /**
@@ -234,7 +451,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void run() {
-        httpResult = httpClient.Get("/tempo/protocol-run");
+        get("/tempo/protocol-run");
     }
 
     /**
@@ -246,7 +463,9 @@ public:
     void run(const json& runInfo) {
         std::string body = runInfo.dump();
         const std::string contentType = "application/json";
-        httpResult = httpClient.Post("/tempo/protocol-run", body.c_str(), body.length(), contentType);
+        send("/tempo/protocol-run", [this, &body, &contentType]() {
+            return httpClient.Post("/tempo/protocol-run", body.c_str(), body.length(), contentType);
+        }, false);
     }
 
     /**
@@ -255,7 +474,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void stop() {
-        httpResult = httpClient.Put("/tempo/protocol-run/stop");
+        put("/tempo/protocol-run/stop");
     }
 
     /**
@@ -264,7 +483,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void skip() {
-        httpResult = httpClient.Put("/tempo/protocol-run/skip");
+        put("/tempo/protocol-run/skip");
     }
 
     /**
@@ -273,7 +492,7 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void pause() {
-        httpResult = httpClient.Put("/tempo/protocol-run/pause");
+        put("/tempo/protocol-run/pause");
     }
 
     /**
@@ -282,28 +501,109 @@ public:
      * This is a blocking call. It will not return until either the waitTime has expired or it received a response.
      */
     void resume() {
-        httpResult = httpClient.Put("/tempo/protocol-run/resume");
+        put("/tempo/protocol-run/resume");
+    }
+
+    /**
+     * @brief Gets the current response body parsed as JSON.
+     *
+     * The body is parsed the first time this is called after a request, and the same object is
+     * returned until the next request. A monitoring tick reads the status, checks it and prints
+     * it from one parse.
+     * @return The parsed response. If there is no response with status 200, or the body is not
+     *  valid JSON, valid is false and error says why.
+     */
+    const ParsedResponse& parsed() {
+        if (parsedResponse) {
+            return *parsedResponse;
+        }
+        parsedResponse.emplace();
+        if (httpResult.error() != httplib::Error::Success) {
+            parsedResponse->error = httplib::to_string(httpResult.error());
+        } else if (httpResult->status != 200) {
+            parsedResponse->error = "HTTP error";
+        } else if (!httpResult->body.empty()) {
+            ++connectionStats.parses;
+            auto start = RequestStats::Clock::now();
+            try {
+                parsedResponse->body = json::parse(httpResult->body);
+                parsedResponse->valid = true;
+            } catch (json::exception& ex) {
+                parsedResponse->body = json::object();
+                parsedResponse->error = ex.what();
+            }
+            timed(RequestStats::parse, start);
+        } else {
+            parsedResponse->valid = true;
+        }
+        if (const json& body = parsedResponse->body; body.is_object()) {
+            if (auto value = body.find("status"); value != body.end() && value->is_string()) {
+                parsedResponse->status = *value;
+            }
+            if (auto value = body.find("lid"); value != body.end() && value->is_string()) {
+                parsedResponse->lid = *value;
+            }
+        }
+        return *parsedResponse;
     }
 
     /**
-     * @brief This function obtains the status value from a JSON input stirng.
+     * @brief Decodes the current response into a typed response without building a JSON object.
+     *
+     * Known fields are filled straight from the body, and any other fields are kept in the extra
+     * fields of the response. This counts as a parse, but does not change what parsed returns.
+     * @param value Output parameter; a StatusResponse, LidResponse or RunResponse.
+     * @return True if the response status is 200 and the body is a JSON object.
+     */
+    template<typename T>
+    bool decode(T& value) {
+        if (!statusOK()) {
+            return false;
+        }
+        ++connectionStats.parses;
+        auto start = RequestStats::Clock::now();
+        bool success = ::decode(httpResult->body, value);
+        timed(RequestStats::parse, start);
+        return success;
+    }
+
+    /**
+     * @brief This function obtains the status value from the response.
      *
      * It is used to monitor the run status.
      * @return String containing run status.
      */
     std::string getRunStatus() {
-        json response = json::parse(httpResult->body);
-        return response["status"];
+        return parsed().status;
     }
 
     /**
-     * @brief This function obtains the lid status from a JSON input stirng.
+     * @brief This function obtains the lid status from the response.
      *
      * @return String containing lid status.
      */
     std::string getLidStatus() {
-        json response = json::parse(httpResult->body);
-        return response["lid"];
+        return parsed().lid;
+    }
+
+    /// Returns the connection counts for all calls made by this client.
+    [[nodiscard]] const ConnectionStats& connections() const {
+        return connectionStats;
+    }
+
+    /// Returns the response body. Only call this when statusOK returns true.
+    [[nodiscard]] const std::string& body() const {
+        return httpResult->body;
+    }
+
+    /// Returns the HTTP client error of the last request, or Success if a response arrived.
+    [[nodiscard]] httplib::Error error() const {
+        return httpResult.error();
+    }
+
+    /// Returns the HTTP status of the last response, or 0 if no response arrived.
+    [[nodiscard]] int httpStatus() const {
+        return httpResult.error() == httplib::Error::Success ? httpResult->status : 0;
     }
 
     /// Returns true if there are not HTTP result errors and the response status is 200.
@@ -322,33 +622,81 @@ public:
      * @return True for success, false if an exception occurred.
      */
     bool responseString(std::string& responseResult, std::string_view displayFormat = "json") {
-        if (httpResult->body.empty()) {
-            httpResult->body = "{}";
+        const auto& response = parsed();
+        if (!response.valid) {
+            std::cerr << response.error << std::endl;
+            return false;
         }
+        auto start = RequestStats::Clock::now();
         try {
-            json response = json::parse(httpResult->body);
-            response["httpCode"] = 200;
-            responseResult = response.dump(indent);
+            json output = response.body;
+            output["httpCode"] = 200;
+            responseResult = output.dump(indent);
             if (displayFormat == "text") {
                 responseResult = formatResponseForTextDisplay(responseResult);
             }
-        }  catch (json::exception& ex) {
+        } catch (json::exception& ex) {
             std::cerr << ex.what() << std::endl;
             return false;
         }
+        timed(RequestStats::format, start);
+        return true;
+    }
+
+    /**
+     * @brief Converts the response into a JSON object without printing it or exiting.
+     *
+     * This is used when several instruments are called at once and the failure of one of them
+     * must not stop the others. Errors are stored in the "error" value of the JSON object. The
+     * "httpCode" value is the response status, or 504 if the instrument could not be reached.
+     * @param response Output parameter for the response body or error.
+     * @return True if response status is 200 and the body is valid JSON.
+     */
+    bool result(json& response) {
+        if (httpResult.error() != httplib::Error::Success) {
+            response["httpCode"] = 504;
+            response["error"] = httplib::to_string(httpResult.error());
+            return false;
+        }
+        if (httpResult->status != 200) {
+            response["httpCode"] = httpResult->status;
+            response["error"] = "HTTP error";
+            return false;
+        }
+        const auto& parsedBody = parsed();
+        try {
+            response = parsedBody.body;
+            response["httpCode"] = 200;
+        } catch (json::exception& ex) {
+            response = json::object();
+            response["httpCode"] = 200;
+            response["error"] = ex.what();
+            return false;
+        }
+        if (!parsedBody.valid) {
+            response["error"] = parsedBody.error;
+            return false;
+        }
         return true;
     }
 
     /**
      * @brief Print response body if response status is 200, otherwise send error message to stderr.
+     *
+     * After an error, the process exits with the HTTP status or client error as its exit code,
+     * unless exitOnError(false) was called.
      * @param displayFormat Output format requested by user; either "text" or "json".
      * @return True for success, false if response status is not 200 or an error occurred.
      */
     bool print(const std::string& displayFormat = "json") {
-
+        lastExitCode = 0;
         if (httpResult.error() != httplib::Error::Success) {
             std::cerr << "HTTP client error: " << httplib::to_string(httpResult.error()) << std::endl;
-            exit(static_cast<int>(httpResult.error()));
+            lastExitCode = static_cast<int>(httpResult.error());
+            if (exitsOnError) {
+                exit(lastExitCode);
+            }
+            return false;
 
         } else if (httpResult->status == 200) {
             std::string responseResult;
@@ -356,40 +704,26 @@ public:
             if (!responseString(responseResult, displayFormat)) {
                 return false;
             }
+            auto start = RequestStats::Clock::now();
             std::cout << responseResult << std::endl;
+            timed(RequestStats::output, start);
         } else {
             std::cerr << "HTTP error: " << httpResult->status << std::endl;
-            exit(httpResult->status);
+            lastExitCode = httpResult->status;
+            if (exitsOnError) {
+                exit(lastExitCode);
+            }
+            return false;
         }
         return true;
     }
 
+    /**
+     * @brief Converts JSON dumped with an indent to text for display, in place.
+     * @param res Response as JSON text; replaced by the text display.
+     * @return res.
+     */
     static std::string& formatResponseForTextDisplay(std::string& res) {
-        std::istringstream stream(res);
-        std::ostringstream result;
-        std::string line;
-        bool lastBlank = false;
-        int16_t lastIndent = 0;
-        while (std::getline(stream, line)) {
-            auto pos = line.find_first_not_of(' ');
-            int isBlank = (line[pos] == '{' || line[pos] == '}' || line[pos] == ']');
-
-            if (!isBlank) {
-                const std::string notPrint = "[{\",";
-                line.erase(remove_if(line.begin(), line.end(), [&notPrint](const char& c) {
-                    return notPrint.find(c) != std::string::npos;
-                }), line.end());
-
-                if (lastBlank && lastIndent == static_cast<int16_t>(pos)) {
-                    // blank line between each entity in a list
-                    result << std::endl;
-                }
-                lastIndent = static_cast<int16_t>(pos);
-                result << line << std::endl;
-            }
-            lastBlank = isBlank;
-        }
-        res = result.str();
-        return res;
+        return TextFormatter::format(res);
     }
 };
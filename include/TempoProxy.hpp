@@ -0,0 +1,372 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "httplib.h"
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class TempoProxy
+ * @brief Serves the Automation API paths of one PTC Tempo and shares its responses among clients.
+ *
+ * Systems that poll the same instrument can point at the proxy instead, so the instrument sees
+ * the same request rate no matter how many of them there are.
+ * - GET responses with status 200 are kept for a short time that depends on the path, e.g. half
+ *   a second for /tempo/lid and five minutes for a single run report, which never changes.
+ * - Identical GETs that arrive while one is waiting for the instrument share its response
+ *   instead of making their own request.
+ * - PUT and POST requests go straight to the instrument, and drop every kept response, since
+ *   opening the lid or starting a run changes what the other paths return.
+ *
+ * The Authorization header of each client is passed on to the instrument, so the instrument
+ * still checks every password. It is part of the key of a kept response, so a response is only
+ * shared among clients that sent the same credentials.
+ *
+ * GET /proxy/stats returns the counts of requests, hits, shared waits and requests made to the
+ * instrument.
+ */
+class TempoProxy {
+
+public:
+
+    /// Time a response is kept.
+    using Duration = std::chrono::milliseconds;
+    /// Clock for the age of kept responses.
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct Reply
+     * @brief Response from the instrument as passed on to clients.
+     */
+    struct Reply {
+        int status = 0;            ///< HTTP status.
+        std::string body;          ///< Response body.
+        std::string contentType;   ///< Value of the Content-Type header.
+    };
+
+private:
+
+    /**
+     * @struct Entry
+     * @brief Response kept for one path, or the request waiting for it.
+     */
+    struct Entry {
+        std::shared_future<Reply> reply;  ///< Response; not ready while the request is waiting.
+        Clock::time_point expires;        ///< Time the response is no longer served.
+        uint64_t id = 0;                  ///< Tells this entry from a later one for the same key.
+    };
+
+    /// Default time each path prefix is kept; the longest matching prefix applies.
+    static inline const std::vector<std::pair<std::string, Duration>> defaultTimes = {
+            {"/tempo", Duration(5000)},
+            {"/tempo/status", Duration(1000)},
+            {"/tempo/lid", Duration(500)},
+            {"/tempo/protocol-run", Duration(1000)},
+            {"/tempo/errors", Duration(2000)},
+            {"/tempo/protocols", Duration(10000)},
+            {"/tempo/run-reports", Duration(10000)},
+            {"/tempo/run-reports/count", Duration(10000)},
+            {"/tempo/run-reports/", Duration(300000)}};
+
+    /// URL for PTC Tempo.
+    std::string host;
+    /// Number of seconds to wait for the instrument.
+    int32_t waitTime;
+    /// Time each path prefix is kept.
+    std::vector<std::pair<std::string, Duration>> times;
+    /// Serves the clients.
+    httplib::Server server;
+
+    /// Guards entries, nextId and idleClients.
+    std::mutex mutex;
+    /// Kept and waiting responses by key.
+    std::unordered_map<std::string, Entry> entries;
+    /// ID of the next entry.
+    uint64_t nextId = 1;
+    /// Connections to the instrument not in use; one is made for each request that needs one.
+    std::vector<std::unique_ptr<httplib::Client>> idleClients;
+
+    std::atomic<int64_t> requests{0};   ///< Requests from clients.
+    std::atomic<int64_t> hits{0};       ///< GETs answered from a kept response.
+    std::atomic<int64_t> shared{0};     ///< GETs that waited for another client's request.
+    std::atomic<int64_t> upstream{0};   ///< Requests made to the instrument.
+    std::atomic<int64_t> failures{0};   ///< Requests to the instrument that got no response.
+
+    /// Returns the path and query of a request, with the query in a fixed order.
+    static std::string target(const httplib::Request& req) {
+        static const char hex[] = "0123456789ABCDEF";
+        std::string path = req.path;
+        char separator = '?';
+        for (const auto& [key, value] : req.params) {
+            path += separator;
+            separator = '&';
+            for (const std::string* part : {&key, &value}) {
+                for (unsigned char c : *part) {
+                    if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+                        path += static_cast<char>(c);
+                    } else {
+                        path += '%';
+                        path += hex[c >> 4];
+                        path += hex[c & 15];
+                    }
+                }
+                if (part == &key) {
+                    path += '=';
+                }
+            }
+        }
+        return path;
+    }
+
+    /// Returns how long a response for a path is kept.
+    [[nodiscard]] Duration keepTime(const std::string& path) const {
+        Duration time(0);
+        size_t matched = 0;
+        for (const auto& [prefix, duration] : times) {
+            bool matches = path.compare(0, prefix.size(), prefix) == 0
+                           && (path.size() == prefix.size() || prefix.back() == '/' || path[prefix.size()] == '/');
+            if (matches && prefix.size() >= matched) {
+                matched = prefix.size();
+                time = duration;
+            }
+        }
+        return time;
+    }
+
+    /// Takes a connection to the instrument.
+    std::unique_ptr<httplib::Client> acquire() {
+        {
+            std::scoped_lock lock(mutex);
+            if (!idleClients.empty()) {
+                auto client = std::move(idleClients.back());
+                idleClients.pop_back();
+                return client;
+            }
+        }
+        auto client = std::make_unique<httplib::Client>(host);
+        client->set_read_timeout(time_t(waitTime));
+        client->set_keep_alive(true);
+#if defined(CPPHTTPLIB_ZLIB_SUPPORT)
+        client->set_decompress(true);
+#endif
+#if defined(CPPHTTPLIB_OPENSSL_SUPPORT)
+        client->enable_server_certificate_verification(false);
+#endif
+        return client;
+    }
+
+    /// Returns a connection so another request can reuse it.
+    void release(std::unique_ptr<httplib::Client> client) {
+        std::scoped_lock lock(mutex);
+        idleClients.push_back(std::move(client));
+    }
+
+    /// Sends a request to the instrument.
+    Reply forward(const httplib::Request& req, const std::string& path) {
+        httplib::Headers headers;
+        if (req.has_header("Authorization")) {
+            headers.emplace("Authorization", req.get_header_value("Authorization"));
+        }
+        std::string contentType = req.has_header("Content-Type") ? req.get_header_value("Content-Type") : "application/json";
+
+        ++upstream;
+        auto client = acquire();
+        httplib::Result result = req.method == "GET" ? client->Get(path, headers)
+                                 : req.method == "POST" ? client->Post(path, headers, req.body, contentType)
+                                 : client->Put(path, headers, req.body, contentType);
+        Reply reply;
+        if (result.error() != httplib::Error::Success) {
+            ++failures;
+            reply.status = 504;
+            reply.body = json{{"error", httplib::to_string(result.error())}}.dump();
+            reply.contentType = "application/json";
+            // a broken connection is not reused
+            return reply;
+        }
+        reply.status = result->status;
+        reply.body = result->body;
+        reply.contentType = result->has_header("Content-Type") ? result->get_header_value("Content-Type") : "application/json";
+        release(std::move(client));
+        return reply;
+    }
+
+    /// Copies a reply into the response to a client.
+    static void send(const Reply& reply, httplib::Response& res) {
+        res.status = reply.status;
+        res.set_content(reply.body, reply.contentType);
+    }
+
+    /// Answers a GET from a kept response, by waiting for an identical request, or from the instrument.
+    void get(const httplib::Request& req, httplib::Response& res) {
+        ++requests;
+        std::string path = target(req);
+        Duration keep = keepTime(req.path);
+        if (keep.count() == 0) {
+            send(forward(req, path), res);
+            return;
+        }
+        std::string key = path + '\n' + req.get_header_value("Authorization");
+
+        std::promise<Reply> promise;
+        std::shared_future<Reply> existing;
+        uint64_t id = 0;
+        {
+            std::scoped_lock lock(mutex);
+            auto found = entries.find(key);
+            bool waiting = found != entries.end() && found->second.reply.wait_for(Duration(0)) != std::future_status::ready;
+            if (found != entries.end() && (waiting || Clock::now() < found->second.expires)) {
+                ++(waiting ? shared : hits);
+                existing = found->second.reply;
+            } else {
+                id = nextId++;
+                entries[key] = Entry{promise.get_future().share(), Clock::time_point::max(), id};
+            }
+        }
+        if (existing.valid()) {
+            send(existing.get(), res);
+            return;
+        }
+
+        Reply reply = forward(req, path);
+        {
+            std::scoped_lock lock(mutex);
+            auto found = entries.find(key);
+            if (found != entries.end() && found->second.id == id) {
+                if (reply.status == 200) {
+                    found->second.expires = Clock::now() + keep;
+                } else {
+                    // errors are passed to the waiting clients but not kept
+                    entries.erase(found);
+                }
+            }
+        }
+        promise.set_value(reply);
+        send(reply, res);
+    }
+
+    /// Passes a PUT or POST to the instrument and drops every kept response.
+    void change(const httplib::Request& req, httplib::Response& res) {
+        ++requests;
+        {
+            std::scoped_lock lock(mutex);
+            // requests still waiting finish for their own clients, but later GETs ask again
+            entries.clear();
+        }
+        send(forward(req, target(req)), res);
+        std::scoped_lock lock(mutex);
+        entries.clear();
+    }
+
+public:
+
+    /**
+     * @brief Sets up a proxy for one instrument. Nothing is served until listen is called.
+     * @param host_ URL for PTC Tempo.
+     * @param waitTime_ Number of seconds to wait for the instrument.
+     * @param keepTimes Times that replace or add to the default keep time of path prefixes.
+     * @param threads Number of client requests served at the same time.
+     */
+    TempoProxy(const std::string& host_, int32_t waitTime_,
+               const std::vector<std::pair<std::string, Duration>>& keepTimes, size_t threads) :
+            host(host_),
+            waitTime(waitTime_),
+            times(defaultTimes) {
+        for (const auto& [prefix, duration] : keepTimes) {
+            times.emplace_back(prefix, duration);
+        }
+        threads = threads > 0 ? threads : 1;
+        server.new_task_queue = [threads]() { return new httplib::ThreadPool(threads); };
+        server.Get("/proxy/stats", [this](const httplib::Request&, httplib::Response& res) {
+            res.set_content(stats().dump(), "application/json");
+        });
+        server.Get(R"(/tempo(/.*)?)", [this](const httplib::Request& req, httplib::Response& res) {
+            get(req, res);
+        });
+        server.Put(R"(/tempo/.*)", [this](const httplib::Request& req, httplib::Response& res) {
+            change(req, res);
+        });
+        server.Post(R"(/tempo/.*)", [this](const httplib::Request& req, httplib::Response& res) {
+            change(req, res);
+        });
+    }
+
+    TempoProxy(const TempoProxy&) = delete;
+    TempoProxy& operator=(const TempoProxy&) = delete;
+
+    /**
+     * @brief Parses a keep time option of the form path=seconds.
+     * @param text Option value.
+     * @param keepTime Output parameter for the path prefix and time.
+     * @return True if the value is valid.
+     */
+    static bool parseKeepTime(const std::string& text, std::pair<std::string, Duration>& keepTime) {
+        auto equals = text.find('=');
+        if (equals == std::string::npos || equals == 0 || text[0] != '/') {
+            return false;
+        }
+        try {
+            double seconds = std::stod(text.substr(equals + 1));
+            if (seconds < 0) {
+                return false;
+            }
+            keepTime = {text.substr(0, equals), std::chrono::duration_cast<Duration>(std::chrono::duration<double>(seconds))};
+        } catch (std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Serves clients until stop is called.
+     * @param address Address to listen on.
+     * @param port Port to listen on.
+     * @return False if the port could not be opened.
+     */
+    bool listen(const std::string& address, int port) {
+        if (!server.bind_to_port(address, port)) {
+            std::cerr << "Error. Unable to listen on " << address << ":" << port << "." << std::endl;
+            return false;
+        }
+        std::cerr << "Serving " << host << " on http://" << address << ":" << port << std::endl;
+        return server.listen_after_bind();
+    }
+
+    /// Stops serving; listen returns once the requests being served are answered.
+    void stop() {
+        server.stop();
+    }
+
+    /// Returns the request counts.
+    [[nodiscard]] json stats() const {
+        json counts;
+        counts["requests"] = requests.load();
+        counts["hits"] = hits.load();
+        counts["shared"] = shared.load();
+        counts["upstream"] = upstream.load();
+        counts["failures"] = failures.load();
+        return counts;
+    }
+};
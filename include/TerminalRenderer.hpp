@@ -0,0 +1,207 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#if defined(_WIN32)
+#error "TerminalRenderer uses POSIX terminals; Monitor uses the Windows console API instead."
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/**
+ * @class TerminalRenderer
+ * @brief Draws monitor frames on a Linux or other POSIX terminal.
+ *
+ * While active, the renderer uses the terminal's alternate screen, so the shell's scrollback is
+ * left as it was and the monitor output does not pile up in it. Each frame is compared line by
+ * line with the frame before it, and only lines that changed are rewritten, using cursor
+ * addressing. All the changes of a frame go out in one write. Lines are cut to the width of the
+ * window and frames to its height; when the window is resized, the next frame is drawn in full.
+ *
+ * If the process is stopped with Ctrl+C while active, the terminal is switched back to the
+ * normal screen before the process exits.
+ */
+class TerminalRenderer {
+
+    /// Switches to the alternate screen, hides the cursor and clears the screen.
+    static constexpr std::string_view enterSequence = "\x1b[?1049h\x1b[?25l\x1b[H\x1b[2J";
+    /// Shows the cursor and switches back to the normal screen.
+    static constexpr std::string_view leaveSequence = "\x1b[?25h\x1b[?1049l";
+
+    /// Terminal the frames are written to.
+    int fd;
+    /// True between begin and end.
+    bool drawing = false;
+    /// Lines of the frame on the screen.
+    std::vector<std::string> previous;
+    /// Window size when the frame on the screen was drawn.
+    winsize lastSize{};
+    /// Escape sequences and text of the next write; its capacity is reused for every frame.
+    std::string buffer;
+    struct sigaction previousInterrupt{};  ///< SIGINT handler in place before begin.
+    struct sigaction previousTerminate{};  ///< SIGTERM handler in place before begin.
+
+    /// Writes all of text to the terminal.
+    static bool writeAll(int fd, const char* text, size_t length) {
+        while (length > 0) {
+            auto written = ::write(fd, text, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            text += written;
+            length -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    /// Restores the terminal on stdout and lets the signal end the process as it would have.
+    static void restoreOnSignal(int signal) {
+        if (::write(STDOUT_FILENO, leaveSequence.data(), leaveSequence.size()) < 0) {
+            // nothing more can be done in a signal handler
+        }
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+
+    /// Returns the length of at most columns characters of line, without splitting a UTF-8 character.
+    static size_t fit(std::string_view line, size_t columns) {
+        size_t characters = 0;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if ((static_cast<unsigned char>(line[i]) & 0xc0) != 0x80) {
+                if (characters == columns) {
+                    return i;
+                }
+                ++characters;
+            }
+        }
+        return line.size();
+    }
+
+public:
+
+    /**
+     * @brief Sets up a renderer for a terminal. Nothing is written until begin is called.
+     * @param fd_ File descriptor of the terminal.
+     */
+    explicit TerminalRenderer(int fd_ = STDOUT_FILENO) : fd(fd_) {
+    }
+
+    TerminalRenderer(const TerminalRenderer&) = delete;
+    TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+    /// Switches the terminal back to the normal screen if end was not called.
+    ~TerminalRenderer() {
+        end();
+    }
+
+    /// Returns true if the file descriptor is a terminal, so frames can be drawn in place.
+    [[nodiscard]] bool available() const {
+        return ::isatty(fd) == 1;
+    }
+
+    /// Returns true between begin and end.
+    [[nodiscard]] bool active() const {
+        return drawing;
+    }
+
+    /**
+     * @brief Switches to the alternate screen and clears it.
+     * @return True if the terminal accepted the switch.
+     */
+    bool begin() {
+        if (drawing) {
+            return true;
+        }
+        previous.clear();
+        lastSize = winsize{};
+        if (!writeAll(fd, enterSequence.data(), enterSequence.size())) {
+            return false;
+        }
+        drawing = true;
+        struct sigaction action{};
+        action.sa_handler = restoreOnSignal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, &previousInterrupt);
+        sigaction(SIGTERM, &action, &previousTerminate);
+        return true;
+    }
+
+    /**
+     * @brief Draws a frame, rewriting only the lines that differ from the frame on the screen.
+     * @param frame Text of the frame, with lines separated by newlines.
+     * @return True if the frame was written.
+     */
+    bool draw(std::string_view frame) {
+        if (!drawing) {
+            return false;
+        }
+        winsize size{};
+        if (::ioctl(fd, TIOCGWINSZ, &size) != 0 || size.ws_row == 0 || size.ws_col == 0) {
+            size.ws_row = 24;
+            size.ws_col = 80;
+        }
+        buffer.clear();
+        if (size.ws_row != lastSize.ws_row || size.ws_col != lastSize.ws_col) {
+            // the terminal may have wrapped or moved the old lines, so draw everything again
+            buffer += "\x1b[H\x1b[2J";
+            previous.clear();
+            lastSize = size;
+        }
+
+        std::vector<std::string> lines;
+        for (size_t start = 0; start < frame.size() && lines.size() < size.ws_row;) {
+            size_t end = frame.find('\n', start);
+            std::string_view line = frame.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+            lines.emplace_back(line.substr(0, fit(line, size.ws_col)));
+            start = end == std::string_view::npos ? frame.size() : end + 1;
+        }
+
+        size_t count = std::max(lines.size(), previous.size());
+        for (size_t row = 0; row < count; ++row) {
+            const std::string empty;
+            const std::string& line = row < lines.size() ? lines[row] : empty;
+            if (row < previous.size() && previous[row] == line) {
+                continue;
+            }
+            buffer += "\x1b[";
+            buffer += std::to_string(row + 1);
+            buffer += ";1H";
+            buffer += line;
+            buffer += "\x1b[K";
+        }
+        previous = std::move(lines);
+        return buffer.empty() || writeAll(fd, buffer.data(), buffer.size());
+    }
+
+    /**
+     * @brief Shows the cursor and switches back to the normal screen.
+     */
+    void end() {
+        if (!drawing) {
+            return;
+        }
+        drawing = false;
+        writeAll(fd, leaveSequence.data(), leaveSequence.size());
+        sigaction(SIGINT, &previousInterrupt, nullptr);
+        sigaction(SIGTERM, &previousTerminate, nullptr);
+    }
+};
@@ -0,0 +1,172 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @class TextFormatter
+ * @brief Turns JSON dumped with an indent into the text display, in one pass over the bytes.
+ *
+ * The text display of responses works line by line:
+ * - A line whose first character after the indent is {, } or ] is dropped.
+ * - Every [, {, " and , is removed from the other lines, including inside strings.
+ * - A blank line is added before a line that follows a dropped line at the same indent, which
+ *   separates the entries of a list.
+ *
+ * format finds each line end with memchr and copies the runs of bytes between the removed
+ * characters into an output buffer that the caller keeps between calls, so formatting does
+ * not allocate once the buffer is large enough. Where SSE2 is available, the runs are found
+ * 16 bytes at a time. The output is the same, byte for byte, as the line by line version it
+ * replaced.
+ */
+class TextFormatter {
+
+    /// Table of the characters removed from a line, by byte value.
+    using ByteSet = std::array<bool, 256>;
+
+    /// Returns a table with the given characters set.
+    static constexpr ByteSet byteSet(std::string_view characters) {
+        ByteSet set{};
+        for (char c : characters) {
+            set[static_cast<unsigned char>(c)] = true;
+        }
+        return set;
+    }
+
+    /// Returns the characters removed from the lines of the text display.
+    static const ByteSet& lineRemoved() {
+        static constexpr ByteSet set = byteSet("[{\",");
+        return set;
+    }
+
+    /// Returns the characters removed by stripJson.
+    static const ByteSet& stripRemoved() {
+        static constexpr ByteSet set = byteSet("[]{}\",");
+        return set;
+    }
+
+    /// Returns the first character in [from, to) that is removed from a line, or to if there is none.
+    static const char* nextRemoved(const char* from, const char* to) {
+#if defined(__SSE2__)
+        const __m128i bracket = _mm_set1_epi8('[');
+        const __m128i brace = _mm_set1_epi8('{');
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i comma = _mm_set1_epi8(',');
+        while (to - from >= 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(from));
+            __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, bracket), _mm_cmpeq_epi8(bytes, brace)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, comma)));
+            if (int mask = _mm_movemask_epi8(found); mask != 0) {
+                return from + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+            from += 16;
+        }
+#endif
+        const ByteSet& removed = lineRemoved();
+        while (from < to && !removed[static_cast<unsigned char>(*from)]) {
+            ++from;
+        }
+        return from;
+    }
+
+    /// Appends the bytes of [from, to) to out, leaving out the characters removed from a line.
+    static void appendLine(const char* from, const char* to, std::string& out) {
+        while (from < to) {
+            const char* removed = nextRemoved(from, to);
+            out.append(from, static_cast<size_t>(removed - from));
+            if (removed == to) {
+                break;
+            }
+            from = removed + 1;
+        }
+    }
+
+public:
+
+    /**
+     * @brief Formats JSON dumped with an indent for the text display.
+     * @param json JSON text with one value or key per line, as from json::dump with an indent.
+     * @param out Receives the text; its contents are replaced, and its capacity is kept for the next call.
+     */
+    static void format(std::string_view json, std::string& out) {
+        out.clear();
+        out.reserve(json.size() + 1);
+        const char* text = json.data();
+        const char* end = text + json.size();
+        bool lastBlank = false;
+        int16_t lastIndent = 0;
+        for (const char* line = text; line < end;) {
+            auto* lineEnd = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+            if (lineEnd == nullptr) {
+                lineEnd = end;
+            }
+            const char* first = line;
+            while (first < lineEnd && *first == ' ') {
+                ++first;
+            }
+            bool isBlank = first < lineEnd && (*first == '{' || *first == '}' || *first == ']');
+            if (!isBlank) {
+                auto indent = static_cast<int16_t>(first - line);
+                if (lastBlank && lastIndent == indent) {
+                    // blank line between each entity in a list
+                    out += '\n';
+                }
+                lastIndent = indent;
+                appendLine(line, lineEnd, out);
+                out += '\n';
+            }
+            lastBlank = isBlank;
+            if (lineEnd == end) {
+                break;
+            }
+            line = lineEnd + 1;
+        }
+    }
+
+    /**
+     * @brief Formats JSON for the text display in place.
+     *
+     * The output goes to a buffer kept by the thread, which is then swapped with text, so
+     * repeated calls reuse the same two buffers.
+     * @param text JSON dumped with an indent; replaced by the text display.
+     * @return text.
+     */
+    static std::string& format(std::string& text) {
+        thread_local std::string buffer;
+        format(std::string_view(text), buffer);
+        text.swap(buffer);
+        return text;
+    }
+
+    /**
+     * @brief Removes every [, ], {, }, " and , from text in place, as the config text display does.
+     * @return text.
+     */
+    static std::string& stripJson(std::string& text) {
+        const ByteSet& removed = stripRemoved();
+        size_t kept = 0;
+        for (char c : text) {
+            text[kept] = c;
+            kept += removed[static_cast<unsigned char>(c)] ? 0 : 1;
+        }
+        text.resize(kept);
+        return text;
+    }
+};
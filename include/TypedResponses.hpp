@@ -0,0 +1,589 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "nlohmann/json.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @struct StatusResponse
+ * @brief Response from /tempo/status.
+ */
+struct StatusResponse {
+    std::optional<std::string> status;             ///< Instrument status, e.g. idle or running.
+    std::optional<int64_t> stepNumber;             ///< Step being run.
+    std::optional<int64_t> currentRepeat;          ///< Repeat of the current step.
+    std::optional<int64_t> totalRepeat;            ///< Number of repeats of the current step.
+    std::optional<int64_t> protocolTimeRemaining;  ///< Seconds until the run ends.
+    json extra;                                    ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct LidResponse
+ * @brief Response from /tempo/lid and from the lid open and close requests.
+ */
+struct LidResponse {
+    std::optional<std::string> lid;     ///< Lid status, e.g. opened, opening or closedWithPlate.
+    std::optional<std::string> status;  ///< Instrument status.
+    std::optional<std::string> time;    ///< Instrument time of the response.
+    json extra;                         ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct RunStep
+ * @brief The "step" object of a protocol run.
+ */
+struct RunStep {
+    std::optional<int64_t> stepNumber;     ///< Step being run.
+    std::optional<int64_t> numberOfSteps;  ///< Number of steps in the protocol.
+    std::optional<int64_t> currentRepeat;  ///< Repeat of the current step.
+    std::optional<int64_t> totalRepeat;    ///< Number of repeats of the current step.
+    std::optional<std::string> stepState;  ///< State of the step, e.g. lidPreheat.
+    std::optional<int64_t> stepTime;       ///< Seconds into the step.
+    json extra;                            ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct RunTemperature
+ * @brief The "temperature" object of a protocol run.
+ */
+struct RunTemperature {
+    std::optional<double> currentBlockTemp;   ///< Block temperature in degrees C.
+    std::optional<double> currentLidTemp;     ///< Lid temperature in degrees C.
+    std::optional<double> currentSampleTemp;  ///< Calculated sample temperature in degrees C.
+    json extra;                               ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct RunTime
+ * @brief The "time" object of a protocol run, in seconds.
+ */
+struct RunTime {
+    std::optional<int64_t> elapsed;         ///< Time since the run started.
+    std::optional<int64_t> hold;            ///< Time in the current hold.
+    std::optional<int64_t> remaining;       ///< Time left in the current step.
+    std::optional<int64_t> totalRemaining;  ///< Time left in the run.
+    json extra;                             ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct ProtocolRun
+ * @brief The "protocolRun" object of /tempo/protocol-run while a run is active.
+ */
+struct ProtocolRun {
+    std::optional<int64_t> block;               ///< Block number.
+    std::optional<int64_t> lidTemp;             ///< Lid temperature setting.
+    std::optional<int64_t> volume;              ///< Sample volume.
+    std::optional<std::string> plateID;         ///< Plate ID of the run.
+    std::optional<std::string> protocolName;    ///< Name of the protocol.
+    std::optional<std::string> runName;         ///< Name of the run.
+    std::optional<RunStep> step;                ///< Current step.
+    std::optional<RunTemperature> temperature;  ///< Current temperatures.
+    std::optional<RunTime> time;                ///< Run timing.
+    json extra;                                 ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct RunResponse
+ * @brief Response from /tempo/protocol-run.
+ */
+struct RunResponse {
+    std::optional<std::string> lid;             ///< Lid status.
+    std::optional<std::string> status;          ///< Run status, e.g. running or paused.
+    std::optional<std::string> time;            ///< Instrument time of the response.
+    std::optional<ProtocolRun> protocolRun;     ///< Active run, if any.
+    json extra;                                 ///< Fields not listed above; null if there are none.
+};
+
+/**
+ * @struct Decoder
+ * @brief Maps the keys of a response to the fields of its struct.
+ *
+ * Each specialization has field, which returns the slot for a key, and encode, which writes the
+ * fields that are set back into a JSON object. Keys without a slot go to the extra fields.
+ */
+template<typename T>
+struct Decoder;
+
+/**
+ * @struct FieldSlot
+ * @brief Where the value of one key of an object goes while decoding.
+ *
+ * A slot points at an optional field of a typed struct. For a nested object, it also holds the
+ * functions of that struct's Decoder, so the decoder can descend without knowing the type.
+ */
+struct FieldSlot {
+    /// Kind of value the field holds.
+    enum class Kind { none, text, integer, number, object } kind = Kind::none;
+    /// The std::optional field.
+    void* target = nullptr;
+    /// For objects: sets the optional field to an empty struct and returns a pointer to it.
+    void* (*open)(void*) = nullptr;
+    /// For objects: finds the slot for a key of the nested struct.
+    FieldSlot (*field)(void*, std::string_view) = nullptr;
+    /// For objects: returns the extra fields of the nested struct.
+    json& (*extra)(void*) = nullptr;
+
+    static FieldSlot of(std::optional<std::string>& value) {
+        return FieldSlot{Kind::text, &value};
+    }
+
+    static FieldSlot of(std::optional<int64_t>& value) {
+        return FieldSlot{Kind::integer, &value};
+    }
+
+    static FieldSlot of(std::optional<double>& value) {
+        return FieldSlot{Kind::number, &value};
+    }
+
+    template<typename T>
+    static FieldSlot of(std::optional<T>& value) {
+        return FieldSlot{Kind::object, &value,
+                         [](void* target) -> void* { return &static_cast<std::optional<T>*>(target)->emplace(); },
+                         [](void* object, std::string_view key) { return Decoder<T>::field(*static_cast<T*>(object), key); },
+                         [](void* object) -> json& { return static_cast<T*>(object)->extra; }};
+    }
+};
+
+template<>
+struct Decoder<StatusResponse> {
+    static FieldSlot field(StatusResponse& value, std::string_view key) {
+        if (key == "status") {
+            return FieldSlot::of(value.status);
+        }
+        if (key == "stepNumber") {
+            return FieldSlot::of(value.stepNumber);
+        }
+        if (key == "currentRepeat") {
+            return FieldSlot::of(value.currentRepeat);
+        }
+        if (key == "totalRepeat") {
+            return FieldSlot::of(value.totalRepeat);
+        }
+        if (key == "protocolTimeRemaining") {
+            return FieldSlot::of(value.protocolTimeRemaining);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const StatusResponse& value, Put put) {
+        put("status", value.status);
+        put("stepNumber", value.stepNumber);
+        put("currentRepeat", value.currentRepeat);
+        put("totalRepeat", value.totalRepeat);
+        put("protocolTimeRemaining", value.protocolTimeRemaining);
+    }
+};
+
+template<>
+struct Decoder<LidResponse> {
+    static FieldSlot field(LidResponse& value, std::string_view key) {
+        if (key == "lid") {
+            return FieldSlot::of(value.lid);
+        }
+        if (key == "status") {
+            return FieldSlot::of(value.status);
+        }
+        if (key == "time") {
+            return FieldSlot::of(value.time);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const LidResponse& value, Put put) {
+        put("lid", value.lid);
+        put("status", value.status);
+        put("time", value.time);
+    }
+};
+
+template<>
+struct Decoder<RunStep> {
+    static FieldSlot field(RunStep& value, std::string_view key) {
+        if (key == "stepNumber") {
+            return FieldSlot::of(value.stepNumber);
+        }
+        if (key == "numberOfSteps") {
+            return FieldSlot::of(value.numberOfSteps);
+        }
+        if (key == "currentRepeat") {
+            return FieldSlot::of(value.currentRepeat);
+        }
+        if (key == "totalRepeat") {
+            return FieldSlot::of(value.totalRepeat);
+        }
+        if (key == "stepState") {
+            return FieldSlot::of(value.stepState);
+        }
+        if (key == "stepTime") {
+            return FieldSlot::of(value.stepTime);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const RunStep& value, Put put) {
+        put("stepNumber", value.stepNumber);
+        put("numberOfSteps", value.numberOfSteps);
+        put("currentRepeat", value.currentRepeat);
+        put("totalRepeat", value.totalRepeat);
+        put("stepState", value.stepState);
+        put("stepTime", value.stepTime);
+    }
+};
+
+template<>
+struct Decoder<RunTemperature> {
+    static FieldSlot field(RunTemperature& value, std::string_view key) {
+        if (key == "currentBlockTemp") {
+            return FieldSlot::of(value.currentBlockTemp);
+        }
+        if (key == "currentLidTemp") {
+            return FieldSlot::of(value.currentLidTemp);
+        }
+        if (key == "currentSampleTemp") {
+            return FieldSlot::of(value.currentSampleTemp);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const RunTemperature& value, Put put) {
+        put("currentBlockTemp", value.currentBlockTemp);
+        put("currentLidTemp", value.currentLidTemp);
+        put("currentSampleTemp", value.currentSampleTemp);
+    }
+};
+
+template<>
+struct Decoder<RunTime> {
+    static FieldSlot field(RunTime& value, std::string_view key) {
+        if (key == "elapsed") {
+            return FieldSlot::of(value.elapsed);
+        }
+        if (key == "hold") {
+            return FieldSlot::of(value.hold);
+        }
+        if (key == "remaining") {
+            return FieldSlot::of(value.remaining);
+        }
+        if (key == "totalRemaining") {
+            return FieldSlot::of(value.totalRemaining);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const RunTime& value, Put put) {
+        put("elapsed", value.elapsed);
+        put("hold", value.hold);
+        put("remaining", value.remaining);
+        put("totalRemaining", value.totalRemaining);
+    }
+};
+
+template<>
+struct Decoder<ProtocolRun> {
+    static FieldSlot field(ProtocolRun& value, std::string_view key) {
+        if (key == "block") {
+            return FieldSlot::of(value.block);
+        }
+        if (key == "lidTemp") {
+            return FieldSlot::of(value.lidTemp);
+        }
+        if (key == "volume") {
+            return FieldSlot::of(value.volume);
+        }
+        if (key == "plateID") {
+            return FieldSlot::of(value.plateID);
+        }
+        if (key == "protocolName") {
+            return FieldSlot::of(value.protocolName);
+        }
+        if (key == "runName") {
+            return FieldSlot::of(value.runName);
+        }
+        if (key == "step") {
+            return FieldSlot::of(value.step);
+        }
+        if (key == "temperature") {
+            return FieldSlot::of(value.temperature);
+        }
+        if (key == "time") {
+            return FieldSlot::of(value.time);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const ProtocolRun& value, Put put) {
+        put("block", value.block);
+        put("lidTemp", value.lidTemp);
+        put("volume", value.volume);
+        put("plateID", value.plateID);
+        put("protocolName", value.protocolName);
+        put("runName", value.runName);
+        put("step", value.step);
+        put("temperature", value.temperature);
+        put("time", value.time);
+    }
+};
+
+template<>
+struct Decoder<RunResponse> {
+    static FieldSlot field(RunResponse& value, std::string_view key) {
+        if (key == "lid") {
+            return FieldSlot::of(value.lid);
+        }
+        if (key == "status") {
+            return FieldSlot::of(value.status);
+        }
+        if (key == "time") {
+            return FieldSlot::of(value.time);
+        }
+        if (key == "protocolRun") {
+            return FieldSlot::of(value.protocolRun);
+        }
+        return {};
+    }
+
+    template<typename Put>
+    static void encode(const RunResponse& value, Put put) {
+        put("lid", value.lid);
+        put("status", value.status);
+        put("time", value.time);
+        put("protocolRun", value.protocolRun);
+    }
+};
+
+/**
+ * @class TypedDecoder
+ * @brief Fills a typed response straight from the JSON tokens, without building a DOM.
+ *
+ * This is a SAX handler for json::sax_parse. Each known key is written into its field as the
+ * token arrives. Values of unknown keys, and values whose type does not match their field, are
+ * built into the extra fields of the enclosing struct, so they still reach the output. Only
+ * those values allocate JSON nodes.
+ */
+class TypedDecoder {
+
+    /**
+     * @struct Frame
+     * @brief One typed object being decoded.
+     */
+    struct Frame {
+        void* object;                                 ///< Struct being filled.
+        FieldSlot (*field)(void*, std::string_view);  ///< Finds the slot for a key.
+        json& (*extra)(void*);                        ///< Returns the extra fields.
+    };
+
+    /// Typed objects from the root down to the current one.
+    std::vector<Frame> frames;
+    /// Slot for the value after the last key.
+    FieldSlot slot;
+    /// Last key read.
+    std::string lastKey;
+    /// Objects and arrays of the unknown value being built, outermost first.
+    std::vector<json*> unknownStack;
+    /// Key for the next value inside the unknown value.
+    std::string unknownKey;
+    /// True until the root object starts.
+    bool atRoot = true;
+
+    /// Adds a value to the unknown value being built, or starts one in the current extra fields.
+    json* addUnknown(json&& value) {
+        if (unknownStack.empty()) {
+            json& extra = frames.back().extra(frames.back().object);
+            if (extra.is_null()) {
+                extra = json::object();
+            }
+            json& entry = extra[lastKey];
+            entry = std::move(value);
+            return &entry;
+        }
+        json* parent = unknownStack.back();
+        if (parent->is_array()) {
+            parent->push_back(std::move(value));
+            return &parent->back();
+        }
+        json& entry = (*parent)[unknownKey];
+        entry = std::move(value);
+        return &entry;
+    }
+
+    /// True while the current value belongs to an unknown value.
+    [[nodiscard]] bool inUnknown() const {
+        return !unknownStack.empty();
+    }
+
+    /// Stores a scalar in its field if the types match, otherwise in the extra fields. Integers also fill number fields.
+    template<typename Value>
+    bool scalar(Value value) {
+        if (atRoot) {
+            return false;
+        }
+        FieldSlot target = slot;
+        slot = {};
+        if (!inUnknown()) {
+            if constexpr (std::is_same_v<Value, std::string>) {
+                if (target.kind == FieldSlot::Kind::text) {
+                    *static_cast<std::optional<std::string>*>(target.target) = std::move(value);
+                    return true;
+                }
+            } else if constexpr (std::is_same_v<Value, double>) {
+                if (target.kind == FieldSlot::Kind::number) {
+                    *static_cast<std::optional<double>*>(target.target) = value;
+                    return true;
+                }
+            } else if constexpr (std::is_integral_v<Value> && !std::is_same_v<Value, bool>) {
+                if (target.kind == FieldSlot::Kind::integer) {
+                    *static_cast<std::optional<int64_t>*>(target.target) = static_cast<int64_t>(value);
+                    return true;
+                } else if (target.kind == FieldSlot::Kind::number) {
+                    *static_cast<std::optional<double>*>(target.target) = static_cast<double>(value);
+                    return true;
+                }
+            }
+        }
+        addUnknown(json(std::move(value)));
+        return true;
+    }
+
+public:
+
+    /// Starts decoding into a typed response.
+    template<typename T>
+    explicit TypedDecoder(T& value) {
+        frames.push_back(Frame{&value,
+                               [](void* object, std::string_view key) { return Decoder<T>::field(*static_cast<T*>(object), key); },
+                               [](void* object) -> json& { return static_cast<T*>(object)->extra; }});
+    }
+
+    bool null() {
+        return scalar(nullptr);
+    }
+
+    bool boolean(bool value) {
+        return scalar(value);
+    }
+
+    bool number_integer(json::number_integer_t value) {
+        return scalar(static_cast<int64_t>(value));
+    }
+
+    bool number_unsigned(json::number_unsigned_t value) {
+        return scalar(static_cast<uint64_t>(value));
+    }
+
+    bool number_float(json::number_float_t value, const json::string_t&) {
+        return scalar(static_cast<double>(value));
+    }
+
+    bool string(json::string_t& value) {
+        return scalar(std::move(value));
+    }
+
+    bool binary(json::binary_t&) {
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        if (atRoot) {
+            atRoot = false;
+            return true;
+        }
+        if (!inUnknown() && slot.kind == FieldSlot::Kind::object) {
+            frames.push_back(Frame{slot.open(slot.target), slot.field, slot.extra});
+        } else {
+            unknownStack.push_back(addUnknown(json::object()));
+        }
+        slot = {};
+        return true;
+    }
+
+    bool key(json::string_t& value) {
+        if (inUnknown()) {
+            unknownKey = value;
+        } else {
+            slot = frames.back().field(frames.back().object, value);
+            lastKey.swap(value);
+        }
+        return true;
+    }
+
+    bool end_object() {
+        if (inUnknown()) {
+            unknownStack.pop_back();
+        } else if (frames.size() > 1) {
+            frames.pop_back();
+        }
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (atRoot) {
+            return false;
+        }
+        unknownStack.push_back(addUnknown(json::array()));
+        slot = {};
+        return true;
+    }
+
+    bool end_array() {
+        unknownStack.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) {
+        return false;
+    }
+};
+
+/**
+ * @brief Decodes a response body into a typed response.
+ * @param body Response body.
+ * @param value Output parameter for the response.
+ * @return True if the body is a valid JSON object.
+ */
+template<typename T>
+bool decode(const std::string& body, T& value) {
+    value = T{};
+    TypedDecoder decoder(value);
+    return json::sax_parse(body, &decoder);
+}
+
+/**
+ * @brief Converts a typed response back to JSON, including the extra fields.
+ */
+template<typename T>
+json toJson(const T& value) {
+    json result = value.extra.is_null() ? json::object() : value.extra;
+    Decoder<T>::encode(value, [&result](const char* key, const auto& field) {
+        if (field) {
+            if constexpr (std::is_class_v<std::decay_t<decltype(*field)>> && !std::is_same_v<std::decay_t<decltype(*field)>, std::string>) {
+                result[key] = toJson(*field);
+            } else {
+                result[key] = *field;
+            }
+        }
+    });
+    return result;
+}
@@ -0,0 +1,127 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkerPool
+ * @brief Runs tasks on a fixed number of worker threads.
+ *
+ * The number of threads is set once in the constructor, so the number of concurrent calls to
+ * PTC Tempo never exceeds that bound no matter how many tasks are posted. Tasks are started in
+ * the order they are posted.
+ */
+class WorkerPool {
+
+    /// Worker threads that take tasks from the queue.
+    std::vector<std::thread> workers;
+    /// Tasks waiting for a worker.
+    std::deque<std::function<void()>> tasks;
+    /// Guards the task queue and the counters.
+    std::mutex mutex;
+    /// Signals workers that a task was posted or the pool is stopping.
+    std::condition_variable taskReady;
+    /// Signals waiters that all tasks have finished.
+    std::condition_variable allDone;
+    /// Number of tasks currently running on a worker.
+    size_t active = 0;
+    /// True once the destructor has been called.
+    bool stopping = false;
+
+    /// Loop run by every worker thread.
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex);
+                taskReady.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+                ++active;
+            }
+            task();
+            {
+                std::scoped_lock lock(mutex);
+                --active;
+                if (active == 0 && tasks.empty()) {
+                    allDone.notify_all();
+                }
+            }
+        }
+    }
+
+public:
+
+    /**
+     * @brief Starts the worker threads.
+     * @param threads Maximum number of tasks that run at the same time. Values less than 1 are treated as 1.
+     */
+    explicit WorkerPool(size_t threads) {
+        threads = threads < 1 ? 1 : threads;
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Finishes all posted tasks, then stops the worker threads.
+     */
+    ~WorkerPool() {
+        {
+            std::scoped_lock lock(mutex);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Queues a task for the next free worker.
+     *
+     * Tasks must not throw; catch exceptions inside the task and store the error with its result.
+     * @param task Function to run on a worker thread.
+     */
+    void post(std::function<void()> task) {
+        {
+            std::scoped_lock lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        taskReady.notify_one();
+    }
+
+    /**
+     * @brief Blocks until every posted task has finished.
+     */
+    void wait() {
+        std::unique_lock lock(mutex);
+        allDone.wait(lock, [this]() { return active == 0 && tasks.empty(); });
+    }
+
+    /// Returns the number of worker threads.
+    [[nodiscard]] size_t size() const {
+        return workers.size();
+    }
+};
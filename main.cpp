@@ -15,6 +15,9 @@
 /**
  * @brief Main function creates the Router object and runs it.
  *
+ * On Linux and macOS, if a daemon is listening on the socket, the command is sent to it instead
+ * and its output and exit code are passed on.
+ *
  * @par Exceptions
  * To prevent exceptions from unwinding the stack and crashing the client app, the main
  * function catches all exceptions. It emits a message to stderr and exits.
@@ -22,13 +25,19 @@
  * @return 0 for success, 1 for failure, anything greater than 1 is an HTTP status code.
  */
 int main(int argc, char **argv) {
-    int success = false;
+    int exitCode = 1;
     try {
+#ifndef WIN32
+        std::vector<std::string> args(argv + 1, argv + argc);
+        if (Daemon::forward(Daemon::socketPath(args), args, exitCode)) {
+            return exitCode;
+        }
+#endif
         Router router;
         router.initialize();
 
         CLI11_PARSE(router.tempoCli(), argc, argv)
-        success = router.route();
+        exitCode = router.run();
 
     } catch (std::invalid_argument const& ex) {
         std::cerr << std::endl << std::endl << "Exception: " << ex.what() << std::endl << std::endl;
@@ -36,5 +45,5 @@ int main(int argc, char **argv) {
         std::exception_ptr p = std::current_exception();
         std::cerr << std::endl << std::endl << "Exception: " << (p ? typeid(p).name() : "null") << std::endl << std::endl;
     }
-    return success ? 0 : 1;
+    return exitCode;
 }
@@ -0,0 +1,735 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using nlohmann::json;
+
+/**
+ * @class SimulatedInstrument
+ * @brief State of a simulated PTC Tempo: the lid, protocol runs, faults and run reports.
+ *
+ * The state moves forward in simulated time, which the clock function gives in seconds. Each
+ * call first brings the state up to the clock in steps of a tenth of a second, so between
+ * requests nothing runs.
+ * - The lid takes 8 seconds to open or close. It cannot move during a run.
+ * - A run first closes the lid if it is open, then heats the lid to its temperature
+ *   (lidPreheat), then ramps the block to each step's temperature and holds it there. GOTO steps
+ *   repeat the steps between their target and themselves. The sample follows the block with a
+ *   lag of a few seconds.
+ * - Pause holds the run where it is; skip moves to the next step; stop ends the run.
+ * - Faults are added at a random rate while running, or on request. An abort fault ends the run,
+ *   and the status stays error until the faults are cleared.
+ * - The report list, most recent first, starts with the synthetic reports, and every run that
+ *   ends adds one. A synthetic report's samples are made from its ID when it is requested.
+ *
+ * Times in responses are the wall clock at start plus the simulated time.
+ *
+ * Every method is thread safe. Random choices come from a seeded generator, so a simulation
+ * with the same seed and the same requests is the same.
+ */
+class SimulatedInstrument {
+
+public:
+
+    /**
+     * @struct Step
+     * @brief Protocol step: either a temperature held for a time, or a GOTO that repeats steps.
+     */
+    struct Step {
+        double temperature = 0;  ///< Block temperature in degrees C.
+        double hold = 0;         ///< Seconds at temperature.
+        size_t gotoStep = 0;     ///< For a GOTO, the step number to go back to; 0 for a temperature step.
+        int64_t repeats = 0;     ///< For a GOTO, the number of times the steps are repeated.
+    };
+
+    /**
+     * @struct Protocol
+     * @brief Protocol that can be run.
+     */
+    struct Protocol {
+        std::string name;          ///< Protocol name.
+        std::string location;      ///< user, public or templates.
+        std::string lastModified;  ///< Time the protocol was saved.
+        int64_t lidTemp = 105;     ///< Lid temperature in degrees C.
+        int64_t volume = 20;       ///< Sample volume in microliters.
+        std::vector<Step> steps;   ///< Steps, run in order.
+    };
+
+    /**
+     * @struct Reply
+     * @brief HTTP status and body of a response.
+     */
+    struct Reply {
+        int status = 200;       ///< HTTP status.
+        json body;              ///< Response body.
+    };
+
+    /// Degrees C the block ramps by each second when heating.
+    static constexpr double heatRate = 4.0;
+    /// Degrees C the block ramps by each second when cooling.
+    static constexpr double coolRate = 2.5;
+    /// Degrees C the lid heats by each second.
+    static constexpr double lidRate = 1.5;
+    /// Seconds for the sample to close most of the gap to the block.
+    static constexpr double sampleLag = 3.0;
+    /// Temperature of the room in degrees C.
+    static constexpr double ambient = 25.0;
+    /// Seconds the lid takes to open or close.
+    static constexpr double lidTravel = 8.0;
+    /// Seconds in each step of the simulation.
+    static constexpr double tick = 0.1;
+
+private:
+
+    /**
+     * @struct Run
+     * @brief Protocol run in progress.
+     */
+    struct Run {
+        Protocol protocol;                ///< Protocol being run.
+        std::string runName;              ///< Name of the run.
+        std::string plateID;              ///< Plate ID of the run.
+        int64_t lidTemp = 0;              ///< Lid temperature in degrees C.
+        int64_t volume = 0;               ///< Sample volume.
+        std::string startTime;            ///< Wall clock time the run started.
+        size_t step = 0;                  ///< Index of the current step.
+        std::vector<int64_t> loopsLeft;   ///< Repeats left for each GOTO step.
+        std::string stepState = "lidPreheat"; ///< lidPreheat, ramp or hold.
+        double stepTime = 0;              ///< Seconds in the current step.
+        double held = 0;                  ///< Seconds held at the step temperature.
+        double elapsed = 0;               ///< Seconds since the run started, not counting pauses.
+        bool paused = false;              ///< True while paused.
+        json samples = json::array();     ///< One temperature sample per second of the run.
+    };
+
+    /// Returns the simulated time in seconds.
+    std::function<double()> clock;
+    /// Simulated time the state was last brought up to.
+    double now = 0;
+    /// Wall clock time at start.
+    std::time_t startTime = std::time(nullptr);
+    /// Guards everything below.
+    mutable std::mutex mutex;
+    /// Random choices, from the seed.
+    std::mt19937_64 random;
+    /// Abort faults added per hour of running.
+    double faultRate;
+
+    std::string lid = "closed";       ///< Lid state.
+    double lidMoveEnd = 0;            ///< Simulated time the lid stops moving.
+    double blockTemp = ambient;       ///< Block temperature.
+    double sampleTemp = ambient;      ///< Sample temperature.
+    double lidTemp = ambient;         ///< Lid temperature.
+    bool faulted = false;             ///< True after an abort fault until faults are cleared.
+    std::optional<Run> run;           ///< Run in progress.
+    json cyclerFaults = json::array(); ///< Current thermal cycler faults.
+    json lidFaults = json::array();   ///< Current lid faults.
+
+    std::vector<Protocol> protocols;  ///< Protocols that can be run.
+    std::vector<json> summaries;      ///< Report list entries, oldest first.
+    std::map<std::string, json> reports; ///< Full reports of the runs made in the simulation, by ID.
+    std::unordered_map<std::string, size_t> synthetic; ///< Index in summaries of each synthetic report, by ID.
+    std::vector<int64_t> durations;   ///< Seconds of each synthetic run, by index in summaries.
+
+    /// Returns a wall clock time as used in responses.
+    static std::string timestamp(std::time_t time) {
+        std::tm parts{};
+#ifdef _WIN32
+        gmtime_s(&parts, &time);
+#else
+        gmtime_r(&time, &parts);
+#endif
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S+00:00", &parts);
+        return text;
+    }
+
+    /// Returns the instrument's clock as used in responses: the wall clock at start plus the simulated time.
+    [[nodiscard]] std::string timestamp() const {
+        return timestamp(startTime + static_cast<std::time_t>(now));
+    }
+
+    /// Returns a random ID in the form of a version 4 UUID.
+    std::string uuid() {
+        char id[40];
+        std::snprintf(id, sizeof(id), "%08llx-%04llx-4%03llx-8%03llx-%012llx",
+                      static_cast<unsigned long long>(random() & 0xffffffffULL),
+                      static_cast<unsigned long long>(random() & 0xffffULL),
+                      static_cast<unsigned long long>(random() & 0xfffULL),
+                      static_cast<unsigned long long>(random() & 0xfffULL),
+                      static_cast<unsigned long long>(random() & 0xffffffffffffULL));
+        return id;
+    }
+
+    /// Returns the protocols present at start.
+    static std::vector<Protocol> defaultProtocols() {
+        Protocol shortRun{"STD2-short", "user", "2023-03-18T15:59:51", 90, 17,
+                          {{95, 30}, {95, 10}, {60, 30}, {0, 0, 2, 2}, {72, 60}, {12, 10}}};
+        Protocol longRun{"NESTPR2-fast-long", "user", "2023-04-07T07:28:02", 105, 20,
+                         {{95, 120}, {95, 15}, {55, 30}, {72, 45}, {0, 0, 2, 34}, {72, 300}, {4, 30}}};
+        Protocol publicRun{"PCR-2step", "public", "2023-01-10T09:12:40", 105, 25,
+                           {{95, 180}, {95, 10}, {60, 30}, {0, 0, 2, 39}, {4, 30}}};
+        Protocol templateRun{"Template-3step", "templates", "2022-11-02T14:01:19", 105, 20,
+                             {{98, 30}, {98, 10}, {58, 20}, {72, 30}, {0, 0, 2, 29}, {72, 120}}};
+        return {shortRun, longRun, publicRun, templateRun};
+    }
+
+    /// Returns the index of the GOTO whose loop holds a step, or the number of steps if none does.
+    static size_t loopOf(const Protocol& protocol, size_t step) {
+        for (size_t i = step + 1; i < protocol.steps.size(); ++i) {
+            const Step& candidate = protocol.steps[i];
+            if (candidate.gotoStep > 0 && candidate.gotoStep - 1 <= step) {
+                return i;
+            }
+        }
+        return protocol.steps.size();
+    }
+
+    /// Returns an estimate of the seconds to ramp from one temperature to another.
+    static double rampTime(double from, double to) {
+        return to > from ? (to - from) / heatRate : (from - to) / coolRate;
+    }
+
+    /// Moves past GOTO steps from index, repeating loops as they say; returns the next temperature step.
+    static size_t nextTemperatureStep(const Protocol& protocol, size_t index, std::vector<int64_t>& loopsLeft) {
+        while (index < protocol.steps.size() && protocol.steps[index].gotoStep > 0) {
+            if (loopsLeft[index] > 0) {
+                --loopsLeft[index];
+                index = protocol.steps[index].gotoStep - 1;
+            } else {
+                // the loop may be entered again by an outer loop
+                loopsLeft[index] = protocol.steps[index].repeats;
+                ++index;
+            }
+        }
+        return index;
+    }
+
+    /// Returns the estimated seconds left in the run.
+    [[nodiscard]] double remaining() const {
+        const Protocol& protocol = run->protocol;
+        double seconds = 0;
+        double temperature = blockTemp;
+        if (run->stepState == "lidPreheat") {
+            seconds += std::max(0.0, static_cast<double>(run->lidTemp) - lidTemp) / lidRate;
+        }
+        const Step& current = protocol.steps[run->step];
+        seconds += rampTime(temperature, current.temperature) + std::max(0.0, current.hold - run->held);
+        temperature = current.temperature;
+        std::vector<int64_t> loopsLeft = run->loopsLeft;
+        for (size_t index = nextTemperatureStep(protocol, run->step + 1, loopsLeft); index < protocol.steps.size();
+             index = nextTemperatureStep(protocol, index + 1, loopsLeft)) {
+            const Step& step = protocol.steps[index];
+            seconds += rampTime(temperature, step.temperature) + step.hold;
+            temperature = step.temperature;
+        }
+        return seconds;
+    }
+
+    /// Returns a fault for the cycler or the lid with the time it happened.
+    json fault(bool cycler) {
+        static const std::vector<std::pair<int64_t, const char*>> cyclerCatalog = {
+                {301, "Left heatsink over temperature error"},
+                {311, "Low ramp temperature error"},
+                {322, "Block sensor out of range"}};
+        static const std::vector<std::pair<int64_t, const char*>> lidCatalog = {
+                {1015, "Hinge motor close switch not activated at engage position"},
+                {1021, "Lid heater over temperature error"}};
+        const auto& catalog = cycler ? cyclerCatalog : lidCatalog;
+        const auto& [number, description] = catalog[random() % catalog.size()];
+        return {{"block", 0}, {"description", description}, {"info", 0}, {"number", number},
+                {"severity", "abort"}, {"timestamp", timestamp()}};
+    }
+
+    /// Ends the run and adds its report.
+    void finish(const std::string& result) {
+        json summary;
+        summary["id"] = uuid();
+        summary["runName"] = run->runName;
+        summary["plateID"] = run->plateID;
+        summary["protocolName"] = run->protocol.name;
+        summary["status"] = result;
+        summary["startTime"] = run->startTime;
+        summary["endTime"] = timestamp();
+        summary["user"] = "Automation";
+        json report = summary;
+        report["lidTemp"] = run->lidTemp;
+        report["volume"] = run->volume;
+        report["steps"] = stepsJson(run->protocol);
+        report["temperatures"] = std::move(run->samples);
+        reports[summary["id"].get<std::string>()] = std::move(report);
+        summaries.push_back(std::move(summary));
+        run.reset();
+    }
+
+    /// Returns the steps of a protocol as in a report.
+    static json stepsJson(const Protocol& protocol) {
+        json steps = json::array();
+        for (size_t i = 0; i < protocol.steps.size(); ++i) {
+            const Step& step = protocol.steps[i];
+            if (step.gotoStep > 0) {
+                steps.push_back({{"stepNumber", i + 1}, {"gotoStep", step.gotoStep}, {"repeats", step.repeats}});
+            } else {
+                steps.push_back({{"stepNumber", i + 1}, {"temperature", step.temperature}, {"hold", step.hold}});
+            }
+        }
+        return steps;
+    }
+
+    /// Moves the run to its next step, or ends it after the last.
+    void nextStep() {
+        size_t index = nextTemperatureStep(run->protocol, run->step + 1, run->loopsLeft);
+        if (index >= run->protocol.steps.size()) {
+            finish("completed");
+            return;
+        }
+        run->step = index;
+        run->stepState = "ramp";
+        run->stepTime = 0;
+        run->held = 0;
+    }
+
+    /// Moves the simulation forward by seconds.
+    void advance(double seconds) {
+        if (lid == "opening" || lid == "closing") {
+            if (now >= lidMoveEnd) {
+                lid = lid == "opening" ? "opened" : "closedWithPlate";
+            }
+        }
+        double target = ambient;
+        double lidTarget = ambient;
+        if (run && !run->paused && lid != "closing") {
+            const Step& step = run->protocol.steps[run->step];
+            lidTarget = static_cast<double>(run->lidTemp);
+            if (run->stepState == "lidPreheat") {
+                target = blockTemp;
+                if (lidTemp >= lidTarget - 0.5) {
+                    run->stepState = "ramp";
+                }
+            } else {
+                target = step.temperature;
+                if (run->stepState == "ramp" && std::abs(blockTemp - target) < 0.2) {
+                    run->stepState = "hold";
+                }
+                if (run->stepState == "hold") {
+                    run->held += seconds;
+                }
+            }
+            run->stepTime += seconds;
+            double before = run->elapsed;
+            run->elapsed += seconds;
+            if (std::floor(run->elapsed) > std::floor(before) || run->samples.empty()) {
+                run->samples.push_back({{"elapsed", static_cast<int64_t>(run->elapsed)},
+                                        {"blockTemp", std::round(blockTemp * 10) / 10},
+                                        {"sampleTemp", std::round(sampleTemp * 10) / 10}});
+            }
+            if (faultRate > 0 && std::uniform_real_distribution<double>(0, 1)(random) < faultRate * seconds / 3600) {
+                bool cycler = random() % 3 != 0;
+                (cycler ? cyclerFaults : lidFaults).push_back(fault(cycler));
+                faulted = true;
+                finish("aborted");
+                return;
+            }
+            if (run->stepState == "hold" && run->held >= step.hold) {
+                nextStep();
+            }
+        } else if (run) {
+            // paused or waiting for the lid: the block holds its temperature
+            target = blockTemp;
+            lidTarget = run->paused ? static_cast<double>(run->lidTemp) : lidTemp;
+        }
+        double rate = target > blockTemp ? heatRate : coolRate;
+        blockTemp += std::clamp(target - blockTemp, -rate * seconds, rate * seconds);
+        lidTemp += std::clamp(lidTarget - lidTemp, -lidRate * seconds, lidRate * seconds);
+        sampleTemp += (blockTemp - sampleTemp) * std::min(1.0, seconds / sampleLag);
+    }
+
+    /// Brings the state up to the clock.
+    void update() {
+        double until = clock();
+        while (now < until) {
+            bool settled = !run && lid != "opening" && lid != "closing"
+                           && std::abs(blockTemp - ambient) < 0.01 && std::abs(lidTemp - ambient) < 0.01
+                           && std::abs(sampleTemp - ambient) < 0.01;
+            if (settled) {
+                // nothing changes while idle at room temperature
+                now = until;
+                break;
+            }
+            double seconds = std::min(tick, until - now);
+            now += seconds;
+            advance(seconds);
+        }
+    }
+
+    /// Returns the status the API reports.
+    [[nodiscard]] std::string status() const {
+        if (run) {
+            if (lid == "closing") {
+                return "closing";
+            }
+            return run->paused ? "paused" : "running";
+        }
+        if (faulted) {
+            return "error";
+        }
+        if (lid == "opening" || lid == "closing") {
+            return lid;
+        }
+        return "idle";
+    }
+
+    /// Returns an error reply.
+    static Reply error(int status, const std::string& message) {
+        return {status, json{{"error", message}}};
+    }
+
+    /// Returns a list entry for a synthetic report.
+    json syntheticSummary(size_t index, std::time_t start) {
+        const Protocol& protocol = protocols[random() % protocols.size()];
+        auto seconds = static_cast<int64_t>(600 + random() % 5400);
+        json summary;
+        summary["id"] = uuid();
+        summary["runName"] = "run" + protocol.name + std::to_string(index);
+        summary["plateID"] = "plate" + std::to_string(1000 + index);
+        summary["protocolName"] = protocol.name;
+        auto roll = random() % 100;
+        summary["status"] = roll < 90 ? "completed" : roll < 97 ? "stopped" : "aborted";
+        summary["startTime"] = timestamp(start);
+        summary["endTime"] = timestamp(start + static_cast<std::time_t>(seconds));
+        summary["user"] = "Automation";
+        durations.push_back(seconds);
+        return summary;
+    }
+
+public:
+
+    /**
+     * @brief Makes a simulated instrument at room temperature with the lid closed.
+     * @param clock_ Returns the simulated time in seconds; it must never go back.
+     * @param seed Seed of the random choices.
+     * @param reportCount Number of synthetic run reports.
+     * @param faultRate_ Abort faults added per hour of running; 0 for none.
+     */
+    SimulatedInstrument(std::function<double()> clock_, uint64_t seed, size_t reportCount, double faultRate_) :
+            clock(std::move(clock_)),
+            random(seed),
+            faultRate(faultRate_),
+            protocols(defaultProtocols()) {
+        now = clock();
+        // reports are a few hours apart, going back from now
+        std::time_t start = startTime;
+        summaries.reserve(reportCount);
+        durations.reserve(reportCount);
+        for (size_t i = 0; i < reportCount; ++i) {
+            start -= static_cast<std::time_t>(3600 + random() % 14400);
+            summaries.push_back(syntheticSummary(reportCount - i, start));
+        }
+        std::reverse(summaries.begin(), summaries.end());
+        std::reverse(durations.begin(), durations.end());
+        for (size_t i = 0; i < summaries.size(); ++i) {
+            synthetic[summaries[i]["id"].get<std::string>()] = i;
+        }
+    }
+
+    /// Returns the response to GET /tempo.
+    Reply device() {
+        std::scoped_lock lock(mutex);
+        update();
+        json body;
+        body["device"] = {{"details", {{"automationAPI", "1.0.0"}}}, {"instrumentName", "Simulator"},
+                          {"model", "PTCTempo384"}, {"serialNumber", "SIM00001"}, {"type", "PTCTempo"}, {"ver", "1.2.0"}};
+        body["lid"] = lid;
+        body["status"] = status();
+        body["time"] = timestamp();
+        return {200, body};
+    }
+
+    /// Returns the response to GET /tempo/status.
+    Reply statusReply() {
+        std::scoped_lock lock(mutex);
+        update();
+        json body;
+        body["status"] = status();
+        if (run) {
+            size_t loop = loopOf(run->protocol, run->step);
+            bool inLoop = loop < run->protocol.steps.size();
+            int64_t repeats = inLoop ? run->protocol.steps[loop].repeats : 0;
+            body["stepNumber"] = run->step + 1;
+            body["currentRepeat"] = inLoop ? repeats - run->loopsLeft[loop] + 1 : 1;
+            body["totalRepeat"] = inLoop ? repeats + 1 : 0;
+            body["protocolTimeRemaining"] = static_cast<int64_t>(std::ceil(remaining()));
+        }
+        return {200, body};
+    }
+
+    /// Returns the response to GET /tempo/lid.
+    Reply lidReply() {
+        std::scoped_lock lock(mutex);
+        update();
+        return {200, json{{"lid", lid}, {"status", status()}, {"time", timestamp()}}};
+    }
+
+    /// Returns the response to GET /tempo/protocol-run.
+    Reply runReply() {
+        std::scoped_lock lock(mutex);
+        update();
+        json body{{"lid", lid}, {"status", status()}, {"time", timestamp()}};
+        if (!run || lid == "closing") {
+            return {200, body};
+        }
+        size_t loop = loopOf(run->protocol, run->step);
+        bool inLoop = loop < run->protocol.steps.size();
+        int64_t repeats = inLoop ? run->protocol.steps[loop].repeats : 0;
+        const Step& step = run->protocol.steps[run->step];
+        double totalRemaining = remaining();
+        json& protocolRun = body["protocolRun"];
+        protocolRun["block"] = 0;
+        protocolRun["lidTemp"] = run->lidTemp;
+        protocolRun["plateID"] = run->plateID;
+        protocolRun["protocolName"] = run->protocol.name;
+        protocolRun["runName"] = run->runName;
+        protocolRun["volume"] = run->volume;
+        protocolRun["step"] = {{"currentRepeat", inLoop ? repeats - run->loopsLeft[loop] + 1 : 1},
+                               {"numberOfSteps", run->protocol.steps.size()},
+                               {"stepNumber", run->step + 1},
+                               {"stepState", run->stepState},
+                               {"stepTime", static_cast<int64_t>(run->stepTime)},
+                               {"totalRepeat", inLoop ? repeats + 1 : 0}};
+        protocolRun["temperature"] = {{"currentBlockTemp", std::round(blockTemp * 10) / 10},
+                                      {"currentLidTemp", std::round(lidTemp * 10) / 10},
+                                      {"currentSampleTemp", std::round(sampleTemp * 10) / 10}};
+        double hold = run->stepState == "hold" ? std::max(0.0, step.hold - run->held) : step.hold;
+        protocolRun["time"] = {{"elapsed", static_cast<int64_t>(run->elapsed)},
+                               {"hold", static_cast<int64_t>(std::ceil(hold))},
+                               {"remaining", static_cast<int64_t>(std::ceil(hold + (run->stepState == "ramp"
+                                       ? rampTime(blockTemp, step.temperature) : 0)))},
+                               {"totalRemaining", static_cast<int64_t>(std::ceil(totalRemaining))}};
+        return {200, body};
+    }
+
+    /// Returns the response to GET /tempo/errors.
+    Reply faults() {
+        std::scoped_lock lock(mutex);
+        update();
+        return {200, json{{"cyclerFaultCount", cyclerFaults.size()}, {"cyclerFaults", cyclerFaults},
+                          {"lidFaultCount", lidFaults.size()}, {"lidFaults", lidFaults}}};
+    }
+
+    /// Clears the faults for PUT /tempo/errors/clear, which also ends the error status.
+    Reply clearFaults() {
+        std::scoped_lock lock(mutex);
+        update();
+        cyclerFaults = json::array();
+        lidFaults = json::array();
+        faulted = false;
+        return {200, json::object()};
+    }
+
+    /**
+     * @brief Adds a fault, as the simulator control API asks.
+     * @param cycler True for a thermal cycler fault, false for a lid fault.
+     * @param abort True to end the run in progress, if any, and set the error status.
+     */
+    Reply injectFault(bool cycler, bool abort) {
+        std::scoped_lock lock(mutex);
+        update();
+        json added = fault(cycler);
+        if (!abort) {
+            added["severity"] = "warning";
+        }
+        (cycler ? cyclerFaults : lidFaults).push_back(added);
+        if (abort) {
+            faulted = true;
+            if (run) {
+                finish("aborted");
+            }
+        }
+        return {200, added};
+    }
+
+    /// Opens or closes the lid for PUT /tempo/lid/open and /tempo/lid/close.
+    Reply moveLid(bool open) {
+        std::scoped_lock lock(mutex);
+        update();
+        if (run) {
+            return error(400, "The lid cannot move during a run.");
+        }
+        bool isOpen = lid == "opened" || lid == "opening";
+        if (open != isOpen) {
+            lid = open ? "opening" : "closing";
+            lidMoveEnd = now + lidTravel;
+        }
+        return {200, json{{"lid", lid}, {"status", status()}, {"time", timestamp()}}};
+    }
+
+    /// Returns the response to GET /tempo/protocols/<location>.
+    Reply protocolList(const std::string& location) {
+        std::scoped_lock lock(mutex);
+        json names = json::array();
+        for (const Protocol& protocol : protocols) {
+            if (protocol.location == location) {
+                names.push_back({{"lastModified", protocol.lastModified}, {"name", protocol.name}});
+            }
+        }
+        return {200, json{{"location", location == "user" ? "Automation" : location}, {"protocolNames", names}}};
+    }
+
+    /// Starts a run for POST /tempo/protocol-run.
+    Reply startRun(const json& request) {
+        std::scoped_lock lock(mutex);
+        update();
+        if (run) {
+            return error(400, "A protocol is already running.");
+        }
+        if (faulted) {
+            return error(400, "Clear the faults before starting a run.");
+        }
+        std::string name = request.value("protocolName", "");
+        std::string location = request.value("location", "user");
+        auto found = std::find_if(protocols.begin(), protocols.end(), [&](const Protocol& protocol) {
+            return protocol.name == name && protocol.location == location;
+        });
+        if (found == protocols.end()) {
+            return error(404, "No protocol " + name + " in " + location + ".");
+        }
+        Run started;
+        started.protocol = *found;
+        started.runName = request.value("runName", "run" + name);
+        started.plateID = request.value("plateID", "");
+        started.lidTemp = request.value("lidTemp", found->lidTemp);
+        started.volume = request.value("volume", found->volume);
+        started.startTime = timestamp();
+        for (const Step& step : found->steps) {
+            started.loopsLeft.push_back(step.repeats);
+        }
+        run = std::move(started);
+        json body{{"lid", lid}, {"lidTemp", run->lidTemp}, {"status", "running"}, {"steps", found->steps.size()},
+                  {"time", timestamp()}, {"volume", run->volume}};
+        if (lid != "closed" && lid != "closedWithPlate") {
+            lid = "closing";
+            lidMoveEnd = now + lidTravel;
+        }
+        return {200, body};
+    }
+
+    /**
+     * @brief Changes the run for PUT /tempo/protocol-run/<action>.
+     * @param action stop, skip, pause or resume.
+     */
+    Reply changeRun(const std::string& action) {
+        std::scoped_lock lock(mutex);
+        update();
+        if (!run) {
+            return error(400, "No protocol is running.");
+        }
+        if (action == "stop") {
+            finish("stopped");
+        } else if (action == "skip") {
+            nextStep();
+        } else if (action == "pause") {
+            if (run->paused) {
+                return error(400, "The run is already paused.");
+            }
+            run->paused = true;
+        } else if (action == "resume") {
+            if (!run->paused) {
+                return error(400, "The run is not paused.");
+            }
+            run->paused = false;
+        } else {
+            return error(404, "Unknown action " + action + ".");
+        }
+        return {200, json::object()};
+    }
+
+    /// Returns the number of run reports.
+    Reply reportCount() {
+        std::scoped_lock lock(mutex);
+        update();
+        return {200, json{{"count", summaries.size()}}};
+    }
+
+    /**
+     * @brief Returns the response to GET /tempo/run-reports.
+     * @param limit Number of reports, or 0 for all.
+     * @param offset Index of the first report.
+     */
+    Reply reportList(size_t limit, size_t offset) {
+        std::scoped_lock lock(mutex);
+        update();
+        offset = std::min(offset, summaries.size());
+        size_t end = limit == 0 ? summaries.size() : std::min(summaries.size(), offset + limit);
+        json list = json::array();
+        for (size_t i = offset; i < end; ++i) {
+            list.push_back(summaries[summaries.size() - 1 - i]);
+        }
+        return {200, json{{"reports", std::move(list)}}};
+    }
+
+    /// Returns the response to GET /tempo/run-reports/<id>.
+    Reply report(const std::string& id) {
+        std::scoped_lock lock(mutex);
+        update();
+        if (auto found = reports.find(id); found != reports.end()) {
+            return {200, found->second};
+        }
+        auto index = synthetic.find(id);
+        if (index == synthetic.end()) {
+            return error(404, "No run report " + id + ".");
+        }
+        json full = summaries[index->second];
+        int64_t seconds = durations[index->second];
+        auto protocol = std::find_if(protocols.begin(), protocols.end(), [&full](const Protocol& candidate) {
+            return candidate.name == full["protocolName"];
+        });
+        full["lidTemp"] = protocol->lidTemp;
+        full["volume"] = protocol->volume;
+        full["steps"] = stepsJson(*protocol);
+        // the same ID always gives the same samples
+        std::mt19937 samplesRandom(static_cast<uint32_t>(std::hash<std::string>()(id)));
+        json samples = json::array();
+        for (int64_t second = 0; second < seconds; second += 10) {
+            double block = 60 + 35 * std::sin(static_cast<double>(second) / 60.0);
+            double noise = std::uniform_real_distribution<double>(-0.2, 0.2)(samplesRandom);
+            samples.push_back({{"elapsed", second}, {"blockTemp", std::round((block + noise) * 10) / 10},
+                               {"sampleTemp", std::round((block - 0.8 + noise) * 10) / 10}});
+        }
+        full["temperatures"] = std::move(samples);
+        return {200, full};
+    }
+
+    /// Returns the state for the simulator control API: status, lid, temperatures and counts.
+    json state() {
+        std::scoped_lock lock(mutex);
+        update();
+        return {{"status", status()}, {"lid", lid}, {"simulatedSeconds", now},
+                {"blockTemp", std::round(blockTemp * 10) / 10}, {"lidTemp", std::round(lidTemp * 10) / 10},
+                {"sampleTemp", std::round(sampleTemp * 10) / 10}, {"reports", summaries.size()},
+                {"faults", cyclerFaults.size() + lidFaults.size()}};
+    }
+};
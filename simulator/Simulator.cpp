@@ -0,0 +1,264 @@
+//
+// PTC Tempo Automation API sample client
+//
+// Copyright © 2023 Bio-Rad Laboratories Inc. All rights Reserved
+//
+// MIT License
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "SimulatedInstrument.hpp"
+#include "CLI/CLI.hpp"
+#include "httplib.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+/**
+ * @struct SimulatorSettings
+ * @brief Command line options of the simulator.
+ */
+struct SimulatorSettings {
+    std::string address = "127.0.0.1";  ///< Address to listen on.
+    int port = 8080;                     ///< Port to listen on.
+    std::string password = "password";  ///< Password of the Automation user; empty to accept any request.
+    size_t reports = 5000;               ///< Number of synthetic run reports.
+    int64_t latency = 0;                 ///< Milliseconds added to every response.
+    int64_t jitter = 0;                  ///< Most random milliseconds added to the latency.
+    double errorRate = 0;                ///< Fraction of requests answered with HTTP 503.
+    double timeoutRate = 0;              ///< Fraction of requests held for the stall time before the answer.
+    int64_t stall = 35000;               ///< Milliseconds a stalled request is held.
+    double faultRate = 0;                ///< Abort faults per hour of running.
+    double speed = 1;                    ///< Simulated seconds per real second.
+    uint64_t seed = 1;                   ///< Seed of the random choices.
+    size_t threads = 64;                 ///< Server worker threads.
+};
+
+/// Set by the signal handler to stop the server.
+static std::atomic<bool> stopping{false};
+
+/// Returns text in base64, as in a Basic authorization header.
+static std::string base64(const std::string& text) {
+    static const char* digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    size_t i = 0;
+    for (; i + 2 < text.size(); i += 3) {
+        auto bits = static_cast<uint32_t>(static_cast<unsigned char>(text[i]) << 16
+                                          | static_cast<unsigned char>(text[i + 1]) << 8
+                                          | static_cast<unsigned char>(text[i + 2]));
+        encoded += digits[bits >> 18 & 63];
+        encoded += digits[bits >> 12 & 63];
+        encoded += digits[bits >> 6 & 63];
+        encoded += digits[bits & 63];
+    }
+    if (i + 1 == text.size()) {
+        auto bits = static_cast<uint32_t>(static_cast<unsigned char>(text[i]) << 16);
+        encoded += digits[bits >> 18 & 63];
+        encoded += digits[bits >> 12 & 63];
+        encoded += "==";
+    } else if (i + 2 == text.size()) {
+        auto bits = static_cast<uint32_t>(static_cast<unsigned char>(text[i]) << 16
+                                          | static_cast<unsigned char>(text[i + 1]) << 8);
+        encoded += digits[bits >> 18 & 63];
+        encoded += digits[bits >> 12 & 63];
+        encoded += digits[bits >> 6 & 63];
+        encoded += '=';
+    }
+    return encoded;
+}
+
+/// Sets the status and JSON body of a response.
+static void send(httplib::Response& res, const SimulatedInstrument::Reply& reply) {
+    res.status = reply.status;
+    res.set_content(reply.body.dump(), "application/json");
+}
+
+/// Returns a query parameter as a count, or 0 if it is missing or not a number.
+static size_t count(const httplib::Request& req, const std::string& name) {
+    if (!req.has_param(name)) {
+        return 0;
+    }
+    return static_cast<size_t>(std::strtoull(req.get_param_value(name).c_str(), nullptr, 10));
+}
+
+/**
+ * @brief Serves the Automation API from a SimulatedInstrument, so the client and the benchmarks
+ * can be run without an instrument.
+ *
+ * Every /tempo request goes through the same steps before it reaches the model: the Basic
+ * authorization of the Automation user is checked, the latency and a random part of the jitter
+ * are waited, and then a random fraction of requests is answered with 503 (--errorRate), or held
+ * for the stall time before being answered (--timeoutRate), which a client sees as a timeout
+ * when its wait time is shorter. The random choices come from --seed.
+ *
+ * --speed runs the simulated clock faster than the real one, so a 40 minute protocol can be run
+ * in under a minute.
+ *
+ * Two paths control the simulator itself and skip the steps above:
+ * - GET /simulator/state returns the model state and the request counts.
+ * - POST /simulator/faults adds a fault. The query parameters are source (cycler or lid) and
+ *   severity (abort or warning); an abort fault ends the run in progress.
+ */
+int main(int argc, char** argv) {
+    SimulatorSettings settings;
+    CLI::App app{"Simulates a PTC Tempo for the Automation API, with lid moves, protocol runs, faults and run reports."};
+    app.add_option("--address", settings.address, "Address to listen on.");
+    app.add_option("--port", settings.port, "Port to listen on.");
+    app.add_option("--password", settings.password, "Password of the Automation user. Empty to accept requests without authorization.");
+    app.add_option("--reports", settings.reports, "Number of synthetic run reports.");
+    app.add_option("--latency", settings.latency, "Milliseconds added to every response.")->check(CLI::Range(0, 600000));
+    app.add_option("--jitter", settings.jitter, "Most random milliseconds added to the latency.")->check(CLI::Range(0, 600000));
+    app.add_option("--errorRate", settings.errorRate, "Fraction of requests answered with HTTP 503.")->check(CLI::Range(0.0, 1.0));
+    app.add_option("--timeoutRate", settings.timeoutRate, "Fraction of requests held for the stall time.")->check(CLI::Range(0.0, 1.0));
+    app.add_option("--stall", settings.stall, "Milliseconds a stalled request is held.")->check(CLI::Range(0, 600000));
+    app.add_option("--faultRate", settings.faultRate, "Abort faults per hour of running.")->check(CLI::Range(0.0, 3600.0));
+    app.add_option("--speed", settings.speed, "Simulated seconds per real second.")->check(CLI::Range(0.01, 10000.0));
+    app.add_option("--seed", settings.seed, "Seed of the random choices.");
+    app.add_option("--threads", settings.threads, "Server worker threads.")->check(CLI::Range(1, 1024));
+    CLI11_PARSE(app, argc, argv)
+
+    auto start = std::chrono::steady_clock::now();
+    double speed = settings.speed;
+    SimulatedInstrument instrument([start, speed]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * speed;
+    }, settings.seed, settings.reports, settings.faultRate);
+
+    std::mutex randomMutex;
+    std::mt19937_64 random(settings.seed ^ 0x5deece66dULL);
+    std::atomic<int64_t> requests{0};
+    std::atomic<int64_t> unauthorized{0};
+    std::atomic<int64_t> errors{0};
+    std::atomic<int64_t> stalls{0};
+    const std::string authorization = "Basic " + base64("Automation:" + settings.password);
+
+    httplib::Server server;
+    size_t threads = settings.threads;
+    server.new_task_queue = [threads]() { return new httplib::ThreadPool(threads); };
+
+    server.set_pre_routing_handler([&](const httplib::Request& req, httplib::Response& res) {
+        if (req.path.rfind("/tempo", 0) != 0) {
+            return httplib::Server::HandlerResponse::Unhandled;
+        }
+        ++requests;
+        if (!settings.password.empty() && req.get_header_value("Authorization") != authorization) {
+            ++unauthorized;
+            send(res, {401, json{{"error", "Unauthorized."}}});
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        int64_t delay = settings.latency;
+        bool error = false;
+        bool stall = false;
+        {
+            std::scoped_lock lock(randomMutex);
+            std::uniform_real_distribution<double> fraction(0, 1);
+            if (settings.jitter > 0) {
+                delay += static_cast<int64_t>(random() % static_cast<uint64_t>(settings.jitter + 1));
+            }
+            error = fraction(random) < settings.errorRate;
+            stall = !error && fraction(random) < settings.timeoutRate;
+        }
+        if (stall) {
+            ++stalls;
+            delay += settings.stall;
+        }
+        if (delay > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+        }
+        if (error) {
+            ++errors;
+            send(res, {503, json{{"error", "Simulated error."}}});
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        return httplib::Server::HandlerResponse::Unhandled;
+    });
+
+    server.Get("/tempo", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.device());
+    });
+    server.Get("/tempo/status", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.statusReply());
+    });
+    server.Get("/tempo/lid", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.lidReply());
+    });
+    server.Put(R"(/tempo/lid/(open|close))", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        send(res, instrument.moveLid(req.matches[1].str() == "open"));
+    });
+    server.Get("/tempo/errors", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.faults());
+    });
+    server.Put("/tempo/errors/clear", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.clearFaults());
+    });
+    server.Get(R"(/tempo/protocols/(user|public|templates))", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        send(res, instrument.protocolList(req.matches[1].str()));
+    });
+    server.Get("/tempo/protocol-run", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.runReply());
+    });
+    server.Post("/tempo/protocol-run", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        json request = json::parse(req.body, nullptr, false);
+        if (!request.is_object()) {
+            send(res, {400, json{{"error", "The body is not a JSON object."}}});
+            return;
+        }
+        send(res, instrument.startRun(request));
+    });
+    server.Put(R"(/tempo/protocol-run/([a-z]+))", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        send(res, instrument.changeRun(req.matches[1].str()));
+    });
+    server.Get("/tempo/run-reports/count", [&instrument](const httplib::Request&, httplib::Response& res) {
+        send(res, instrument.reportCount());
+    });
+    server.Get(R"(/tempo/run-reports/([^/]+))", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        send(res, instrument.report(req.matches[1].str()));
+    });
+    server.Get("/tempo/run-reports", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        send(res, instrument.reportList(count(req, "limit"), count(req, "offset")));
+    });
+
+    server.Get("/simulator/state", [&](const httplib::Request&, httplib::Response& res) {
+        json state = instrument.state();
+        state["requests"] = requests.load();
+        state["unauthorized"] = unauthorized.load();
+        state["errors"] = errors.load();
+        state["stalls"] = stalls.load();
+        send(res, {200, state});
+    });
+    server.Post("/simulator/faults", [&instrument](const httplib::Request& req, httplib::Response& res) {
+        std::string source = req.has_param("source") ? req.get_param_value("source") : "cycler";
+        std::string severity = req.has_param("severity") ? req.get_param_value("severity") : "abort";
+        if ((source != "cycler" && source != "lid") || (severity != "abort" && severity != "warning")) {
+            send(res, {400, json{{"error", "The source is cycler or lid, and the severity is abort or warning."}}});
+            return;
+        }
+        send(res, instrument.injectFault(source == "cycler", severity == "abort"));
+    });
+
+    if (!server.bind_to_port(settings.address, settings.port)) {
+        std::cerr << "Error. Unable to listen on " << settings.address << ":" << settings.port << "." << std::endl;
+        return 1;
+    }
+    std::signal(SIGINT, [](int) { stopping = true; });
+    std::signal(SIGTERM, [](int) { stopping = true; });
+    std::thread thread([&server]() { server.listen_after_bind(); });
+    server.wait_until_ready();
+    std::cerr << "Simulating a PTC Tempo with " << settings.reports << " reports on http://" << settings.address
+              << ":" << settings.port << std::endl;
+    while (!stopping) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    server.stop();
+    thread.join();
+    std::cerr << "Answered " << requests.load() << " requests: " << errors.load() << " errors, " << stalls.load()
+              << " stalls, " << unauthorized.load() << " unauthorized" << std::endl;
+    return 0;
+}